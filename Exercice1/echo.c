@@ -36,6 +36,7 @@
 #include <std.h>
 
 #include <log.h>
+#include <mem.h>
 #include <pip.h>
 #include <swi.h>
 #include <sys.h>
@@ -43,26 +44,68 @@
 #include <iom.h>
 #include <pio.h>
 
+#include "prf.h"
+#include "blk.h"
+#include "lat.h"
+#include "pln.h"
+#include "cnv.h"
+#include "avg.h"
+
 #ifdef _6x_
 extern far LOG_Obj trace;
 extern far PIP_Obj pipRx; 
 extern far PIP_Obj pipTx;
 extern far SWI_Obj swiEcho;
+extern far Int IRAM;
+extern far Int SDRAM;
 #else
 extern LOG_Obj trace; 
 extern PIP_Obj pipRx;
 extern PIP_Obj pipTx;
 extern SWI_Obj swiEcho;
+extern Int IRAM;
+extern Int SDRAM;
 #endif
 
-#define LNGBUF 128  // longueur des buffers
 /*
 *  'pioRx' and 'pioTx' objects will be initialized by PIO_new(). 
 */
 PIO_Obj pioRx, pioTx;
 
-float BufIn[LNGBUF+6]; // buffer pour les entrees, 6 cases en plus pour stocker les valeurs precedentes
-float BufOut[LNGBUF]; // buffer pour la sortie
+PRF_Obj prfEcho; // mesure du temps pass dans chaque tape de echo()
+String etapes[] = { "parametres", "separation", "traitement", "fusion" };
+#define ETAPE_PARAMETRES 0 // calcul des coefficients
+#define ETAPE_SEPARATION 1 // trame reue spare en deux voies (pln.h)
+#define ETAPE_TRAITEMENT 2 // filtrage des voies (cnv.h ou avg.h)
+#define ETAPE_FUSION 3 // voies rentrelaces dans la trame  mettre
+
+LAT_Obj latEcho; // mesure de la latence entre-sortie, sortie ligne reboucle sur l'entre
+int mesure_latence = 0; // curseur : le passage  1 lance une mesure
+
+float *Voie[2]; // une voie de la trame par tableau (gauche, droite)
+
+CNV_Obj cnvEcho; // filtre RIF des deux voies, direct ou par FFT, historique compris
+float Coefs[FIR_MAXTAPS]; // coefficients du filtre, Coefs[0] pour l'chantillon le plus rcent
+String fichier_ri = "reponse.wav"; // rponse impulsionnelle (salle, baffle...), lue au dmarrage
+float *RepImp; // ses coefficients
+int nb_ri; // et leur nombre, 0 sans fichier
+#define FILTRE_MOYENNE 0 // moyenne des 2^curseur_moyenne derniers chantillons
+#define FILTRE_PASSE_BAS 1
+#define FILTRE_PASSE_HAUT 2
+#define FILTRE_REPONSE 3 // convolution par la rponse impulsionnelle
+int type_filtre = FILTRE_MOYENNE;
+int curseur_coefs = 4; // 64*curseur_coefs - 1 coefficients pour les passe-bas et passe-haut
+int curseur_coupure = 2; // frquence de coupure en kHz
+int curseur_moyenne = 2; // moyenne sur 2^curseur_moyenne chantillons (4  4096)
+FIR_Table tableFiltres; // fentres et sinus cardinaux de toutes les positions des curseurs, calculs au dmarrage
+int table_filtres; // 1 si elle a pu tre alloue
+#define COEFS_MAX 16 // positions de curseur_coefs dans la table (1  16)
+#define COUPURE_MAX 20 // et de curseur_coupure (1  20 kHz)
+int prev_type_filtre, prev_curseur_coefs, prev_curseur_coupure, prev_curseur_moyenne; // Valeurs des curseurs  l'instant prcdent
+
+AVG_Obj avgEcho; // moyenne glissante des deux voies,  cot constant quelle que soit sa longueur
+int moyenne; // 1 quand la moyenne remplace le filtre RIF
+#define MOYENNE_MAX 12
 
 /*
 *  ======== main ========
@@ -72,7 +115,9 @@ float BufOut[LNGBUF]; // buffer pour la sortie
 */
 main()
 {
-    Int j;
+    Int v;
+    Int longueurs[COEFS_MAX];
+    Float coupures[COUPURE_MAX];
     /*
     * Initialize PIO module
     */
@@ -85,20 +130,59 @@ main()
     /*
     * Prime the transmit side with buffers of silence.
     * The transmitter should be started before the receiver.
-    * This results in input-to-output latency being one full
-    * buffer period if the pipes is configured for 2 frames.
+    * This results in input-to-output latency being one frame
+    * period per primed frame (2 frames, i.e. one full buffer
+    * period, by default), plus the codec: see lat.h to measure it.
     */
-    PIO_txStart(&pioTx, PIP_getWriterNumFrames(&pipTx), 0);
+    PIO_txStart(&pioTx, BLK_txPrimeCount(&pipTx), 0); // toutes les trames, BLK_MINPRIME en mode faible latence
 
     /* Prime the receive side with empty buffers to be filled. */
     PIO_rxStart(&pioRx, PIP_getWriterNumFrames(&pipRx));
 
     LOG_printf(&trace, "pip_audio started"); 
+    PRF_init(&prfEcho, 4, etapes);
+    LAT_init(&latEcho, &trace, SDRAM);
+    
+    // rponse impulsionnelle lue une fois pour toutes, hors du temps rel
+    RepImp = MEM_alloc(SDRAM, CNV_MAXTAPS*sizeof(float), 8);
+    nb_ri = RepImp != MEM_ILLEGAL ? CNV_loadIR(fichier_ri, RepImp, CNV_MAXTAPS) : 0;
+    LOG_printf(&trace, "reponse impulsionnelle: %d coefficients", nb_ri);
     
-    for(j = 0; j < 6; j++)
+    // tableaux des voies en mmoire interne, dimensionns d'aprs la taille des trames
+    for (v = 0; v < 2; v++)
+    {
+        Voie[v] = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8);
+        if (Voie[v] == MEM_ILLEGAL)
+        {
+            SYS_abort("echo: Voie");
+        }
+    }
+    // le filtre aussi, sauf pour une longue rponse dont les spectres vont en SDRAM
+    if (!CNV_init(&cnvEcho, nb_ri > FIR_MAXTAPS ? nb_ri : FIR_MAXTAPS, 2, BLK_config.size/2,
+        nb_ri > FIR_MAXTAPS ? SDRAM : IRAM))
+    {
+        SYS_abort("echo: cnvEcho");
+    }
+    if (!AVG_init(&avgEcho, 1 << MOYENNE_MAX, 1, 2, SDRAM))
+    {
+        SYS_abort("echo: avgEcho");
+    }
+    // filtres de toutes les positions des curseurs : sin() et cos() ici une fois pour toutes,
+    // echo() n'a plus qu'une multiplication par coefficient
+    for (v = 0; v < COEFS_MAX; v++)
     {
-        BufIn[j] = 0; // initialisation  0 des 6 premires cases du buffer
+        longueurs[v] = 64*(v + 1) - 1;
     }
+    for (v = 0; v < COUPURE_MAX; v++)
+    {
+        coupures[v] = (v + 1)*1000.0/44100.0;
+    }
+    table_filtres = FIR_initTable(&tableFiltres, COEFS_MAX, longueurs, COUPURE_MAX, coupures, SDRAM);
+    if (!table_filtres)
+    {
+        LOG_printf(&trace, "table des filtres: memoire insuffisante, FIR_design() en temps reel");
+    }
+    prev_type_filtre = -1; // coefficients calculs  la premire trame
 }
 
 /*
@@ -113,9 +197,8 @@ main()
 */
 Void echo(Void)
 {
-    int i, size;
+    int n, size;
     short *src, *dst;
-    float *ptr1, *ptr2 ;
 
     /*
     * Check that the precondions are met, that is pipRx has a buffer of
@@ -124,11 +207,13 @@ Void echo(Void)
     if (PIP_getReaderNumFrames(&pipRx) <= 0)
     {
         LOG_error("echo: No reader frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
     if (PIP_getWriterNumFrames(&pipTx) <= 0)
     {
         LOG_error("echo: No writer frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
 
@@ -140,40 +225,88 @@ Void echo(Void)
     /* get the empty buffer from the transmit PIP */
     PIP_alloc(&pipTx);
     dst = PIP_getWriterAddr(&pipTx);
+    PRF_begin(&prfEcho);
 
     // -----------------------------------------
-    // copie l'entre vers le buffer d'entre
+    // calcul des coefficients du filtre si les curseurs ont t modifis
     // -----------------------------------------
-    ptr1 = &BufIn[6]; // pointeur sur le buffer d'entre,  partir de l'index 6
-    for (i = 0; i < size; i++)
+    if (type_filtre != prev_type_filtre || curseur_coefs != prev_curseur_coefs ||
+        curseur_coupure != prev_curseur_coupure || curseur_moyenne != prev_curseur_moyenne)
     {
-        *ptr1++ = (float)*src++ / 32768.0; // normalisation du signal entre -1 et +1
-    }     
-
+        moyenne = 0;
+        if (type_filtre == FILTRE_PASSE_BAS || type_filtre == FILTRE_PASSE_HAUT)
+        {
+            if (table_filtres && curseur_coefs >= 1 && curseur_coefs <= COEFS_MAX &&
+                curseur_coupure >= 1 && curseur_coupure <= COUPURE_MAX)
+            {
+                n = FIR_designFrom(&tableFiltres, Coefs, curseur_coefs - 1, curseur_coupure - 1,
+                    type_filtre == FILTRE_PASSE_BAS ? FIR_LOWPASS : FIR_HIGHPASS);
+            }
+            else
+            {
+                // position hors de la table
+                n = FIR_design(Coefs, 64*curseur_coefs - 1, curseur_coupure*1000.0/44100.0,
+                    type_filtre == FILTRE_PASSE_BAS ? FIR_LOWPASS : FIR_HIGHPASS);
+            }
+            CNV_setCoefs(&cnvEcho, Coefs, n, CNV_AUTO);
+        }
+        else if (type_filtre == FILTRE_REPONSE && nb_ri > 0)
+        {
+            CNV_setCoefs(&cnvEcho, RepImp, nb_ri, CNV_AUTO);
+        }
+        else
+        {
+            // somme glissante : un chantillon entre, un sort, quelle que soit la longueur
+            if (curseur_moyenne < 0 || curseur_moyenne > MOYENNE_MAX)
+            {
+                curseur_moyenne = 2;
+            }
+            AVG_setLength(&avgEcho, 1 << curseur_moyenne);
+            moyenne = 1;
+        }
+        if (moyenne)
+        {
+            LOG_printf(&trace, "moyenne: %d echantillons", avgEcho.length);
+        }
+        else
+        {
+            // convolution directe en dessous de cnvEcho.crossover coefficients, par FFT au-dessus
+            LOG_printf(&trace, "filtre: %d coefficients, mode %d", cnvEcho.numTaps, cnvEcho.mode);
+        }
+        prev_type_filtre = type_filtre;
+        prev_curseur_coefs = curseur_coefs;
+        prev_curseur_coupure = curseur_coupure;
+        prev_curseur_moyenne = curseur_moyenne;
+    }
+    PRF_mark(&prfEcho, ETAPE_PARAMETRES);
+    
     // ------------------------------------------
     // Filtrage
     // ------------------------------------------
-    ptr1 = &BufIn[6]; // on initialise le pointeur sur la 7me case du buffer d'entre
-    ptr2 = &BufOut[0]; // pointeur sur le buffer de sortie
+    // La trame est spare en deux voies contigus, normalises entre -1 et
+    // +1, que le filtre RIF (ou la moyenne) traite sur place ; son
+    // historique reste dans cnvEcho (avgEcho). Les voies sont ensuite
+    // rentrelaces.
+    n = size/2; // chantillons par voie
+    PLN_split(src, Voie[0], Voie[1], n);
+    PRF_mark(&prfEcho, ETAPE_SEPARATION);
     
-    for (i = 0; i < size; i++)
+    if (moyenne)
     {
-        *ptr2++ = 0.25*(*ptr1 + *(ptr1-2) + *(ptr1-4) + *(ptr1-6)); // calcul de la sortie du filtre
-        ptr1++; // incrmentation du pointeur sur le buffer d'entre
+        AVG_apply(&avgEcho, 0, Voie[0], Voie[0], n);
+        AVG_apply(&avgEcho, 1, Voie[1], Voie[1], n);
     }
-    
-    for (i = 0; i < 6; i++)
+    else
     {
-        BufIn[i] = BufIn[size+i]; // on copie les 6 dernires cases du buffer d'entre au dbut de celui-ci pour la prochaine itration
+        CNV_apply(&cnvEcho, Voie, n);
     }
+    PRF_mark(&prfEcho, ETAPE_TRAITEMENT);
     
-    // copie le buffer de sortie vers la sortie
-    ptr2 = &BufOut[0];
-    for (i = 0; i < size; i++)
-    {
-        *dst++ = *ptr2++ *32768.0 ; // reconversion du signal en entier
-    }     
-    
+    PLN_merge(Voie[0], Voie[1], dst, n);
+    PRF_mark(&prfEcho, ETAPE_FUSION);
+
+    LAT_loop(&latEcho, mesure_latence, src, dst, size); // remplace la sortie pendant une mesure
+
     /* Record the amount of actual data being sent */
     PIP_setWriterSize(&pipTx, PIP_getReaderSize(&pipRx));
 
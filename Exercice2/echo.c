@@ -35,7 +35,9 @@
 
 #include <std.h>
 #include <math.h>
+#include <string.h>
 #include <log.h>
+#include <mem.h>
 #include <pip.h>
 #include <swi.h>
 #include <sys.h>
@@ -43,37 +45,135 @@
 #include <iom.h>
 #include <pio.h>
 
+#include "prf.h"
+#include "blk.h"
+#include "lat.h"
+#include "pln.h"
+#include "biq.h"
+#include "xov.h"
+
 #ifdef _6x_
 extern far LOG_Obj trace;
 extern far PIP_Obj pipRx; 
 extern far PIP_Obj pipTx;
 extern far SWI_Obj swiEcho;
+extern far Int IRAM;
+extern far Int SDRAM;
 #else
 extern LOG_Obj trace; 
 extern PIP_Obj pipRx;
 extern PIP_Obj pipTx;
 extern SWI_Obj swiEcho;
+extern Int IRAM;
+extern Int SDRAM;
 #endif
 
-#define LNGBUF 128  // longueur des buffers
 /*
 *  'pioRx' and 'pioTx' objects will be initialized by PIO_new(). 
 */
 PIO_Obj pioRx, pioTx;
 
-float BufIn[LNGBUF+4]; // buffer pour les entres, 4 cases en plus pour stocker les valeurs prcdentes
-float BufGraves[LNGBUF+4]; // buffer pour la sortie filtre graves, 4 cases en plus pour stocker les valeurs prcdentes
-float BufAigus[LNGBUF+4]; // buffer pour la sortie filtre aigus, 4 cases en plus pour stocker les valeurs prcdentes
-float BufOut[LNGBUF+4]; // buffer pour la sortie filtre mdiums, 4 cases en plus pour stocker les valeurs prcdentes
+PRF_Obj prfEcho; // mesure du temps pass dans chaque tape de echo()
+String etapes[] = { "parametres", "separation", "traitement", "fusion" };
+#define ETAPE_PARAMETRES 0 // coefficients lus dans Reglages[]
+#define ETAPE_SEPARATION 1 // trame reue spare en deux voies (pln.h)
+#define ETAPE_TRAITEMENT 2 // filtrage de chaque voie, sur place
+#define ETAPE_FUSION 3 // voies rentrelaces dans la trame  mettre
+
+LAT_Obj latEcho; // mesure de la latence entre-sortie, sortie ligne reboucle sur l'entre
+int mesure_latence = 0; // curseur : le passage  1 lance une mesure
+
+float *Voie[2]; // une voie de la trame par tableau (gauche, droite)
+float *Copie[2]; // la trame filtre par l'autre topologie, pour passer de l'une  l'autre en fondu
+
+// graves, aigus puis mdiums en cascade (biq.h), historique compris : deux
+// mots d'tat par filtre et par voie, coefficients normaliss
+BIQ_Obj biqEcho;
+#define FILTRE_GRAVES 0
+#define FILTRE_AIGUS 1
+#define FILTRE_MEDIUMS 2
 float Fe; // Frquence d'chantillonage
 int prev_curseur_graves, prev_curseur_aigus, prev_curseur_mediums; // Valeurs des curseurs  l'instant prcdent
-float c, d, e, w0_graves; // Constantes filtre frquences graves
-float f, g, h, w0_aigus; // Constantes filtre frquences aigus
-float k, m, n, q, p, w0_mediums, alpha, q1, q2; // Constantes filtre frquences mdiums
+float w0_graves; // Constante filtre frquences graves
+float w0_aigus; // Constante filtre frquences aigus
+float w0_mediums, alpha; // Constantes filtre frquences mdiums
+#define GAIN_MAX 10 // positions 0  10 des curseurs de Volume.gel
+BIQ_Coefs Reglages[3][GAIN_MAX + 1]; // coefficients de chaque filtre pour chaque position, calculs dans main()
 int gain_graves = 5;
 int gain_aigus = 5;
 int gain_mediums = 5;
 
+// autre topologie : un banc de filtres de Linkwitz-Riley (xov.h) spare le
+// signal en trois bandes aux frquences de coupure des graves et des aigus,
+// filtres indpendamment (en parallle) puis sommes avec le gain de leur
+// curseur ; gains  1, la somme des bandes a un module plat
+XOV_Obj xovEcho;
+#define BANDE_GRAVES 0
+#define BANDE_MEDIUMS 1
+#define BANDE_AIGUS 2
+float GainsBande[GAIN_MAX + 1]; // gain linaire de chaque position, 4 dB par cran comme les plateaux
+int topologie = 0; // curseur : 0 filtres en cascade, 1 banc de filtres parallle
+int prev_topologie;
+int filtrage_blocs = 0; // curseur : 1 pour calculer chaque filtre de la cascade par blocs de BIQ_BLOCK chantillons (biq.h)
+int prev_filtrage_blocs = 0;
+int premiere_trame = 1; // aucune trame traite : des curseurs rgls d'ici l sont pris tels quels, sans transition
+
+/*
+*  ======== calcul_coefs ========
+*
+*  Coefficients du filtre 'filtre' pour la position 'gain' de son
+*  curseur, normaliss dans 'coefs'. Racines, puissances et divisions
+*  restent hors du temps rel : main() remplit Reglages[] une fois pour
+*  toutes et echo() n'a plus qu' y lire.
+*/
+void calcul_coefs(int filtre, int gain, BIQ_Coefs *coefs)
+{
+    float temp; // variable de stockage temporaire
+    float c, d, e; // Constantes filtre frquences graves
+    float f, g, h; // Constantes filtre frquences aigus
+    float k, m, n, q, p, q1, q2; // Constantes filtre frquences mdiums
+
+    temp = sqrt(pow(10.0, ((float)gain-5.0)/5.0)); // on calcule la racine carr du gain une seule fois
+    coefs->b2 = 0; // premier ordre pour les graves et les aigus
+    coefs->a2 = 0;
+    if (filtre == FILTRE_GRAVES)
+    {
+        c = (2+w0_graves*temp)/(2+w0_graves/temp);
+        d = (-2+w0_graves*temp)/(2+w0_graves/temp);
+        e = (-2+w0_graves/temp)/(2+w0_graves/temp);
+        // graves = c*entree + d*entree1 - e*graves1
+        coefs->b0 = c;
+        coefs->b1 = d;
+        coefs->a1 = e;
+    }
+    else if (filtre == FILTRE_AIGUS)
+    {
+        f = (-2*temp+w0_aigus)/(w0_aigus + 2/temp);
+        g = (w0_aigus - 2/temp)/(w0_aigus + 2/temp);
+        h = (w0_aigus + 2*temp)/(w0_aigus + 2/temp);
+        // aigus = h*graves + f*graves1 - g*aigus1
+        coefs->b0 = h;
+        coefs->b1 = f;
+        coefs->a1 = g;
+    }
+    else
+    {
+        q2 = alpha*temp/(1-alpha*alpha);
+        q1 = q2/pow(10.0, ((float)gain-5.0)/5.0);
+        k = 4 + w0_mediums*w0_mediums + 2*w0_mediums/q1;
+        m = 2*w0_mediums*w0_mediums-8;
+        n = 4 + w0_mediums*w0_mediums - 2*w0_mediums/q1;
+        q = 4 + w0_mediums*w0_mediums - 2*w0_mediums/q2;
+        p = 4 + w0_mediums*w0_mediums + 2*w0_mediums/q2;
+        // sortie = (k*aigus + m*aigus1 + n*aigus2 - m*sortie1 - q*sortie2)/p, divis ici une fois pour toutes
+        coefs->b0 = k/p;
+        coefs->b1 = m/p;
+        coefs->b2 = n/p;
+        coefs->a1 = m/p;
+        coefs->a2 = q/p;
+    }
+}
+
 /*
 *  ======== main ========
 *
@@ -82,16 +182,25 @@ int gain_mediums = 5;
 */
 main()
 {
-    int j;
+    int j, filtre;
+    double coupures[2];
     Fe = 44100.0;
     alpha = 0.1;
     w0_graves = 2*3.14*400.0/Fe; // Frquence coupure filtre graves
     w0_aigus = 2*3.14*2500.0/Fe; // Frquence coupure filtre aigus
     w0_mediums = 2*3.14*1000.0/Fe; // Frquence coupure filtre aigus
     
-    prev_curseur_graves = 0;
-    prev_curseur_aigus = 0;
-    prev_curseur_mediums = 0;
+    for (filtre = 0; filtre < 3; filtre++)
+    {
+        for (j = 0; j <= GAIN_MAX; j++)
+        {
+            calcul_coefs(filtre, j, &Reglages[filtre][j]);
+        }
+    }
+    for (j = 0; j <= GAIN_MAX; j++)
+    {
+        GainsBande[j] = pow(10.0, (j-5.0)/5.0);
+    }
     
     /*
     * Initialize PIO module
@@ -105,23 +214,50 @@ main()
     /*
     * Prime the transmit side with buffers of silence.
     * The transmitter should be started before the receiver.
-    * This results in input-to-output latency being one full
-    * buffer period if the pipes is configured for 2 frames.
+    * This results in input-to-output latency being one frame
+    * period per primed frame (2 frames, i.e. one full buffer
+    * period, by default), plus the codec: see lat.h to measure it.
     */
-    PIO_txStart(&pioTx, PIP_getWriterNumFrames(&pipTx), 0);
+    PIO_txStart(&pioTx, BLK_txPrimeCount(&pipTx), 0); // toutes les trames, BLK_MINPRIME en mode faible latence
 
     /* Prime the receive side with empty buffers to be filled. */
     PIO_rxStart(&pioRx, PIP_getWriterNumFrames(&pipRx));
 
     LOG_printf(&trace, "pip_audio started");
+    PRF_init(&prfEcho, 4, etapes);
+    LAT_init(&latEcho, &trace, SDRAM);
     
-    for (j = 0; j < 4; j++) // initialisation  0 des 4 premires cases des buffers
+    for (j = 0; j < 2; j++)
+    {
+        Voie[j] = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8); // en mmoire interne
+        Copie[j] = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8);
+        if (Voie[j] == MEM_ILLEGAL || Copie[j] == MEM_ILLEGAL)
+        {
+            SYS_abort("echo: Voie");
+        }
+    }
+    if (!BIQ_init(&biqEcho, 3, 2, IRAM)) // historique  0
     {
-        BufIn[j] = 0;
-        BufGraves[j] = 0;
-        BufAigus[j] = 0;
-        BufOut[j] = 0;
+        SYS_abort("echo: biqEcho");
     }
+    BIQ_setNumSections(&biqEcho, 3);
+    BIQ_setCoefs(&biqEcho, FILTRE_GRAVES, &Reglages[FILTRE_GRAVES][gain_graves]);
+    BIQ_setCoefs(&biqEcho, FILTRE_AIGUS, &Reglages[FILTRE_AIGUS][gain_aigus]);
+    BIQ_setCoefs(&biqEcho, FILTRE_MEDIUMS, &Reglages[FILTRE_MEDIUMS][gain_mediums]);
+    prev_curseur_graves = gain_graves;
+    prev_curseur_aigus = gain_aigus;
+    prev_curseur_mediums = gain_mediums;
+
+    coupures[0] = 400.0/Fe;
+    coupures[1] = 2500.0/Fe;
+    if (!XOV_init(&xovEcho, 3, 2, IRAM))
+    {
+        SYS_abort("echo: xovEcho");
+    }
+    XOV_setGain(&xovEcho, BANDE_GRAVES, GainsBande[gain_graves]);
+    XOV_setGain(&xovEcho, BANDE_MEDIUMS, GainsBande[gain_mediums]);
+    XOV_setGain(&xovEcho, BANDE_AIGUS, GainsBande[gain_aigus]);
+    XOV_setBands(&xovEcho, 3, coupures);
 }
 
 /*
@@ -136,9 +272,9 @@ main()
 */
 Void echo(Void)
 {
-    int i, size;
+    int nb, size, i, j;
+    float pas;
     short *src, *dst;
-    float temp; // variable de stockage temporaire
 
     /*
     * Check that the precondions are met, that is pipRx has a buffer of
@@ -147,11 +283,13 @@ Void echo(Void)
     if (PIP_getReaderNumFrames(&pipRx) <= 0)
     {
         LOG_error("echo: No reader frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
     if (PIP_getWriterNumFrames(&pipTx) <= 0)
     {
         LOG_error("echo: No writer frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
 
@@ -163,73 +301,127 @@ Void echo(Void)
     /* get the empty buffer from the transmit PIP */
     PIP_alloc(&pipTx);
     dst = PIP_getWriterAddr(&pipTx);
+    PRF_begin(&prfEcho);
 
     // -----------------------------------------
-    // copie l'entre vers le buffer d'entre
-    // -----------------------------------------
-    for (i = 4; i < size + 4; i++)
-    {
-        BufIn[i] = (float)*src++ / 32768.0; // normalisation du signal entre -1 et +1
-    }     
-
-    // -----------------------------------------
-    // calcul coefficients des filtres si les curseurs ont t modifis
+    // nouveaux coefficients si les curseurs ont t modifis, lus dans la
+    // table et atteints progressivement au cours de la trame (pas de
+    // claquement) ; un filtre dont la transition prcdente n'est pas
+    // termine les prendra  la trame suivante. Avant la premire trame,
+    // il n'y a rien  adoucir : les coefficients sont pris d'emble, et la
+    // rponse ne dpend pas de l'instant o arrive le signal
     // -----------------------------------------
-    if (gain_graves != prev_curseur_graves)
+    if (gain_graves != prev_curseur_graves && gain_graves >= 0 && gain_graves <= GAIN_MAX &&
+        (premiere_trame ? BIQ_setCoefs(&biqEcho, FILTRE_GRAVES, &Reglages[FILTRE_GRAVES][gain_graves]) :
+        BIQ_rampCoefs(&biqEcho, FILTRE_GRAVES, &Reglages[FILTRE_GRAVES][gain_graves])))
     {
-        temp = sqrt(pow(10.0, ((float)gain_graves-5.0)/5.0)); // on calcule la racine carr du gain une seule fois
-        c = (2+w0_graves*temp)/(2+w0_graves/temp);
-        d = (-2+w0_graves*temp)/(2+w0_graves/temp);
-        e = (-2+w0_graves/temp)/(2+w0_graves/temp);
         prev_curseur_graves = gain_graves;
     }
-    
-    if (gain_aigus != prev_curseur_aigus)
-    {	
-        temp = sqrt(pow(10.0, ((float)gain_aigus-5.0)/5.0)); // on calcule la racine carr du gain une seule fois
-        f = (-2*temp+w0_aigus)/(w0_aigus + 2/temp);
-        g = (w0_aigus - 2/temp)/(w0_aigus + 2/temp);
-        h = (w0_aigus + 2*temp)/(w0_aigus + 2/temp);
+    if (gain_aigus != prev_curseur_aigus && gain_aigus >= 0 && gain_aigus <= GAIN_MAX &&
+        (premiere_trame ? BIQ_setCoefs(&biqEcho, FILTRE_AIGUS, &Reglages[FILTRE_AIGUS][gain_aigus]) :
+        BIQ_rampCoefs(&biqEcho, FILTRE_AIGUS, &Reglages[FILTRE_AIGUS][gain_aigus])))
+    {
         prev_curseur_aigus = gain_aigus;
     }
-    
-    if (gain_mediums != prev_curseur_mediums)
+    if (gain_mediums != prev_curseur_mediums && gain_mediums >= 0 && gain_mediums <= GAIN_MAX &&
+        (premiere_trame ? BIQ_setCoefs(&biqEcho, FILTRE_MEDIUMS, &Reglages[FILTRE_MEDIUMS][gain_mediums]) :
+        BIQ_rampCoefs(&biqEcho, FILTRE_MEDIUMS, &Reglages[FILTRE_MEDIUMS][gain_mediums])))
     {
-        temp = sqrt(pow(10.0, ((float)gain_mediums-5.0)/5.0)); // on calcule la racine carr du gain une seule fois
-        q2 = alpha*temp/(1-alpha*alpha);
-        q1 = q2/pow(10.0, ((float)gain_mediums-5.0)/5.0);
-        k = 4 + w0_mediums*w0_mediums + 2*w0_mediums/q1;
-        m = 2*w0_mediums*w0_mediums-8;
-        n = 4 + w0_mediums*w0_mediums - 2*w0_mediums/q1;
-        q = 4 + w0_mediums*w0_mediums - 2*w0_mediums/q2;
-        p = 4 + w0_mediums*w0_mediums + 2*w0_mediums/q2;
         prev_curseur_mediums = gain_mediums;
     }
+    // de mme, la topologie choisie avant la premire trame est prise sans
+    // fondu
+    if (premiere_trame)
+    {
+        prev_topologie = topologie;
+    }
+    // calcul par blocs ou chantillon par chantillon, mme historique
+    if (filtrage_blocs != prev_filtrage_blocs)
+    {
+        prev_filtrage_blocs = filtrage_blocs;
+        for (j = 0; j < 3; j++)
+        {
+            BIQ_setBlocked(&biqEcho, j, filtrage_blocs != 0);
+        }
+    }
+    // gains des bandes, atteints eux aussi au cours de la trame
+    if (gain_graves >= 0 && gain_graves <= GAIN_MAX)
+    {
+        XOV_setGain(&xovEcho, BANDE_GRAVES, GainsBande[gain_graves]);
+    }
+    if (gain_mediums >= 0 && gain_mediums <= GAIN_MAX)
+    {
+        XOV_setGain(&xovEcho, BANDE_MEDIUMS, GainsBande[gain_mediums]);
+    }
+    if (gain_aigus >= 0 && gain_aigus <= GAIN_MAX)
+    {
+        XOV_setGain(&xovEcho, BANDE_AIGUS, GainsBande[gain_aigus]);
+    }
+    
+    PRF_mark(&prfEcho, ETAPE_PARAMETRES);
     
     // ------------------------------------------
     // Filtrage
     // ------------------------------------------
-    for (i = 4; i < size + 4; i++)
+    // La trame est spare en deux voies contigus, normalises entre -1 et
+    // +1 (pln.h), filtres sur place puis rentrelaces et reconverties en
+    // entiers, avec saturation. Chaque filtre traite toute la trame avant le
+    // suivant, les deux voies dans la mme boucle : leurs rcursions sont
+    // indpendantes et s'excutent en parallle (biq.h). Le banc de filtres
+    // traite ses trois bandes de front (xov.h).
+    nb = size/2; // chantillons par voie
+    PLN_split(src, Voie[0], Voie[1], nb);
+    PRF_mark(&prfEcho, ETAPE_SEPARATION);
+    
+    if ((topologie != 0) == (prev_topologie != 0))
     {
-        BufGraves[i] = BufIn[i]*c + BufIn[i-2]*d - BufGraves[i-2]*e; // calcul de la sortie du filtre pour les graves
-        BufAigus[i] = BufGraves[i]*h + BufGraves[i-2]*f - BufAigus[i-2]*g; // calcul de la sortie du filtre pour les aigus
-        BufOut[i] = (-m*BufOut[i-2] - q*BufOut[i-4] + k*BufAigus[i] + m*BufAigus[i-2] + n*BufAigus[i-4])/p; // calcul de la sortie du filtre pour les mediums
+        if (topologie != 0)
+        {
+            XOV_apply(&xovEcho, Voie, nb);
+        }
+        else
+        {
+            BIQ_apply(&biqEcho, Voie, nb);
+        }
     }
-
-    //on copie les 4 dernires cases des buffers d'entre au dbut de ceux-ci pour la prochaine itration
-    for (i = 0; i < 4; i++)
+    else
     {
-        BufIn[i] = BufIn[size+i];
-        BufGraves[i] = BufGraves[size+i];
-        BufAigus[i] = BufAigus[size+i];
-        BufOut[i] = BufOut[size+i];
+        // changement de topologie : la trame passe par les deux, la nouvelle
+        // repartant d'un historique nul, et l'on passe de l'une  l'autre en
+        // fondu sur la trame
+        for (j = 0; j < 2; j++)
+        {
+            memcpy(Copie[j], Voie[j], nb*sizeof(float));
+        }
+        if (topologie != 0)
+        {
+            XOV_reset(&xovEcho);
+            BIQ_apply(&biqEcho, Voie, nb);
+            XOV_apply(&xovEcho, Copie, nb);
+        }
+        else
+        {
+            BIQ_reset(&biqEcho);
+            XOV_apply(&xovEcho, Voie, nb);
+            BIQ_apply(&biqEcho, Copie, nb);
+        }
+        pas = 1.0f/nb; // une seule division par trame
+        for (j = 0; j < 2; j++)
+        {
+            for (i = 0; i < nb; i++)
+            {
+                Voie[j][i] += (i + 1)*pas*(Copie[j][i] - Voie[j][i]);
+            }
+        }
+        prev_topologie = topologie;
     }
+    premiere_trame = 0;
+    PRF_mark(&prfEcho, ETAPE_TRAITEMENT);
     
-    // copie le buffer de sortie vers la sortie
-    for (i = 4; i < size + 4; i++)
-    {
-        *dst++ = BufOut[i] *32768.0 ; // reconversion du signal en entier
-    }     
+    PLN_merge(Voie[0], Voie[1], dst, nb);
+    PRF_mark(&prfEcho, ETAPE_FUSION);
+
+    LAT_loop(&latEcho, mesure_latence, src, dst, size); // remplace la sortie pendant une mesure
 
     /* Record the amount of actual data being sent */
     PIP_setWriterSize(&pipTx, PIP_getReaderSize(&pipRx));
@@ -39,32 +39,52 @@
 #include <pip.h>
 #include <swi.h>
 #include <sys.h>
+#include <mem.h>
 
 #include <iom.h>
 #include <pio.h>
 
+#include "prf.h"
+#include "blk.h"
+#include "lat.h"
+#include "pln.h"
+#include "dly.h"
+
 #ifdef _6x_
 extern far LOG_Obj trace;
 extern far PIP_Obj pipRx; 
 extern far PIP_Obj pipTx;
 extern far SWI_Obj swiEcho;
+extern far Int IRAM;
+extern far Int SDRAM;
 #else
 extern LOG_Obj trace; 
 extern PIP_Obj pipRx;
 extern PIP_Obj pipTx;
 extern SWI_Obj swiEcho;
+extern Int IRAM;
+extern Int SDRAM;
 #endif
 
-#define LNGBUF 128  // longueur des buffers
 #define FE 44100
+#define FORMAT_LIGNE DLY_FLOAT // DLY_Q15 ou DLY_BFP : ligne  retard sur 16 bits, moiti moins de mmoire (dly.h)
 /*
 *  'pioRx' and 'pioTx' objects will be initialized by PIO_new(). 
 */
 PIO_Obj pioRx, pioTx;
 
-float BufIn[LNGBUF]; // buffer pour les entres
-far float BufInt[LNGBUF+FE]; // buffer intermdiaire
-float BufOut[LNGBUF]; // buffer pour la sortie
+PRF_Obj prfEcho; // mesure du temps pass dans chaque tape de echo()
+String etapes[] = { "parametres", "traitement" };
+#define ETAPE_PARAMETRES 0 // prise en compte des curseurs
+#define ETAPE_TRAITEMENT 1 // filtrage directement de la trame reue vers la trame  mettre
+
+LAT_Obj latEcho; // mesure de la latence entre-sortie, sortie ligne reboucle sur l'entre
+int mesure_latence = 0; // curseur : le passage  1 lance une mesure
+
+DLY_Obj ligne; // ligne  retard (dly.h), contient les lngint derniers chantillons
+float *Retour; // chantillons relus k+1 cases plus tt pour un morceau de trame, puis ceux qui sont crits
+float *Lu; // chantillons relus k cases plus tt, pour la sortie
+int lngint; // taille des trames (BLK_config.size) + FE
 int curseur_alpha = 0;
 int curseur_retard = 0;
 int curseur_lambda = 0;
@@ -75,7 +95,6 @@ float lambda = 0;
 float un_moins_alpha = 0;
 float alpha = 1.0;
 int k = 0;
-int index = FE;
 
 /*
 *  ======== main ========
@@ -86,15 +105,16 @@ int index = FE;
 main()
 {
 	
-    int j;
-    for (j = 0; j < FE+LNGBUF; j++)
+    lngint = BLK_config.size + FE;
+    if (!DLY_init(&ligne, lngint, FORMAT_LIGNE, SDRAM)) // silence au dpart
     {
-        BufInt[j] = 0;
+        SYS_abort("echo: ligne");
     }
-    for (j = 0; j < LNGBUF; j++)
+    Retour = MEM_alloc(IRAM, BLK_config.size*sizeof(float), 8); // en mmoire interne
+    Lu = MEM_alloc(IRAM, BLK_config.size*sizeof(float), 8);
+    if (Retour == MEM_ILLEGAL || Lu == MEM_ILLEGAL)
     {
-        BufIn[j] = 0;
-        BufOut[j] = 0;
+        SYS_abort("echo: Retour");
     }
     /*
     * Initialize PIO module
@@ -108,15 +128,18 @@ main()
     /*
     * Prime the transmit side with buffers of silence.
     * The transmitter should be started before the receiver.
-    * This results in input-to-output latency being one full
-    * buffer period if the pipes is configured for 2 frames.
+    * This results in input-to-output latency being one frame
+    * period per primed frame (2 frames, i.e. one full buffer
+    * period, by default), plus the codec: see lat.h to measure it.
     */
-    PIO_txStart(&pioTx, PIP_getWriterNumFrames(&pipTx), 0);
+    PIO_txStart(&pioTx, BLK_txPrimeCount(&pipTx), 0); // toutes les trames, BLK_MINPRIME en mode faible latence
 
     /* Prime the receive side with empty buffers to be filled. */
     PIO_rxStart(&pioRx, PIP_getWriterNumFrames(&pipRx));
 
     LOG_printf(&trace, "pip_audio started");
+    PRF_init(&prfEcho, 2, etapes);
+    LAT_init(&latEcho, &trace, SDRAM);
    
 }
 
@@ -132,8 +155,9 @@ main()
 */
 Void echo(Void)
 {
-    int i, size;
+    int i, j, m, size;
     short *src, *dst;
+    float entree, ecrit;
 
     /*
     * Check that the precondions are met, that is pipRx has a buffer of
@@ -142,11 +166,13 @@ Void echo(Void)
     if (PIP_getReaderNumFrames(&pipRx) <= 0)
     {
         LOG_error("echo: No reader frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
     if (PIP_getWriterNumFrames(&pipTx) <= 0)
     {
         LOG_error("echo: No writer frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
 
@@ -158,6 +184,7 @@ Void echo(Void)
     /* get the empty buffer from the transmit PIP */
     PIP_alloc(&pipTx);
     dst = PIP_getWriterAddr(&pipTx);
+    PRF_begin(&prfEcho);
 
 	if(curseur_alpha != prev_curseur_alpha)
 	{
@@ -177,37 +204,52 @@ Void echo(Void)
 	}
 	
 	
-    // -----------------------------------------
-    // copie l'entre vers le buffer d'entre
-    // -----------------------------------------
-    for (i = 0; i < size; i++)
-    {
-        BufIn[i] = (float)*src++ / 32768.0; // normalisation du signal entre -1 et +1
-    }     
+    PRF_mark(&prfEcho, ETAPE_PARAMETRES);
     
     // ------------------------------------------
     // Filtrage
     // ------------------------------------------
-    for (i = 0; i < size; i++)
+    // Chaque chantillon est lu dans la trame reue, normalis entre -1 et
+    // +1, et le rsultat crit directement dans la trame  mettre, reconverti
+    // en entier avec saturation sans branchement (pln.h) : pas de trame
+    // intermdiaire en flottants.
+    // La trame est traite par morceaux dont la ligne  retard fournit d'un
+    // bloc les chantillons k+1 cases (bouclage) et k cases (sortie) plus tt,
+    // dj crits : un morceau fait au plus k cases.
+    if (k > 0)
     {
-        BufInt[(index+i)%(LNGBUF+FE)] = lambda*BufInt[(index + i - k + LNGBUF+FE-1)%(LNGBUF+FE)] + BufIn[i];
-    	BufOut[i] = un_moins_alpha*BufIn[i] + alpha*BufInt[(index + i - k + LNGBUF+FE)%(LNGBUF+FE)]; // calcul de la sortie du filtre
+        for (i = 0; i < size; i += m)
+        {
+            m = size - i < k ? size - i : k;
+            DLY_read(&ligne, k + 1, Retour, m);
+            DLY_read(&ligne, k, Lu, m);
+            for (j = 0; j < m; j++)
+            {
+                entree = (float)src[i+j]/PLN_SCALE;
+                Retour[j] = lambda*Retour[j] + entree;
+                dst[i+j] = PLN_sat16((un_moins_alpha*entree + alpha*Lu[j])*PLN_SCALE); // calcul de la sortie du filtre
+            }
+            DLY_write(&ligne, Retour, m);
+        }
     }
-    index += size;
-    if (index >= FE+LNGBUF)
-    	index -= (FE+LNGBUF);
-    
-    
-    // copie le buffer de sortie vers la sortie
-    for (i = 0; i < size; i++)
+    else
     {
-    	if (BufOut[i] > 1.0)
-    		*dst++ = 32767.0;
-    	else if (BufOut[i] < -1.0)
-    		*dst++ = -32768.0;
-    	else
-        	*dst++ = BufOut[i] *32768.0; // reconversion du signal en entier
-    }     
+        // k nul : filtre rcursif du premier ordre sur toute la trame, qui
+        // part du dernier chantillon crit, lu une seule fois ; la sortie
+        // reprend l'chantillon qui vient d'tre calcul.
+        DLY_read(&ligne, 1, &ecrit, 1);
+        for (j = 0; j < size; j++)
+        {
+            entree = (float)src[j]/PLN_SCALE;
+            ecrit = lambda*ecrit + entree;
+            Retour[j] = ecrit;
+            dst[j] = PLN_sat16((un_moins_alpha*entree + alpha*ecrit)*PLN_SCALE); // calcul de la sortie du filtre
+        }
+        DLY_write(&ligne, Retour, size);
+    }
+    PRF_mark(&prfEcho, ETAPE_TRAITEMENT);
+
+    LAT_loop(&latEcho, mesure_latence, src, dst, size); // remplace la sortie pendant une mesure
 
     /* Record the amount of actual data being sent */
     PIP_setWriterSize(&pipTx, PIP_getReaderSize(&pipRx));
@@ -39,20 +39,31 @@
 #include <pip.h>
 #include <swi.h>
 #include <sys.h>
+#include <mem.h>
 
 #include <iom.h>
 #include <pio.h>
 
+#include "prf.h"
+#include "blk.h"
+#include "lat.h"
+#include "pln.h"
+#include "dly.h"
+
 #ifdef _6x_
 extern far LOG_Obj trace;
 extern far PIP_Obj pipRx; 
 extern far PIP_Obj pipTx;
 extern far SWI_Obj swiEcho;
+extern far Int IRAM;
+extern far Int SDRAM;
 #else
 extern LOG_Obj trace; 
 extern PIP_Obj pipRx;
 extern PIP_Obj pipTx;
 extern SWI_Obj swiEcho;
+extern Int IRAM;
+extern Int SDRAM;
 #endif
 
 /*
@@ -60,20 +71,33 @@ extern SWI_Obj swiEcho;
 */
 PIO_Obj pioRx, pioTx;
 
-#define LNGBUF 128  // longueur des buffers
+PRF_Obj prfEcho; // mesure du temps pass dans chaque tape de echo()
+String etapes[] = { "parametres", "separation", "traitement", "fusion" };
+#define ETAPE_PARAMETRES 0 // prise en compte des curseurs
+#define ETAPE_SEPARATION 1 // trame reue spare en deux voies (pln.h)
+#define ETAPE_TRAITEMENT 2 // filtrage de chaque voie, sur place
+#define ETAPE_FUSION 3 // voies rentrelaces dans la trame  mettre
+
+LAT_Obj latEcho; // mesure de la latence entre-sortie, sortie ligne reboucle sur l'entre
+int mesure_latence = 0; // curseur : le passage  1 lance une mesure
+
 #define FE 44100
-#define RETARD_FIXE 10
-#define RETARD_VARMAX 40
-float BufIn[LNGBUF]; // buffer pour les entres
-float BufFixe[LNGBUF+RETARD_FIXE*2]; // buffer intermdiaire fixe
-float BufVariable[LNGBUF+RETARD_VARMAX*2]; // buffer intermdiaire variable
-float BufOut[LNGBUF]; // buffer pour la sortie
+#define RETARD_FIXE 10 // retard du signal direct, en chantillons par voie
+#define RETARD_VARMAX 40 // retard maximum du signal retard, en chantillons par voie
+float *Voie[2]; // une voie de la trame par tableau (gauche, droite), normalise entre -1 et +1
+DLY_Obj ligne[2]; // ligne  retard de chaque voie (dly.h), contient la trame et les RETARD_VARMAX+1 chantillons prcdents
+float *Retards; // retard variable de chaque chantillon de la trame, compt depuis la fin de la trame (dly.h)
+float *Fixe; // signal direct d'une voie, RETARD_FIXE chantillons plus tt
 int curseur_periode = 10;
 int curseur_amplitude_retard = 0;
+int curseur_interpolation = 0; // 1 : retard variable fractionnaire, interpol entre deux chantillons
 int prev_curseur_periode = 0;
 int prev_curseur_amplitude_retard = 0;
-float alpha = 0.0;
-int k = 0, index_fixe = 0, index_variable = 0;
+float alpha = 0.5; // proportion du signal retard dans la sortie
+float un_moins_alpha = 0.5;
+float retard = 0.0; // retard variable courant, en chantillons par voie
+float amplitude = 0.0; // retard variable maximum, en chantillons par voie
+float pas = 0.0; // variation du retard  chaque chantillon
 
 /*
 *  ======== main ========
@@ -84,14 +108,24 @@ int k = 0, index_fixe = 0, index_variable = 0;
 main()
 {
     int j;
-    for (j = 0; j < AMPLITUDE_MAX*2; j++)
+
+    for (j = 0; j < 2; j++)
     {
-        BufInt[j] = 0;
+        if (!DLY_init(&ligne[j], BLK_config.size/2 + RETARD_VARMAX + 1, DLY_FLOAT, SDRAM)) // silence au dpart
+        {
+            SYS_abort("echo: ligne");
+        }
+        Voie[j] = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8); // en mmoire interne
+        if (Voie[j] == MEM_ILLEGAL)
+        {
+            SYS_abort("echo: Voie");
+        }
     }
-    for (j = 0; j < LNGBUF; j++)
+    Retards = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8);
+    Fixe = MEM_alloc(IRAM, BLK_config.size/2*sizeof(float), 8);
+    if (Retards == MEM_ILLEGAL || Fixe == MEM_ILLEGAL)
     {
-        BufIn[j] = 0;
-        BufOut[j] = 0;
+        SYS_abort("echo: Retards");
     }
     /*
     * Initialize PIO module
@@ -105,15 +139,18 @@ main()
     /*
     * Prime the transmit side with buffers of silence.
     * The transmitter should be started before the receiver.
-    * This results in input-to-output latency being one full
-    * buffer period if the pipes is configured for 2 frames.
+    * This results in input-to-output latency being one frame
+    * period per primed frame (2 frames, i.e. one full buffer
+    * period, by default), plus the codec: see lat.h to measure it.
     */
-    PIO_txStart(&pioTx, PIP_getWriterNumFrames(&pipTx), 0);
+    PIO_txStart(&pioTx, BLK_txPrimeCount(&pipTx), 0); // toutes les trames, BLK_MINPRIME en mode faible latence
 
     /* Prime the receive side with empty buffers to be filled. */
     PIO_rxStart(&pioRx, PIP_getWriterNumFrames(&pipRx));
 
     LOG_printf(&trace, "pip_audio started");
+    PRF_init(&prfEcho, 4, etapes);
+    LAT_init(&latEcho, &trace, SDRAM);
    
 }
 
@@ -129,7 +166,7 @@ main()
 */
 Void echo(Void)
 {
-    int i, size;
+    int i, j, nb, size;
     short *src, *dst;
 
     /*
@@ -139,11 +176,13 @@ Void echo(Void)
     if (PIP_getReaderNumFrames(&pipRx) <= 0)
     {
         LOG_error("echo: No reader frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
     if (PIP_getWriterNumFrames(&pipTx) <= 0)
     {
         LOG_error("echo: No writer frame!", 0);
+        PRF_missed(&prfEcho);
         return;
     }
 
@@ -155,48 +194,68 @@ Void echo(Void)
     /* get the empty buffer from the transmit PIP */
     PIP_alloc(&pipTx);
     dst = PIP_getWriterAddr(&pipTx);
+    PRF_begin(&prfEcho);
 
-	if(curseur_periode != prev_curseur_periode)
+	if(curseur_periode != prev_curseur_periode || curseur_amplitude_retard != prev_curseur_amplitude_retard)
 	{
-		
-	}
-	if(curseur_amplitude_retard != prev_curseur_amplitude_retard)
-	{
-		
+		prev_curseur_periode = curseur_periode;
+		prev_curseur_amplitude_retard = curseur_amplitude_retard;
+		amplitude = RETARD_VARMAX*curseur_amplitude_retard/10.0;
+		// le retard fait un aller-retour entre 0 et amplitude en curseur_periode diximes de seconde
+		pas = 2.0*amplitude/(FE*0.1*(curseur_periode > 0 ? curseur_periode : 1));
+		if (retard > amplitude)
+			retard = amplitude;
 	}
 	
 	
-    // -----------------------------------------
-    // copie l'entre vers le buffer d'entre
-    // -----------------------------------------
-    for (i = 0; i < size; i++)
-    {
-        BufIn[i] = (float)*src++ / 32768.0; // normalisation du signal entre -1 et +1
-    }  
-        // ------------------------------------------
-    // Signal triangulaire k
-    // ------------------------------------------   
-    
+    PRF_mark(&prfEcho, ETAPE_PARAMETRES);
     
     // ------------------------------------------
     // Filtrage
     // ------------------------------------------
-    for (i = 0; i < size; i++)
+    // La trame reue est spare en deux voies de flottants entre -1 et +1,
+    // chaque voie est crite dans sa ligne  retard puis relue deux fois,
+    // et les voies sont rentrelaces avec saturation (pln.h).
+    nb = size/2; // chantillons par voie
+    PLN_split(src, Voie[0], Voie[1], nb);
+    PRF_mark(&prfEcho, ETAPE_SEPARATION);
+    
+    for (i = 0; i < nb; i++)
     {
-    	BufFixe[(i+index_fixe)%(LNGBUF + RETARD_FIXE*2)] = BufIn[(i + index_fixe + LNGBUF + RETARD_FIXE)%(LNGBUF + RETARD_FIXE*2)];
-    	BufVariable[(i+index_variable)%(LNGBUF + RETARD_VARMAX*2)] = BufIn[(i + index_variable - k + LNGBUF + RETARD_VARMAX)%(LNGBUF + RETARD_VARMAX*2)];
-    	BufOut[i] =  + alpha*BufInt[(index + i - k + LNGBUF+FE)%(LNGBUF+FE)]; // calcul de la sortie du filtre	un_moins_alpha*
+    	// retard de l'chantillon i, compt depuis la fin de la trame une fois
+    	// crite dans la ligne : retard variable arrondi  l'chantillon, ou
+    	// fractionnaire (sans saut d'un chantillon  l'autre)
+    	Retards[i] = nb + (curseur_interpolation ? retard : (float)(int)retard);
+    	
+    	// signal triangulaire : le retard variable crot puis dcrot entre 0 et amplitude
+    	retard += pas;
+    	if (retard >= amplitude)
+    	{
+    		retard = amplitude;
+    		pas = -pas;
+    	}
+    	else if (retard <= 0.0)
+    	{
+    		retard = 0.0;
+    		pas = -pas;
+    	}
     }
-    index += size;
-    if (index >= FE+LNGBUF)
-    	index -= (FE+LNGBUF);
-    
-    
-    // copie le buffer de sortie vers la sortie
-    for (i = 0; i < size; i++)
+    for (j = 0; j < 2; j++)
     {
-    	*dst++ = BufOut[i] *32768.0; // reconversion du signal en entier
-    }     
+        DLY_write(&ligne[j], Voie[j], nb);
+        DLY_read(&ligne[j], nb + RETARD_FIXE, Fixe, nb); // signal direct
+        DLY_readMod(&ligne[j], Retards, Voie[j], nb); // signal retard
+        for (i = 0; i < nb; i++)
+        {
+            Voie[j][i] = un_moins_alpha*Fixe[i] + alpha*Voie[j][i];
+        }
+    }
+    PRF_mark(&prfEcho, ETAPE_TRAITEMENT);
+    
+    PLN_merge(Voie[0], Voie[1], dst, nb);
+    PRF_mark(&prfEcho, ETAPE_FUSION);
+
+    LAT_loop(&latEcho, mesure_latence, src, dst, size); // remplace la sortie pendant une mesure
 
     /* Record the amount of actual data being sent */
     PIP_setWriterSize(&pipTx, PIP_getReaderSize(&pipRx));
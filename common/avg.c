@@ -0,0 +1,148 @@
+/*
+ *  ======== avg.c ========
+ *  Moving average of any length on planar channels (see avg.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "avg.h"
+
+#ifdef _TMS320C6X
+#define quantise(x) _spint((x) * AVG_ONE)
+#else
+#define restrict    __restrict
+#define quantise(x) ((Int)lrintf((x) * AVG_ONE))
+#endif
+
+/*
+ *  ======== AVG_init ========
+ *  Allocate the history of 'numChannels' channels in 'segid', for
+ *  windows of up to 'maxLength' samples, one output every 'decim'
+ *  inputs.  The window is maxLength until AVG_setLength().
+ */
+Bool AVG_init(AVG_Obj *avg, Int maxLength, Int decim, Int numChannels, Int segid)
+{
+    Int c;
+
+    if (maxLength < 1 || maxLength > AVG_MAXLENGTH || decim < 1 || numChannels < 1 ||
+        numChannels > AVG_MAXCHANNELS) {
+        return (FALSE);
+    }
+    avg->maxLength = maxLength;
+    avg->decim = decim;
+    avg->numChannels = numChannels;
+    for (c = 0; c < numChannels; c++) {
+        avg->hist[c] = MEM_alloc(segid, maxLength * sizeof(Int), 8);
+        if (avg->hist[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+    AVG_reset(avg);
+
+    return (AVG_setLength(avg, maxLength));
+}
+
+/*
+ *  ======== AVG_setLength ========
+ *  Average the last 'length' samples from now on.  The running sums are
+ *  recomputed from the history, once.
+ */
+Bool AVG_setLength(AVG_Obj *avg, Int length)
+{
+    Int c, k, i;
+    Uns s;
+
+    if (length < 1 || length > avg->maxLength) {
+        return (FALSE);
+    }
+    avg->length = length;
+    avg->scale = 1.0f / ((Float)length * AVG_ONE);
+    for (c = 0; c < avg->numChannels; c++) {
+        for (s = 0, i = avg->pos[c], k = 0; k < length; k++) {
+            i = i == 0 ? avg->maxLength - 1 : i - 1;
+            s += (Uns)avg->hist[c][i];
+        }
+        avg->sum[c] = s;
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== AVG_reset ========
+ *  Clear the history of every channel.
+ */
+Void AVG_reset(AVG_Obj *avg)
+{
+    Int c;
+
+    for (c = 0; c < avg->numChannels; c++) {
+        memset(avg->hist[c], 0, avg->maxLength * sizeof(Int));
+        avg->pos[c] = 0;
+        avg->sum[c] = 0;
+        avg->phase[c] = 0;
+    }
+}
+
+/*
+ *  ======== AVG_apply ========
+ *  Average 'n' samples of channel 'ch' from 'in' into 'out', which may
+ *  be the same array, and return the number of outputs: n, or about
+ *  n / decim with decimation.
+ */
+Int AVG_apply(AVG_Obj *avg, Int ch, const Float *in, Float *out, Int n)
+{
+    Int *restrict w = avg->hist[ch];
+    Int wr = avg->pos[ch], rd = wr - avg->length, phase = avg->phase[ch];
+    Int i = 0, m = 0, k, end, q;
+    Uns sum = avg->sum[ch];
+    Float scale = avg->scale;
+
+    if (rd < 0) {
+        rd += avg->maxLength;
+    }
+
+    /* in runs that wrap around neither the write nor the read index */
+    while (i < n) {
+        end = i + (avg->maxLength - wr < avg->maxLength - rd ? avg->maxLength - wr : avg->maxLength - rd);
+        if (end > n) {
+            end = n;
+        }
+        if (avg->decim == 1) {
+            for (k = 0; i + k < end; k++) {
+                q = quantise(in[i + k]);
+                sum += (Uns)q - (Uns)w[rd + k];
+                w[wr + k] = q;
+                out[i + k] = (Int)sum * scale;
+            }
+            m = end;
+        }
+        else {
+            for (k = 0; i + k < end; k++) {
+                q = quantise(in[i + k]);
+                sum += (Uns)q - (Uns)w[rd + k];
+                w[wr + k] = q;
+                if (++phase == avg->decim) {
+                    out[m++] = (Int)sum * scale;
+                    phase = 0;
+                }
+            }
+        }
+        wr += k;
+        rd += k;
+        i = end;
+        if (wr == avg->maxLength) {
+            wr = 0;
+        }
+        if (rd == avg->maxLength) {
+            rd = 0;
+        }
+    }
+    avg->pos[ch] = wr;
+    avg->sum[ch] = sum;
+    avg->phase[ch] = phase;
+
+    return (m);
+}
@@ -0,0 +1,45 @@
+/*
+ *  ======== avg.h ========
+ *  Moving average of any length on planar channels, at a constant cost
+ *  per sample.
+ *
+ *  Instead of summing the whole window for every output, each channel
+ *  keeps a running sum: it adds the input entering the window and
+ *  subtracts the one leaving it, an integrator and comb as in a first
+ *  order CIC filter.  The inputs are quantised to AVG_ONE steps (exact
+ *  for samples that come from 16-bit PCM) and the sum is an integer, so
+ *  it does not drift the way a float running sum would.  It is kept
+ *  modulo 2^32, which stays exact as long as the true sum fits, i.e. up
+ *  to AVG_MAXLENGTH samples at full scale.
+ *
+ *  The history holds the last maxLength inputs, so AVG_setLength() can
+ *  change the window without losing it.  With a decimation factor d,
+ *  AVG_apply() only writes every d-th average, e.g. for a level meter.
+ */
+#ifndef AVG_
+#define AVG_
+
+#include <std.h>
+
+#define AVG_MAXLENGTH   65536
+#define AVG_MAXCHANNELS 8
+#define AVG_ONE         32768.0f    /* quantisation steps in 1.0 */
+
+typedef struct AVG_Obj {
+    Int         maxLength;
+    Int         length;             /* samples averaged */
+    Int         decim;              /* one output every decim inputs */
+    Int         numChannels;
+    Float       scale;              /* 1 / (length * AVG_ONE) */
+    Int         *hist[AVG_MAXCHANNELS]; /* circular, last maxLength quantised inputs */
+    Int         pos[AVG_MAXCHANNELS];   /* where the next input of each channel goes */
+    Uns         sum[AVG_MAXCHANNELS];   /* of the last length inputs, modulo 2^32 */
+    Int         phase[AVG_MAXCHANNELS]; /* inputs since the last output */
+} AVG_Obj;
+
+extern Bool AVG_init(AVG_Obj *avg, Int maxLength, Int decim, Int numChannels, Int segid);
+extern Bool AVG_setLength(AVG_Obj *avg, Int length);
+extern Int AVG_apply(AVG_Obj *avg, Int ch, const Float *in, Float *out, Int n);
+extern Void AVG_reset(AVG_Obj *avg);
+
+#endif /* AVG_ */
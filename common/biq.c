@@ -0,0 +1,614 @@
+/*
+ *  ======== biq.c ========
+ *  Cascade of biquad sections on planar channels (see biq.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "biq.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#ifdef _TMS320C6X
+#define barrier()
+#else
+#define barrier()   __sync_synchronize()
+#endif
+
+#define PI  3.14159265358979
+
+/* unroll the section loop of a fused cascade, so that its state is in registers */
+#if defined(__GNUC__) && __GNUC__ >= 8
+#define UNROLL      _Pragma("GCC unroll 8")
+#else
+#define UNROLL
+#endif
+
+/* vectors of BIQ_BLOCK floats in the matrix of a blocked section */
+#define M_S1    0               /* y: weights of s1 */
+#define M_S2    1               /* y: weights of s2 */
+#define M_X     2               /* y: weights of x[j], j = 0..BIQ_BLOCK-1 */
+#define M_P1    (2 + BIQ_BLOCK) /* s'': weights of s1 */
+#define M_P2    (3 + BIQ_BLOCK) /* s'': weights of s2 */
+#define M_K     (4 + BIQ_BLOCK) /* s'': weights of x[j] */
+
+/*
+ *  ======== cascadeN ========
+ *  NS sections on two channels, each sample through all of them before
+ *  the next: section2() with the whole cascade in registers, one pass
+ *  over the block instead of NS.  BIQ_setNumSections() looks the count
+ *  up in cascades[]; only the count of Exercice2 has a kernel, the
+ *  others (1 and 2 sections gain nothing) run section by section.
+ */
+#define BIQ_CASCADE(NS) \
+static Void cascade##NS(const BIQ_Coefs *k, Float *restrict sa, Float *restrict sb, Float *restrict xa, \
+    Float *restrict xb, Int n) \
+{ \
+    Float a[2 * NS], b[2 * NS], x, u, y; \
+    Int i, s; \
+ \
+    for (s = 0; s < 2 * NS; s++) { \
+        a[s] = sa[s]; \
+        b[s] = sb[s]; \
+    } \
+    for (i = 0; i < n; i++) { \
+        x = xa[i]; \
+        u = xb[i]; \
+        UNROLL \
+        for (s = 0; s < NS; s++) { \
+            y = k[s].b0 * x + a[2 * s]; \
+            a[2 * s] = k[s].b1 * x - k[s].a1 * y + a[2 * s + 1]; \
+            a[2 * s + 1] = k[s].b2 * x - k[s].a2 * y; \
+            x = y; \
+ \
+            y = k[s].b0 * u + b[2 * s]; \
+            b[2 * s] = k[s].b1 * u - k[s].a1 * y + b[2 * s + 1]; \
+            b[2 * s + 1] = k[s].b2 * u - k[s].a2 * y; \
+            u = y; \
+        } \
+        xa[i] = x; \
+        xb[i] = u; \
+    } \
+    for (s = 0; s < 2 * NS; s++) { \
+        sa[s] = a[s]; \
+        sb[s] = b[s]; \
+    } \
+}
+
+BIQ_CASCADE(3)
+
+static const struct {
+    Int         sections;
+    BIQ_Cascade kernel;
+} cascades[] = {
+    { 3, cascade3 }
+};
+
+#define NUMCASCADES (sizeof(cascades) / sizeof(cascades[0]))
+
+/*
+ *  ======== BIQ_init ========
+ *  Allocate the coefficients and the state of up to 'maxSections'
+ *  sections on 'numChannels' channels in 'segid'.  No section is in use
+ *  until BIQ_setNumSections(): the cascade passes its input through.
+ */
+Bool BIQ_init(BIQ_Obj *biq, Int maxSections, Int numChannels, Int segid)
+{
+    Int c, s;
+
+    if (maxSections < 1 || maxSections > BIQ_MAXSECTIONS || numChannels < 1 ||
+        numChannels > BIQ_MAXCHANNELS) {
+        return (FALSE);
+    }
+    biq->maxSections = maxSections;
+    biq->numSections = 0;
+    biq->numChannels = numChannels;
+    biq->cascade = NULL;
+
+    biq->coefs = MEM_alloc(segid, maxSections * sizeof(BIQ_Coefs), 8);
+    biq->target = MEM_alloc(segid, maxSections * sizeof(BIQ_Coefs), 8);
+    biq->ramp = MEM_calloc(segid, maxSections * sizeof(Bool), 8);
+    biq->blocked = MEM_calloc(segid, maxSections * sizeof(Bool), 8);
+    biq->matrix = MEM_alloc(segid, maxSections * BIQ_MATRIX * sizeof(Float), 16);
+    if (biq->coefs == MEM_ILLEGAL || biq->target == MEM_ILLEGAL || biq->ramp == MEM_ILLEGAL ||
+        biq->blocked == MEM_ILLEGAL || biq->matrix == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (c = 0; c < numChannels; c++) {
+        biq->state[c] = MEM_alloc(segid, 2 * maxSections * sizeof(Float), 8);
+        if (biq->state[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+    for (s = 0; s < maxSections; s++) {
+        BIQ_setSection(biq, s, 1.0, 0.0, 0.0, 1.0, 0.0, 0.0);
+    }
+    BIQ_reset(biq);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== blockMatrix ========
+ *  Weights of a block of BIQ_BLOCK samples of the section 'k' (see
+ *  biq.h), into 'm'.
+ */
+static Void blockMatrix(const BIQ_Coefs *k, Float *m)
+{
+    Double a[2][2], p[2][2], v[BIQ_BLOCK][2], t0, t1;
+    Int i, j;
+
+    a[0][0] = -k->a1;
+    a[0][1] = 1.0;
+    a[1][0] = -k->a2;
+    a[1][1] = 0.0;
+    p[0][0] = p[1][1] = 1.0;
+    p[0][1] = p[1][0] = 0.0;
+    v[0][0] = k->b1 - (Double)k->a1 * k->b0;
+    v[0][1] = k->b2 - (Double)k->a2 * k->b0;
+    memset(m, 0, BIQ_MATRIX * sizeof(Float));
+
+    /* p = A^i, v[i] = A^i B */
+    for (i = 0; i < BIQ_BLOCK; i++) {
+        m[M_S1 * BIQ_BLOCK + i] = p[0][0];
+        m[M_S2 * BIQ_BLOCK + i] = p[0][1];
+        for (j = 0; j < 2; j++) {
+            t0 = a[0][0] * p[0][j] + a[0][1] * p[1][j];
+            t1 = a[1][0] * p[0][j] + a[1][1] * p[1][j];
+            p[0][j] = t0;
+            p[1][j] = t1;
+        }
+        if (i + 1 < BIQ_BLOCK) {
+            v[i + 1][0] = a[0][0] * v[i][0] + a[0][1] * v[i][1];
+            v[i + 1][1] = a[1][0] * v[i][0] + a[1][1] * v[i][1];
+        }
+    }
+    m[M_P1 * BIQ_BLOCK] = p[0][0];
+    m[M_P1 * BIQ_BLOCK + 1] = p[1][0];
+    m[M_P2 * BIQ_BLOCK] = p[0][1];
+    m[M_P2 * BIQ_BLOCK + 1] = p[1][1];
+
+    for (j = 0; j < BIQ_BLOCK; j++) {
+        m[(M_X + j) * BIQ_BLOCK + j] = k->b0;
+        for (i = j + 1; i < BIQ_BLOCK; i++) {
+            m[(M_X + j) * BIQ_BLOCK + i] = v[i - 1 - j][0];
+        }
+        m[(M_K + j) * BIQ_BLOCK] = v[BIQ_BLOCK - 1 - j][0];
+        m[(M_K + j) * BIQ_BLOCK + 1] = v[BIQ_BLOCK - 1 - j][1];
+    }
+}
+
+/*
+ *  ======== BIQ_setSection ========
+ *  Coefficients of section 's', as they come from a design, normalised
+ *  here by a0.  The state is kept.
+ */
+Bool BIQ_setSection(BIQ_Obj *biq, Int s, Double b0, Double b1, Double b2, Double a0, Double a1, Double a2)
+{
+    BIQ_Coefs coefs;
+
+    if (a0 == 0.0) {
+        return (FALSE);
+    }
+    coefs.b0 = b0 / a0;
+    coefs.b1 = b1 / a0;
+    coefs.b2 = b2 / a0;
+    coefs.a1 = a1 / a0;
+    coefs.a2 = a2 / a0;
+
+    return (BIQ_setCoefs(biq, s, &coefs));
+}
+
+/*
+ *  ======== BIQ_setCoefs ========
+ *  Normalised coefficients of section 's' (from BIQ_design() or a
+ *  table), from the next sample on.  The state is kept.
+ */
+Bool BIQ_setCoefs(BIQ_Obj *biq, Int s, const BIQ_Coefs *coefs)
+{
+    if (s < 0 || s >= biq->maxSections) {
+        return (FALSE);
+    }
+    biq->coefs[s] = *coefs;
+    if (biq->blocked[s]) {
+        blockMatrix(coefs, &biq->matrix[s * BIQ_MATRIX]);
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== BIQ_rampCoefs ========
+ *  Same as BIQ_setCoefs() over the next block.  FALSE if section 's' has
+ *  not finished its previous ramp.
+ */
+Bool BIQ_rampCoefs(BIQ_Obj *biq, Int s, const BIQ_Coefs *coefs)
+{
+    if (s < 0 || s >= biq->maxSections || biq->ramp[s]) {
+        return (FALSE);
+    }
+    biq->target[s] = *coefs;
+    /* target is not volatile: the flag must not be set before it is written */
+    barrier();
+    biq->ramp[s] = TRUE;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== BIQ_setNumSections ========
+ *  Run sections 0 to numSections - 1.  A section brought back into use
+ *  starts from the state it was left in.  A stereo cascade of a count
+ *  in cascades[] gets its fused kernel.
+ */
+Bool BIQ_setNumSections(BIQ_Obj *biq, Int numSections)
+{
+    Uns i;
+
+    if (numSections < 0 || numSections > biq->maxSections) {
+        return (FALSE);
+    }
+    biq->numSections = numSections;
+    biq->cascade = NULL;
+    for (i = 0; i < NUMCASCADES; i++) {
+        if (cascades[i].sections == numSections && biq->numChannels == 2) {
+            biq->cascade = cascades[i].kernel;
+        }
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== BIQ_setBlocked ========
+ *  Run section 's' by blocks of BIQ_BLOCK samples or sample by sample,
+ *  from the next BIQ_apply() on, from the thread that calls it.
+ */
+Bool BIQ_setBlocked(BIQ_Obj *biq, Int s, Bool blocked)
+{
+    if (s < 0 || s >= biq->maxSections) {
+        return (FALSE);
+    }
+    if (blocked && !biq->blocked[s]) {
+        blockMatrix(&biq->coefs[s], &biq->matrix[s * BIQ_MATRIX]);
+    }
+    biq->blocked[s] = blocked;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== BIQ_reset ========
+ *  Clear the state of every section and channel.
+ */
+Void BIQ_reset(BIQ_Obj *biq)
+{
+    Int c;
+
+    for (c = 0; c < biq->numChannels; c++) {
+        memset(biq->state[c], 0, 2 * biq->maxSections * sizeof(Float));
+    }
+}
+
+/*
+ *  ======== section2 ========
+ *  One section on two channels: independent recursions in one loop.
+ */
+static Void section2(const BIQ_Coefs *k, Float *restrict sa, Float *restrict sb, Float *restrict xa,
+    Float *restrict xb, Int n)
+{
+    Float b0 = k->b0, b1 = k->b1, b2 = k->b2, a1 = k->a1, a2 = k->a2;
+    Float a_1 = sa[0], a_2 = sa[1], b_1 = sb[0], b_2 = sb[1];
+    Float x, y;
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        x = xa[i];
+        y = b0 * x + a_1;
+        a_1 = b1 * x - a1 * y + a_2;
+        a_2 = b2 * x - a2 * y;
+        xa[i] = y;
+
+        x = xb[i];
+        y = b0 * x + b_1;
+        b_1 = b1 * x - a1 * y + b_2;
+        b_2 = b2 * x - a2 * y;
+        xb[i] = y;
+    }
+    sa[0] = a_1;
+    sa[1] = a_2;
+    sb[0] = b_1;
+    sb[1] = b_2;
+}
+
+/*
+ *  ======== ramp2 ========
+ *  section2() with the coefficients moving from 'k' by 'd' per sample.
+ */
+static Void ramp2(const BIQ_Coefs *k, const BIQ_Coefs *d, Float *restrict sa, Float *restrict sb,
+    Float *restrict xa, Float *restrict xb, Int n)
+{
+    Float b0 = k->b0, b1 = k->b1, b2 = k->b2, a1 = k->a1, a2 = k->a2;
+    Float a_1 = sa[0], a_2 = sa[1], b_1 = sb[0], b_2 = sb[1];
+    Float x, y;
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        b0 += d->b0;
+        b1 += d->b1;
+        b2 += d->b2;
+        a1 += d->a1;
+        a2 += d->a2;
+
+        x = xa[i];
+        y = b0 * x + a_1;
+        a_1 = b1 * x - a1 * y + a_2;
+        a_2 = b2 * x - a2 * y;
+        xa[i] = y;
+
+        x = xb[i];
+        y = b0 * x + b_1;
+        b_1 = b1 * x - a1 * y + b_2;
+        b_2 = b2 * x - a2 * y;
+        xb[i] = y;
+    }
+    sa[0] = a_1;
+    sa[1] = a_2;
+    sb[0] = b_1;
+    sb[1] = b_2;
+}
+
+/*
+ *  ======== section1 ========
+ *  One section on one channel.
+ */
+static Void section1(const BIQ_Coefs *k, Float *restrict st, Float *restrict x, Int n)
+{
+    Float b0 = k->b0, b1 = k->b1, b2 = k->b2, a1 = k->a1, a2 = k->a2;
+    Float s1 = st[0], s2 = st[1];
+    Float in, y;
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        in = x[i];
+        y = b0 * in + s1;
+        s1 = b1 * in - a1 * y + s2;
+        s2 = b2 * in - a2 * y;
+        x[i] = y;
+    }
+    st[0] = s1;
+    st[1] = s2;
+}
+
+/*
+ *  ======== ramp1 ========
+ *  section1() with the coefficients moving from 'k' by 'd' per sample.
+ */
+static Void ramp1(const BIQ_Coefs *k, const BIQ_Coefs *d, Float *restrict st, Float *restrict x, Int n)
+{
+    Float b0 = k->b0, b1 = k->b1, b2 = k->b2, a1 = k->a1, a2 = k->a2;
+    Float s1 = st[0], s2 = st[1];
+    Float in, y;
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        b0 += d->b0;
+        b1 += d->b1;
+        b2 += d->b2;
+        a1 += d->a1;
+        a2 += d->a2;
+
+        in = x[i];
+        y = b0 * in + s1;
+        s1 = b1 * in - a1 * y + s2;
+        s2 = b2 * in - a2 * y;
+        x[i] = y;
+    }
+    st[0] = s1;
+    st[1] = s2;
+}
+
+#ifdef __SSE2__
+/* vector 'r' of the weights times 'v', for BIQ_BLOCK = 4 */
+#define MUL(r, v)   _mm_mul_ps(_mm_load_ps(&m[(r) * 4]), v)
+
+/*
+ *  ======== block1 ========
+ *  section1() by blocks of BIQ_BLOCK samples with the weights 'm', the
+ *  last n % BIQ_BLOCK samples one by one.
+ */
+static Void block1(const BIQ_Coefs *k, const Float *restrict m, Float *restrict st, Float *restrict x, Int n)
+{
+    __m128 s1 = _mm_set1_ps(st[0]), s2 = _mm_set1_ps(st[1]);
+    __m128 x0, x1, x2, x3, y, s;
+    Int i;
+
+    for (i = 0; i + BIQ_BLOCK <= n; i += BIQ_BLOCK) {
+        x0 = _mm_set1_ps(x[i]);
+        x1 = _mm_set1_ps(x[i + 1]);
+        x2 = _mm_set1_ps(x[i + 2]);
+        x3 = _mm_set1_ps(x[i + 3]);
+
+        /* the inputs first: only the last two products wait for the state */
+        y = _mm_add_ps(_mm_add_ps(MUL(M_X, x0), MUL(M_X + 1, x1)), _mm_add_ps(MUL(M_X + 2, x2), MUL(M_X + 3, x3)));
+        s = _mm_add_ps(_mm_add_ps(MUL(M_K, x0), MUL(M_K + 1, x1)), _mm_add_ps(MUL(M_K + 2, x2), MUL(M_K + 3, x3)));
+        y = _mm_add_ps(_mm_add_ps(y, MUL(M_S1, s1)), MUL(M_S2, s2));
+        s = _mm_add_ps(_mm_add_ps(s, MUL(M_P1, s1)), MUL(M_P2, s2));
+        _mm_storeu_ps(&x[i], y);
+        s1 = _mm_shuffle_ps(s, s, 0x00);
+        s2 = _mm_shuffle_ps(s, s, 0x55);
+    }
+    st[0] = _mm_cvtss_f32(s1);
+    st[1] = _mm_cvtss_f32(s2);
+    section1(k, st, x + i, n - i);
+}
+#else
+/*
+ *  ======== block1 ========
+ *  section1() by blocks of BIQ_BLOCK samples with the weights 'm', the
+ *  last n % BIQ_BLOCK samples one by one.  The outputs of a block are
+ *  independent of each other.
+ */
+static Void block1(const BIQ_Coefs *k, const Float *restrict m, Float *restrict st, Float *restrict x, Int n)
+{
+    Float s1 = st[0], s2 = st[1], y[BIQ_BLOCK], t1, t2;
+    Int i, j, l;
+
+    for (i = 0; i + BIQ_BLOCK <= n; i += BIQ_BLOCK) {
+        for (l = 0; l < BIQ_BLOCK; l++) {
+            y[l] = m[M_S1 * BIQ_BLOCK + l] * s1 + m[M_S2 * BIQ_BLOCK + l] * s2;
+            for (j = 0; j <= l; j++) {
+                y[l] += m[(M_X + j) * BIQ_BLOCK + l] * x[i + j];
+            }
+        }
+        t1 = m[M_P1 * BIQ_BLOCK] * s1 + m[M_P2 * BIQ_BLOCK] * s2;
+        t2 = m[M_P1 * BIQ_BLOCK + 1] * s1 + m[M_P2 * BIQ_BLOCK + 1] * s2;
+        for (j = 0; j < BIQ_BLOCK; j++) {
+            t1 += m[(M_K + j) * BIQ_BLOCK] * x[i + j];
+            t2 += m[(M_K + j) * BIQ_BLOCK + 1] * x[i + j];
+        }
+        s1 = t1;
+        s2 = t2;
+        for (l = 0; l < BIQ_BLOCK; l++) {
+            x[i + l] = y[l];
+        }
+    }
+    st[0] = s1;
+    st[1] = s2;
+    section1(k, st, x + i, n - i);
+}
+#endif
+
+/*
+ *  ======== BIQ_apply ========
+ *  Filter 'n' samples of each channel of 'ch' in place.  A section with
+ *  a ramp pending gets its new coefficients over these samples.
+ */
+Void BIQ_apply(BIQ_Obj *biq, Float *ch[], Int n)
+{
+    BIQ_Coefs *k, *t, d;
+    Float step;
+    Int c, s;
+
+    if (biq->cascade != NULL) {
+        for (s = 0; s < biq->numSections && !biq->ramp[s] && !biq->blocked[s]; s++) {
+        }
+        if (s == biq->numSections) {
+            biq->cascade(biq->coefs, biq->state[0], biq->state[1], ch[0], ch[1], n);
+            return;
+        }
+    }
+    for (s = 0; s < biq->numSections; s++) {
+        k = &biq->coefs[s];
+        if (biq->blocked[s] && (!biq->ramp[s] || n < 1)) {
+            for (c = 0; c < biq->numChannels; c++) {
+                block1(k, &biq->matrix[s * BIQ_MATRIX], &biq->state[c][2 * s], ch[c], n);
+            }
+            continue;
+        }
+        if (!biq->ramp[s] || n < 1) {
+            for (c = 0; c + 1 < biq->numChannels; c += 2) {
+                section2(k, &biq->state[c][2 * s], &biq->state[c + 1][2 * s], ch[c], ch[c + 1], n);
+            }
+            if (c < biq->numChannels) {
+                section1(k, &biq->state[c][2 * s], ch[c], n);
+            }
+            continue;
+        }
+
+        /* nor the target read before the flag */
+        barrier();
+        t = &biq->target[s];
+        step = 1.0f / n;
+        d.b0 = (t->b0 - k->b0) * step;
+        d.b1 = (t->b1 - k->b1) * step;
+        d.b2 = (t->b2 - k->b2) * step;
+        d.a1 = (t->a1 - k->a1) * step;
+        d.a2 = (t->a2 - k->a2) * step;
+        for (c = 0; c + 1 < biq->numChannels; c += 2) {
+            ramp2(k, &d, &biq->state[c][2 * s], &biq->state[c + 1][2 * s], ch[c], ch[c + 1], n);
+        }
+        if (c < biq->numChannels) {
+            ramp1(k, &d, &biq->state[c][2 * s], ch[c], n);
+        }
+        *k = *t;
+        if (biq->blocked[s]) {
+            blockMatrix(k, &biq->matrix[s * BIQ_MATRIX]);
+        }
+        barrier();
+        biq->ramp[s] = FALSE;
+    }
+}
+
+/*
+ *  ======== BIQ_design ========
+ *  Section of 'type' at 'freq' times the sampling frequency (0 to 0.5):
+ *  the centre of a peak, the corner of a shelf, the cut-off of a
+ *  low/high-pass or the half-turn of the phase of an all-pass.  'gainDb'
+ *  is the gain of a peak or shelf (ignored by the others), 'q' its
+ *  quality factor (a shelf slope of 1 for q = 1 / sqrt(2)).
+ */
+Void BIQ_design(BIQ_Coefs *coefs, Int type, Double freq, Double gainDb, Double q)
+{
+    Double A = pow(10.0, gainDb / 40.0), w = 2.0 * PI * freq;
+    Double cw = cos(w), alpha = sin(w) / (2.0 * q), sa = 2.0 * sqrt(A) * alpha;
+    Double b0, b1, b2, a0, a1, a2;
+
+    switch (type) {
+        case BIQ_LOWSHELF:
+            b0 = A * ((A + 1) - (A - 1) * cw + sa);
+            b1 = 2 * A * ((A - 1) - (A + 1) * cw);
+            b2 = A * ((A + 1) - (A - 1) * cw - sa);
+            a0 = (A + 1) + (A - 1) * cw + sa;
+            a1 = -2 * ((A - 1) + (A + 1) * cw);
+            a2 = (A + 1) + (A - 1) * cw - sa;
+            break;
+        case BIQ_HIGHSHELF:
+            b0 = A * ((A + 1) + (A - 1) * cw + sa);
+            b1 = -2 * A * ((A - 1) + (A + 1) * cw);
+            b2 = A * ((A + 1) + (A - 1) * cw - sa);
+            a0 = (A + 1) - (A - 1) * cw + sa;
+            a1 = 2 * ((A - 1) - (A + 1) * cw);
+            a2 = (A + 1) - (A - 1) * cw - sa;
+            break;
+        case BIQ_LOWPASS:
+            b0 = b2 = (1 - cw) / 2;
+            b1 = 1 - cw;
+            a0 = 1 + alpha;
+            a1 = -2 * cw;
+            a2 = 1 - alpha;
+            break;
+        case BIQ_HIGHPASS:
+            b0 = b2 = (1 + cw) / 2;
+            b1 = -(1 + cw);
+            a0 = 1 + alpha;
+            a1 = -2 * cw;
+            a2 = 1 - alpha;
+            break;
+        case BIQ_ALLPASS:
+            b0 = a2 = 1 - alpha;
+            b1 = a1 = -2 * cw;
+            b2 = a0 = 1 + alpha;
+            break;
+        default:
+            b0 = 1 + alpha * A;
+            b1 = -2 * cw;
+            b2 = 1 - alpha * A;
+            a0 = 1 + alpha / A;
+            a1 = -2 * cw;
+            a2 = 1 - alpha / A;
+            break;
+    }
+    coefs->b0 = b0 / a0;
+    coefs->b1 = b1 / a0;
+    coefs->b2 = b2 / a0;
+    coefs->a1 = a1 / a0;
+    coefs->a2 = a2 / a0;
+}
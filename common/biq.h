@@ -0,0 +1,109 @@
+/*
+ *  ======== biq.h ========
+ *  Cascade of biquad sections on planar channels.
+ *
+ *  Each section is y = b0 x + b1 x[-1] + b2 x[-2] - a1 y[-1] - a2 y[-2],
+ *  its coefficients normalised by a0 once, when they are set, so that
+ *  the loop has no division.  It runs in transposed direct form II:
+ *
+ *      y  = b0 x + s1
+ *      s1 = b1 x - a1 y + s2
+ *      s2 = b2 x - a2 y
+ *
+ *  which keeps only the two state words s1, s2 per section and channel,
+ *  instead of buffers of past inputs and outputs.  A first-order section
+ *  has b2 = a2 = 0.  BIQ_apply() runs the whole block through one section
+ *  after the other, two channels at a time in the same loop, so that
+ *  their recursions overlap and the state stays in registers.
+ *
+ *  A stereo cascade of a section count listed in biq.c (Exercice2's 3)
+ *  has a kernel of its own, picked by BIQ_setNumSections(): each sample
+ *  goes through all the sections in one pass over the block, with the
+ *  coefficients and the state of every section in registers, and the
+ *  same operations in the same order, so the output is the same.  It
+ *  runs while no section is ramping or blocked (bench -k).
+ *
+ *  BIQ_rampCoefs() changes a section without a click: the next
+ *  BIQ_apply() moves its coefficients linearly, sample by sample, from
+ *  the old set to the new one over the block.  The stability region of
+ *  (a1, a2) is a triangle, so every set in between is stable too.  It
+ *  may be called from a thread of lower priority than BIQ_apply()'s:
+ *  the new set is published by a flag set after it is written and
+ *  cleared once the ramp is done, and a section still ramping refuses
+ *  a new set (FALSE), to be retried later.
+ *
+ *  A section can also run by blocks (BIQ_setBlocked()), for a single
+ *  channel where nothing else overlaps its recursion.  In state-space
+ *  form, with s = (s1, s2),
+ *
+ *      s' = A s + B x,  y = s1 + b0 x,   A = | -a1  1 |,  B = | b1 - a1 b0 |
+ *                                            | -a2  0 |       | b2 - a2 b0 |
+ *
+ *  so that the BIQ_BLOCK outputs of a block and the state after it are
+ *  linear in the state before it and the BIQ_BLOCK inputs:
+ *
+ *      y[i] = (A^i s)1 + b0 x[i] + sum((A^(i-1-j) B)1 x[j], j < i)
+ *      s''  = A^BIQ_BLOCK s + sum(A^(BIQ_BLOCK-1-j) B x[j])
+ *
+ *  The powers of A are computed in double precision whenever the
+ *  coefficients change, and a block is then a few vector multiply-adds
+ *  (SSE on the host): the only serial dependency left is the state
+ *  from one block to the next, instead of from one sample to the next.
+ *  The state is the same as sample by sample, so a section can switch
+ *  mode, or ramp, between any two blocks.  The result differs from the
+ *  sample-by-sample one by rounding only (bench -i measures it).
+ *
+ *  BIQ_design() computes the usual peaking and shelving equaliser,
+ *  low/high-pass and all-pass sections (bilinear transform, "Audio EQ Cookbook"), in
+ *  double precision: call it when a control changes, not per block.
+ */
+#ifndef BIQ_
+#define BIQ_
+
+#include <std.h>
+
+#define BIQ_MAXSECTIONS 64
+#define BIQ_MAXCHANNELS 8
+#define BIQ_BLOCK       4           /* samples per block of a blocked section */
+#define BIQ_MATRIX      (12 * BIQ_BLOCK)
+
+#define BIQ_PEAK        0
+#define BIQ_LOWSHELF    1
+#define BIQ_HIGHSHELF   2
+#define BIQ_LOWPASS     3
+#define BIQ_HIGHPASS    4
+#define BIQ_ALLPASS     5
+
+typedef struct BIQ_Coefs {
+    Float       b0, b1, b2;
+    Float       a1, a2;                 /* a0 = 1 */
+} BIQ_Coefs;
+
+/* 'n' samples of channels 'xa', 'xb' through sections 'k', states 'sa', 'sb' (see biq.c) */
+typedef Void (*BIQ_Cascade)(const BIQ_Coefs *k, Float *sa, Float *sb, Float *xa, Float *xb, Int n);
+
+typedef struct BIQ_Obj {
+    Int         maxSections;
+    Int         numSections;            /* in use */
+    Int         numChannels;
+    BIQ_Coefs   *coefs;
+    BIQ_Coefs   *target;                /* of the next ramp */
+    volatile Bool *ramp;                /* TRUE when target is published */
+    Bool        *blocked;               /* run by blocks */
+    Float       *matrix;                /* of each blocked section, BIQ_MATRIX floats */
+    Float       *state[BIQ_MAXCHANNELS]; /* s1, s2 of each section */
+    BIQ_Cascade cascade;                /* fused kernel for numSections on 2 channels, or NULL */
+} BIQ_Obj;
+
+extern Bool BIQ_init(BIQ_Obj *biq, Int maxSections, Int numChannels, Int segid);
+extern Bool BIQ_setSection(BIQ_Obj *biq, Int s, Double b0, Double b1, Double b2, Double a0, Double a1,
+    Double a2);
+extern Bool BIQ_setCoefs(BIQ_Obj *biq, Int s, const BIQ_Coefs *coefs);
+extern Bool BIQ_rampCoefs(BIQ_Obj *biq, Int s, const BIQ_Coefs *coefs);
+extern Bool BIQ_setNumSections(BIQ_Obj *biq, Int numSections);
+extern Bool BIQ_setBlocked(BIQ_Obj *biq, Int s, Bool blocked);
+extern Void BIQ_apply(BIQ_Obj *biq, Float *ch[], Int n);
+extern Void BIQ_reset(BIQ_Obj *biq);
+extern Void BIQ_design(BIQ_Coefs *coefs, Int type, Double freq, Double gainDb, Double q);
+
+#endif /* BIQ_ */
@@ -0,0 +1,36 @@
+/*
+ *  ======== blk.c ========
+ *  Block configuration chosen at start-up (see blk.h).
+ */
+#include <std.h>
+#include <pip.h>
+
+#include "blk.h"
+
+/* pipRx/pipTx of exercice3.cdb: framesize 0x40 words, 2 frames */
+BLK_Config BLK_config = { 128, 2, FALSE };
+
+/*
+ *  ======== BLK_check ========
+ *  TRUE if 'cfg' is a block configuration the applications support.
+ */
+Bool BLK_check(BLK_Config *cfg)
+{
+    return (cfg->size >= BLK_MINSIZE && cfg->size <= BLK_MAXSIZE && (cfg->size & 1) == 0 &&
+        cfg->numFrames >= 2);
+}
+
+/*
+ *  ======== BLK_txPrimeCount ========
+ *  Number of frames of silence to give PIO_txStart().
+ */
+Int BLK_txPrimeCount(PIP_Obj *pipTx)
+{
+    Int n = PIP_getWriterNumFrames(pipTx);
+
+    if (BLK_config.lowLatency && n > BLK_MINPRIME) {
+        n = BLK_MINPRIME;
+    }
+
+    return (n);
+}
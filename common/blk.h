@@ -0,0 +1,43 @@
+/*
+ *  ======== blk.h ========
+ *  Block configuration chosen at start-up.
+ *
+ *  'size' is the number of samples in a PIP frame, counted like LNGBUF
+ *  used to be (interleaved stereo 16-bit samples, i.e. twice the frame
+ *  size in words) and 'numFrames' the number of frames of pipRx and
+ *  pipTx.  The applications size their history and delay buffers from
+ *  BLK_config in main(), before the first frame.
+ *
+ *  On the DSK the frames of pipRx/pipTx are allocated by the
+ *  configuration, so BLK_config must be set to the framesize and
+ *  numframes of exercice3.cdb (the defaults match it).  The host build
+ *  configures the pipes from BLK_config instead.
+ *
+ *  By default PIO_txStart() primes every transmit frame with silence,
+ *  which adds numFrames frame periods between capture and playback.  In
+ *  low latency mode only BLK_MINPRIME frames are primed, the least the
+ *  double-buffered codec DMA needs to never run dry; the other frames
+ *  only absorb jitter of the SWI.
+ */
+#ifndef BLK_
+#define BLK_
+
+#include <std.h>
+#include <pip.h>
+
+#define BLK_MINSIZE     16
+#define BLK_MAXSIZE     1024
+#define BLK_MINPRIME    2
+
+typedef struct BLK_Config {
+    Int         size;           /* samples per frame, even, BLK_MINSIZE..BLK_MAXSIZE */
+    Int         numFrames;      /* frames per pipe, at least 2 */
+    Bool        lowLatency;     /* prime only BLK_MINPRIME transmit frames */
+} BLK_Config;
+
+extern BLK_Config BLK_config;
+
+extern Bool BLK_check(BLK_Config *cfg);
+extern Int BLK_txPrimeCount(PIP_Obj *pipTx);
+
+#endif /* BLK_ */
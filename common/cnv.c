@@ -0,0 +1,355 @@
+/*
+ *  ======== cnv.c ========
+ *  Convolution of planar channels, direct or by FFT (see cnv.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cnv.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ *  cost model: cycles per tap and output sample, per butterfly, per
+ *  complex multiply-add; measured with "bench -x" on the host, estimated
+ *  for the C67x
+ */
+#ifdef _TMS320C6X
+#define TAPCOST     0.5f            /* DSPF_sp_fir_gen() */
+#define BFLYCOST    5.0f
+#define MACCOST     2.0f
+#else
+#define TAPCOST     0.33f
+#define BFLYCOST    4.5f
+#define MACCOST     2.5f
+#endif
+
+/*
+ *  ======== fftCost ========
+ *  Modelled cycles per output sample of the FFT mode with 'parts'
+ *  partitions: two transforms and 'parts' spectra multiplied per block
+ *  of a channel pair.
+ */
+static Float fftCost(CNV_Obj *cnv, Int parts)
+{
+    Int n = cnv->fft.size;
+
+    return ((n * cnv->fft.log2Size * BFLYCOST + (Float)parts * n * MACCOST) / (2 * cnv->block));
+}
+
+/*
+ *  ======== crossover ========
+ *  Smallest tap count for which the model finds the FFT cheaper.
+ */
+static Int crossover(CNV_Obj *cnv)
+{
+    Int p, t;
+
+    for (p = 1; p <= cnv->maxParts; p++) {
+        t = (Int)(fftCost(cnv, p) / TAPCOST) + 1;
+        if (t <= p * cnv->block) {
+            return (t > (p - 1) * cnv->block ? t : (p - 1) * cnv->block + 1);
+        }
+    }
+
+    return (cnv->maxTaps + 1);
+}
+
+/*
+ *  ======== clear ========
+ *  Forget the inputs of the FFT mode.
+ */
+static Void clear(CNV_Obj *cnv)
+{
+    Int n = cnv->fft.size, q;
+
+    for (q = 0; q < (cnv->numChannels + 1) / 2; q++) {
+        memset(cnv->fdl[q], 0, cnv->maxParts * 2 * n * sizeof(Float));
+        memset(cnv->tail[q], 0, (n - cnv->block) * 2 * sizeof(Float));
+    }
+    cnv->fdlPos = 0;
+}
+
+/*
+ *  ======== CNV_init ========
+ *  Allocate in 'segid' the convolution of 'numChannels' channels by up
+ *  to 'maxTaps' taps, in blocks of 'block' samples.  It passes its input
+ *  through until CNV_setCoefs().
+ */
+Bool CNV_init(CNV_Obj *cnv, Int maxTaps, Int numChannels, Int block, Int segid)
+{
+    static const Float identity = 1.0f;
+    Int n, q;
+
+    if (maxTaps < 1 || maxTaps > CNV_MAXTAPS || numChannels < 1 || numChannels > FIR_MAXCHANNELS ||
+        block < 1) {
+        return (FALSE);
+    }
+    cnv->maxTaps = maxTaps;
+    cnv->numChannels = numChannels;
+    cnv->block = block;
+    cnv->maxParts = (maxTaps + block - 1) / block;
+
+    /* the FFT must hold a partition and a block without wrapping around */
+    for (n = FFT_MINSIZE; n < 2 * block; n *= 2) {
+    }
+    if (!FIR_init(&cnv->fir, maxTaps < FIR_MAXTAPS ? maxTaps : FIR_MAXTAPS, numChannels, block, segid) ||
+        !FFT_init(&cnv->fft, n, segid)) {
+        return (FALSE);
+    }
+    cnv->parts = MEM_alloc(segid, cnv->maxParts * 2 * n * sizeof(Float), 16);
+    cnv->work = MEM_alloc(segid, 2 * n * sizeof(Float), 16);
+    if (cnv->parts == MEM_ILLEGAL || cnv->work == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (q = 0; q < (numChannels + 1) / 2; q++) {
+        cnv->fdl[q] = MEM_alloc(segid, cnv->maxParts * 2 * n * sizeof(Float), 16);
+        cnv->tail[q] = MEM_alloc(segid, (n - block) * 2 * sizeof(Float), 8);
+        if (cnv->fdl[q] == MEM_ILLEGAL || cnv->tail[q] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+    cnv->crossover = crossover(cnv);
+    cnv->mode = CNV_DIRECT;
+    clear(cnv);
+
+    return (CNV_setCoefs(cnv, &identity, 1, CNV_DIRECT));
+}
+
+/*
+ *  ======== CNV_delete ========
+ *  Free what CNV_init() allocated in 'segid'.
+ */
+Void CNV_delete(CNV_Obj *cnv, Int segid)
+{
+    Int n = cnv->fft.size, q;
+
+    for (q = 0; q < (cnv->numChannels + 1) / 2; q++) {
+        MEM_free(segid, cnv->fdl[q], cnv->maxParts * 2 * n * sizeof(Float));
+        MEM_free(segid, cnv->tail[q], (n - cnv->block) * 2 * sizeof(Float));
+    }
+    MEM_free(segid, cnv->parts, cnv->maxParts * 2 * n * sizeof(Float));
+    MEM_free(segid, cnv->work, 2 * n * sizeof(Float));
+    FFT_delete(&cnv->fft, segid);
+    FIR_delete(&cnv->fir, segid);
+}
+
+/*
+ *  ======== CNV_setCoefs ========
+ *  Convolve with the 'numTaps' taps of 'h', h[0] weighing the newest
+ *  input, in 'mode' (CNV_AUTO, CNV_DIRECT or CNV_FFT).  Direct is only
+ *  possible up to FIR_MAXTAPS.
+ */
+Bool CNV_setCoefs(CNV_Obj *cnv, const Float *h, Int numTaps, Int mode)
+{
+    Int n = cnv->fft.size, b = cnv->block, p, j;
+    Float *part;
+
+    if (numTaps < 1 || numTaps > cnv->maxTaps) {
+        return (FALSE);
+    }
+    if (mode == CNV_AUTO) {
+        mode = numTaps >= cnv->crossover || numTaps > cnv->fir.maxTaps ? CNV_FFT : CNV_DIRECT;
+    }
+
+    if (mode == CNV_DIRECT) {
+        if (!FIR_setCoefs(&cnv->fir, h, numTaps)) {
+            return (FALSE);
+        }
+        if (cnv->mode != CNV_DIRECT) {
+            FIR_reset(&cnv->fir);
+        }
+    }
+    else {
+        cnv->numParts = (numTaps + b - 1) / b;
+        for (p = 0; p < cnv->numParts; p++) {
+            part = cnv->parts + p * 2 * n;
+            memset(part, 0, 2 * n * sizeof(Float));
+            for (j = 0; j < b && p * b + j < numTaps; j++) {
+                part[2 * j] = h[p * b + j] / n;
+            }
+            FFT_apply(&cnv->fft, part, FFT_FORWARD);
+        }
+        if (cnv->mode != CNV_FFT) {
+            clear(cnv);
+        }
+    }
+    cnv->mode = mode;
+    cnv->numTaps = numTaps;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== convolve ========
+ *  One block of the channel pair 'q', 'a' in the real part, 'b' (NULL
+ *  for none) in the imaginary part, in place.
+ */
+static Void convolve(CNV_Obj *cnv, Int q, Float *a, Float *b)
+{
+    Int n = cnv->fft.size, blk = cnv->block, keep = n - blk, p, j, k;
+    Float *x = cnv->fdl[q] + cnv->fdlPos * 2 * n;
+    Float *y = cnv->work;
+    const Float *h;
+    Float *z;
+
+    /* the last n inputs: the tail, then the block */
+    memcpy(x, cnv->tail[q], keep * 2 * sizeof(Float));
+    for (j = 0; j < blk; j++) {
+        x[2 * (keep + j)] = a[j];
+        x[2 * (keep + j) + 1] = b != NULL ? b[j] : 0.0f;
+    }
+    memcpy(cnv->tail[q], x + 2 * blk, keep * 2 * sizeof(Float));
+    FFT_apply(&cnv->fft, x, FFT_FORWARD);
+
+    /* sum of the spectra of the inputs p blocks ago times partition p */
+    memset(y, 0, 2 * n * sizeof(Float));
+    for (p = 0, k = cnv->fdlPos; p < cnv->numParts; p++, k = k > 0 ? k - 1 : cnv->maxParts - 1) {
+        z = cnv->fdl[q] + k * 2 * n;
+        h = cnv->parts + p * 2 * n;
+#ifdef __SSE2__
+        {
+            /* two complex numbers at a time: y += z * h */
+            const __m128 re = _mm_castsi128_ps(_mm_set_epi32(0, 0x80000000, 0, 0x80000000));
+
+            for (j = 0; j < 2 * n; j += 4) {
+                __m128 zj = _mm_load_ps(&z[j]);
+                __m128 hj = _mm_load_ps(&h[j]);
+
+                _mm_store_ps(&y[j], _mm_add_ps(_mm_load_ps(&y[j]), _mm_add_ps(
+                    _mm_mul_ps(zj, _mm_shuffle_ps(hj, hj, _MM_SHUFFLE(2, 2, 0, 0))),
+                    _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(zj, zj, _MM_SHUFFLE(2, 3, 0, 1)),
+                        _mm_shuffle_ps(hj, hj, _MM_SHUFFLE(3, 3, 1, 1))), re))));
+            }
+        }
+#else
+        for (j = 0; j < 2 * n; j += 2) {
+            y[j] += z[j] * h[j] - z[j + 1] * h[j + 1];
+            y[j + 1] += z[j] * h[j + 1] + z[j + 1] * h[j];
+        }
+#endif
+    }
+    FFT_apply(&cnv->fft, y, FFT_INVERSE);
+
+    /* the last block of the circular convolution is the linear one */
+    for (j = 0; j < blk; j++) {
+        a[j] = y[2 * (keep + j)];
+        if (b != NULL) {
+            b[j] = y[2 * (keep + j) + 1];
+        }
+    }
+}
+
+/*
+ *  ======== CNV_apply ========
+ *  Convolve a block of 'n' samples (the 'block' of CNV_init()) of each
+ *  channel of 'ch' in place.
+ */
+Void CNV_apply(CNV_Obj *cnv, Float *ch[], Int n)
+{
+    Int c;
+
+    if (cnv->mode == CNV_DIRECT) {
+        for (c = 0; c < cnv->numChannels; c++) {
+            FIR_apply(&cnv->fir, c, ch[c], ch[c], n);
+        }
+        return;
+    }
+    for (c = 0; c < cnv->numChannels; c += 2) {
+        convolve(cnv, c / 2, ch[c], c + 1 < cnv->numChannels ? ch[c + 1] : NULL);
+    }
+    cnv->fdlPos = cnv->fdlPos + 1 < cnv->maxParts ? cnv->fdlPos + 1 : 0;
+}
+
+/*
+ *  ======== get16 ======== get32 ========
+ *  Little-endian fields of a WAV header.
+ */
+static Uns get16(const unsigned char *p)
+{
+    return (p[0] | (p[1] << 8));
+}
+
+static LgUns get32(const unsigned char *p)
+{
+    return (p[0] | (p[1] << 8) | ((LgUns)p[2] << 16) | ((LgUns)p[3] << 24));
+}
+
+/*
+ *  ======== CNV_loadIR ========
+ *  Read the first channel of the data chunk of the WAV file 'path' into
+ *  'h', at most 'maxTaps' samples, full scale being 1.  Returns the
+ *  number of taps, 0 if the file cannot be read or is neither 16-bit
+ *  PCM nor 32-bit float (format tags 1 and 3, or WAVE_FORMAT_EXTENSIBLE
+ *  with the subformat GUID of either).
+ */
+Int CNV_loadIR(String path, Float *h, Int maxTaps)
+{
+    /* the GUID of a subformat is its format tag followed by these 14 bytes */
+    static const unsigned char guid[14] = {
+        0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71
+    };
+    unsigned char buf[40];
+    FILE *f = fopen(path, "rb");
+    LgUns size, len, data = 0;
+    Uns format = 0, channels = 0, bits = 0, u;
+    Int n = 0;
+    Float x;
+
+    if (f == NULL) {
+        return (0);
+    }
+    if (fread(buf, 1, 12, f) != 12 || memcmp(buf, "RIFF", 4) != 0 || memcmp(buf + 8, "WAVE", 4) != 0) {
+        fclose(f);
+        return (0);
+    }
+    while (fread(buf, 1, 8, f) == 8) {
+        size = get32(buf + 4);
+        len = 0;
+        if (memcmp(buf, "data", 4) == 0) {
+            data = size;
+            break;
+        }
+        if (memcmp(buf, "fmt ", 4) == 0 && size >= 16) {
+            len = size < sizeof(buf) ? size : sizeof(buf);
+            if (fread(buf, 1, len, f) != len) {
+                break;
+            }
+            format = get16(buf);
+            channels = get16(buf + 2);
+            bits = get16(buf + 14);
+            /* WAVE_FORMAT_EXTENSIBLE: the tag of its subformat, if the GUID is a tag's */
+            if (format == 0xFFFE) {
+                format = len == 40 && memcmp(buf + 26, guid, sizeof(guid)) == 0 ? get16(buf + 24) : 0;
+            }
+        }
+        fseek(f, ((size + 1) & ~1UL) - len, SEEK_CUR);
+    }
+
+    /* 16-bit PCM or 32-bit float, nothing else, and no further than the data chunk */
+    if (channels > 0 && ((format == 1 && bits == 16) || (format == 3 && bits == 32))) {
+        if (data / (channels * bits / 8) < (LgUns)maxTaps) {
+            maxTaps = data / (channels * bits / 8);
+        }
+        while (n < maxTaps && fread(buf, 1, bits / 8, f) == bits / 8) {
+            if (bits == 16) {
+                x = (Short)get16(buf) / 32768.0f;
+            }
+            else {
+                u = get32(buf);
+                memcpy(&x, &u, sizeof(x));
+            }
+            h[n++] = x;
+            if (channels > 1 && fseek(f, (channels - 1) * bits / 8, SEEK_CUR) != 0) {
+                break;
+            }
+        }
+    }
+    fclose(f);
+
+    return (n);
+}
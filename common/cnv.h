@@ -0,0 +1,65 @@
+/*
+ *  ======== cnv.h ========
+ *  Convolution of planar channels with a long filter or impulse
+ *  response, direct or by FFT.
+ *
+ *  Up to the crossover the filter runs direct (fir.h).  Above, it runs
+ *  as a uniformly partitioned overlap-save convolution: the response is
+ *  cut into partitions of one block (the PIP frame, BLK_config.size / 2
+ *  samples per channel), each transformed once by CNV_setCoefs(), and
+ *  every block the spectrum of the last FFT-size input samples is
+ *  pushed into a delay line of spectra and multiplied-accumulated with
+ *  the partitions.  The output of a block only depends on the inputs up
+ *  to it, so the FFT adds no latency.  Two channels share each complex
+ *  FFT, one in the real part and one in the imaginary part: the
+ *  response is real, so they stay apart.
+ *
+ *  CNV_AUTO picks the cheaper mode from a cost model of both (cycles
+ *  per tap for direct, per butterfly and per complex multiply-add for
+ *  the FFT); 'crossover' is the tap count from which the FFT wins for
+ *  the block size, "bench -x" measures the real one.  A change of mode
+ *  clears the history of the new one.
+ *
+ *  CNV_loadIR() reads a response from a 16-bit PCM or 32-bit float WAV
+ *  file (first channel), through stdio (CIO on the DSK).
+ */
+#ifndef CNV_
+#define CNV_
+
+#include <std.h>
+
+#include "fft.h"
+#include "fir.h"
+
+#define CNV_MAXTAPS     65536
+#define CNV_MAXPAIRS    ((FIR_MAXCHANNELS + 1) / 2)
+
+#define CNV_AUTO        0
+#define CNV_DIRECT      1
+#define CNV_FFT         2
+
+typedef struct CNV_Obj {
+    Int         mode;               /* CNV_DIRECT or CNV_FFT */
+    Int         numTaps;
+    Int         maxTaps;
+    Int         numChannels;
+    Int         block;              /* samples per channel and call, also the partition */
+    Int         crossover;          /* taps from which CNV_AUTO picks the FFT */
+    FIR_Obj     fir;
+    FFT_Obj     fft;
+    Int         numParts;           /* partitions in use */
+    Int         maxParts;
+    Float       *parts;             /* maxParts spectra of fft.size complex, scaled by 1/fft.size */
+    Float       *fdl[CNV_MAXPAIRS]; /* delay line of maxParts input spectra per channel pair */
+    Float       *tail[CNV_MAXPAIRS]; /* last fft.size - block inputs per pair */
+    Float       *work;              /* fft.size complex */
+    Int         fdlPos;             /* spectrum of the current block */
+} CNV_Obj;
+
+extern Bool CNV_init(CNV_Obj *cnv, Int maxTaps, Int numChannels, Int block, Int segid);
+extern Void CNV_delete(CNV_Obj *cnv, Int segid);
+extern Bool CNV_setCoefs(CNV_Obj *cnv, const Float *h, Int numTaps, Int mode);
+extern Void CNV_apply(CNV_Obj *cnv, Float *ch[], Int n);
+extern Int CNV_loadIR(String path, Float *h, Int maxTaps);
+
+#endif /* CNV_ */
@@ -0,0 +1,418 @@
+/*
+ *  ======== dly.c ========
+ *  Delay line with power-of-two wrapping and block access (see dly.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "dly.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define LOGBLOCK    5                   /* log2(DLY_BFPBLOCK) */
+#define Q15         32768.0f            /* full scale of a mantissa */
+
+/*
+ *  ======== power ========
+ *  2^e, built in the exponent field (DLY_MINEXP - 15 <= e <= DLY_MAXEXP).
+ */
+static inline Float power(Int e)
+{
+    union { Int i; Float f; } u;
+
+    u.i = (127 + e) << 23;
+    return (u.f);
+}
+
+/*
+ *  ======== exponentOf ========
+ *  The least e >= DLY_MINEXP such that peak < 2^e, at most DLY_MAXEXP.
+ */
+static inline Int exponentOf(Float peak)
+{
+    union { Int i; Float f; } u;
+    Int e;
+
+    u.f = peak;
+    e = ((u.i >> 23) & 0xff) - 126;
+    return (e < DLY_MINEXP ? DLY_MINEXP : e > DLY_MAXEXP ? DLY_MAXEXP : e);
+}
+
+/*
+ *  ======== peak ========
+ *  Largest magnitude of the 'n' samples of 'x'.
+ */
+static Float peak(const Float *restrict x, Int n)
+{
+    Float m = 0.0f, a;
+    Int i = 0;
+
+#if defined(__SSE2__)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 v = _mm_setzero_ps();
+    Float lanes[4];
+
+    for (; i + 4 <= n; i += 4) {
+        v = _mm_max_ps(v, _mm_andnot_ps(sign, _mm_loadu_ps(&x[i])));
+    }
+    _mm_storeu_ps(lanes, v);
+    m = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    m = lanes[2] > m ? lanes[2] : m;
+    m = lanes[3] > m ? lanes[3] : m;
+#endif
+    for (; i < n; i++) {
+        a = fabsf(x[i]);
+        m = a > m ? a : m;
+    }
+    return (m);
+}
+
+/*
+ *  ======== pack ========
+ *  q[i] = x[i] * scale, rounded to the nearest and saturated to 16 bits.
+ */
+static Void pack(const Float *restrict x, Float scale, Short *restrict q, Int n)
+{
+    Int i = 0;
+
+#if defined(_TMS320C6X)
+    for (; i < n; i++) {
+        q[i] = _sshl(_spint(x[i] * scale), 16) >> 16;
+    }
+#else
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 lo = _mm_set1_ps(-Q15);
+    const __m128 hi = _mm_set1_ps(Q15 - 1.0f);
+
+    /* clamped first: an out of range conversion gives -32768 */
+    for (; i + 8 <= n; i += 8) {
+        __m128 f0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&x[i]), vscale), lo), hi);
+        __m128 f1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&x[i + 4]), vscale), lo), hi);
+
+        _mm_storeu_si128((__m128i *)&q[i], _mm_packs_epi32(_mm_cvtps_epi32(f0), _mm_cvtps_epi32(f1)));
+    }
+#endif
+    for (; i < n; i++) {
+        Float v = x[i] * scale;
+
+        v = v < -Q15 ? -Q15 : v;
+        v = v > Q15 - 1.0f ? Q15 - 1.0f : v;
+        q[i] = (Short)lrintf(v);
+    }
+#endif
+}
+
+/*
+ *  ======== unpack ========
+ *  y[i] = q[i] * scale, or y[i] += q[i] * scale if 'mix'.
+ */
+static Void unpack(const Short *restrict q, Float scale, Float *restrict y, Int n, Bool mix)
+{
+    Int i = 0;
+
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&q[i]);
+        __m128 f0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale);
+        __m128 f1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale);
+
+        if (mix) {
+            f0 = _mm_add_ps(_mm_loadu_ps(&y[i]), f0);
+            f1 = _mm_add_ps(_mm_loadu_ps(&y[i + 4]), f1);
+        }
+        _mm_storeu_ps(&y[i], f0);
+        _mm_storeu_ps(&y[i + 4], f1);
+    }
+#endif
+    if (mix) {
+        for (; i < n; i++) {
+            y[i] += (Float)q[i] * scale;
+        }
+    }
+    else {
+        for (; i < n; i++) {
+            y[i] = (Float)q[i] * scale;
+        }
+    }
+}
+
+/*
+ *  ======== scale ========
+ *  y[i] += g * x[i], i = 0..n-1.
+ */
+static Void scale(const Float *restrict x, Float g, Float *restrict y, Int n)
+{
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        y[i] += g * x[i];
+    }
+}
+
+/*
+ *  ======== put ========
+ *  Store 'n' samples from position 'start', without wrapping.  A block
+ *  of DLY_BFP takes the exponent of its first samples, raised if later
+ *  ones need it: the mantissas already written in it are then shifted
+ *  to the new exponent.  Its older samples are never read again (see
+ *  DLY_init()).
+ */
+static Void put(DLY_Obj *dly, Int start, const Float *x, Int n)
+{
+    Int i, m, off, e, s, j;
+    Short *q;
+
+    switch (dly->format) {
+        case DLY_FLOAT:
+            memcpy(&dly->buf[start], x, n * sizeof(Float));
+            break;
+
+        case DLY_Q15:
+            pack(x, Q15, &dly->q[start], n);
+            break;
+
+        default:
+            for (i = 0; i < n; i += m, start += m) {
+                off = start & (DLY_BFPBLOCK - 1);
+                m = n - i < DLY_BFPBLOCK - off ? n - i : DLY_BFPBLOCK - off;
+                e = exponentOf(peak(x + i, m));
+                if (off > 0 && e <= dly->exponent[start >> LOGBLOCK]) {
+                    e = dly->exponent[start >> LOGBLOCK];
+                }
+                else if (off > 0) {
+                    s = e - dly->exponent[start >> LOGBLOCK];
+                    q = &dly->q[start - off];
+                    for (j = 0; j < off; j++) {
+                        q[j] = s < 16 ? (q[j] + (1 << (s - 1))) >> s : 0;
+                    }
+                }
+                dly->exponent[start >> LOGBLOCK] = e;
+                pack(x + i, power(15 - e), &dly->q[start], m);
+            }
+            break;
+    }
+}
+
+/*
+ *  ======== get ========
+ *  y[i] = gain * x at position 'start' + i, or y[i] += ... if 'mix', for
+ *  i = 0..n-1, without wrapping.
+ */
+static Void get(const DLY_Obj *dly, Int start, Float gain, Float *y, Int n, Bool mix)
+{
+    Int i, m;
+
+    switch (dly->format) {
+        case DLY_FLOAT:
+            if (mix) {
+                scale(&dly->buf[start], gain, y, n);
+            }
+            else {
+                memcpy(y, &dly->buf[start], n * sizeof(Float));
+            }
+            break;
+
+        case DLY_Q15:
+            unpack(&dly->q[start], gain * (1.0f / Q15), y, n, mix);
+            break;
+
+        default:
+            for (i = 0; i < n; i += m, start += m) {
+                m = DLY_BFPBLOCK - (start & (DLY_BFPBLOCK - 1));
+                m = n - i < m ? n - i : m;
+                unpack(&dly->q[start], gain * power(dly->exponent[start >> LOGBLOCK] - 15), y + i, m, mix);
+            }
+            break;
+    }
+}
+
+/*
+ *  ======== at ========
+ *  The sample at position 'p'.
+ */
+static inline Float at(const DLY_Obj *dly, Int p)
+{
+    switch (dly->format) {
+        case DLY_FLOAT:
+            return (dly->buf[p]);
+        case DLY_Q15:
+            return ((Float)dly->q[p] * (1.0f / Q15));
+        default:
+            return ((Float)dly->q[p] * power(dly->exponent[p >> LOGBLOCK] - 15));
+    }
+}
+
+/*
+ *  ======== DLY_init ========
+ *  Allocate a line for delays up to 'maxDelay' samples in 'segid',
+ *  filled with silence.  DLY_BFP needs a block more: the block being
+ *  written may have changed exponent, so its samples from the previous
+ *  turn can no longer be read.
+ */
+Bool DLY_init(DLY_Obj *dly, Int maxDelay, Int format, Int segid)
+{
+    Int length = format == DLY_BFP ? DLY_BFPBLOCK : 1;
+
+    if (maxDelay < 1 || maxDelay > 0x10000000 || format < DLY_FLOAT || format > DLY_BFP) {
+        return (FALSE);
+    }
+    if (format == DLY_BFP) {
+        maxDelay += DLY_BFPBLOCK;
+    }
+    while (length < maxDelay) {
+        length <<= 1;
+    }
+    dly->format = format;
+    dly->length = length;
+    dly->mask = length - 1;
+    dly->pos = 0;
+    dly->buf = NULL;
+    dly->q = NULL;
+    dly->exponent = NULL;
+    if (format == DLY_FLOAT) {
+        dly->buf = MEM_calloc(segid, length * sizeof(Float), 8);
+        return (dly->buf != MEM_ILLEGAL);
+    }
+    dly->q = MEM_calloc(segid, length * sizeof(Short), 8);
+    if (dly->q == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    if (format == DLY_BFP) {
+        dly->exponent = MEM_calloc(segid, length / DLY_BFPBLOCK, 8);
+        return (dly->exponent != MEM_ILLEGAL);
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== DLY_reset ========
+ *  Back to silence.
+ */
+Void DLY_reset(DLY_Obj *dly)
+{
+    if (dly->format == DLY_FLOAT) {
+        memset(dly->buf, 0, dly->length * sizeof(Float));
+    }
+    else {
+        memset(dly->q, 0, dly->length * sizeof(Short));
+    }
+    if (dly->format == DLY_BFP) {
+        memset(dly->exponent, 0, dly->length / DLY_BFPBLOCK);
+    }
+    dly->pos = 0;
+}
+
+/*
+ *  ======== DLY_write ========
+ *  Append the 'n' samples of 'x' (n at most the length).
+ */
+Void DLY_write(DLY_Obj *dly, const Float *x, Int n)
+{
+    Int first = dly->length - dly->pos;
+
+    if (n <= first) {
+        put(dly, dly->pos, x, n);
+    }
+    else {
+        put(dly, dly->pos, x, first);
+        put(dly, 0, x + first, n - first);
+    }
+    dly->pos = (dly->pos + n) & dly->mask;
+}
+
+/*
+ *  ======== DLY_read ========
+ *  y[i] = x(i - delay), i = 0..n-1 (i - delay < 0).
+ */
+Void DLY_read(const DLY_Obj *dly, Int delay, Float *y, Int n)
+{
+    Int start = (dly->pos - delay) & dly->mask, first = dly->length - start;
+
+    if (n <= first) {
+        get(dly, start, 1.0f, y, n, FALSE);
+    }
+    else {
+        get(dly, start, 1.0f, y, first, FALSE);
+        get(dly, 0, 1.0f, y + first, n - first, FALSE);
+    }
+}
+
+/*
+ *  ======== DLY_mix ========
+ *  y[i] += gain * x(i - delay), i = 0..n-1 (i - delay < 0).
+ */
+Void DLY_mix(const DLY_Obj *dly, Int delay, Float gain, Float *y, Int n)
+{
+    Int start = (dly->pos - delay) & dly->mask, first = dly->length - start;
+
+    if (n <= first) {
+        get(dly, start, gain, y, n, TRUE);
+    }
+    else {
+        get(dly, start, gain, y, first, TRUE);
+        get(dly, 0, gain, y + first, n - first, TRUE);
+    }
+}
+
+/*
+ *  ======== DLY_readFrac ========
+ *  y[i] = x(i - delay), i = 0..n-1, linearly interpolated
+ *  (i - delay < 0, delay >= 0).  The whole delay is read in one go;
+ *  the sample before each one is then the previous output, so the
+ *  interpolation runs backwards in place, and only the sample before
+ *  the first is read apart.
+ */
+Void DLY_readFrac(const DLY_Obj *dly, Float delay, Float *y, Int n)
+{
+    Int d = (Int)delay, i;
+    Float f = delay - d;
+
+    DLY_read(dly, d, y, n);
+    for (i = n - 1; i > 0; i--) {
+        y[i] = y[i] + f * (y[i - 1] - y[i]);
+    }
+    y[0] = y[0] + f * (at(dly, (dly->pos - d - 1) & dly->mask) - y[0]);
+}
+
+/*
+ *  ======== DLY_readMod ========
+ *  y[i] = x(i - delay[i]), i = 0..n-1, linearly interpolated
+ *  (i - delay[i] < 0, delay[i] >= 0).  Each sample has its own
+ *  position, wrapped by the mask.
+ */
+Void DLY_readMod(const DLY_Obj *dly, const Float *restrict delay, Float *restrict y, Int n)
+{
+    const Float *buf = dly->buf;
+    Int mask = dly->mask, d, a, i;
+    Float f, xa;
+
+    if (dly->format == DLY_FLOAT) {
+        for (i = 0; i < n; i++) {
+            d = (Int)delay[i];
+            f = delay[i] - d;
+            a = (dly->pos + i - d) & mask;
+            xa = buf[a];
+            y[i] = xa + f * (buf[(a - 1) & mask] - xa);
+        }
+    }
+    else {
+        for (i = 0; i < n; i++) {
+            d = (Int)delay[i];
+            f = delay[i] - d;
+            a = (dly->pos + i - d) & mask;
+            xa = at(dly, a);
+            y[i] = xa + f * (at(dly, (a - 1) & mask) - xa);
+        }
+    }
+}
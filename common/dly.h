@@ -0,0 +1,75 @@
+/*
+ *  ======== dly.h ========
+ *  Delay line: a circular buffer of the last samples of one stream,
+ *  written and read by blocks.
+ *
+ *  Its length is a power of two, so that a position wraps with a mask
+ *  instead of the modulo the exercises used (a call to a division
+ *  routine on the C67x, and a loop the host compiler cannot
+ *  vectorise).  A block written or read is at most two contiguous
+ *  segments, one up to the end of the buffer and one from its start:
+ *  DLY_write() and DLY_read() are then one or two copies, DLY_mix() one
+ *  or two multiply-add loops.
+ *
+ *  Times count from the next sample to be written, time 0: the last
+ *  sample written is at -1, and a tap of delay d gives y[i] = x(i - d)
+ *  for i = 0..n-1.  Read before the next block is written, it is the
+ *  input d samples before each of them (d >= n for the whole block);
+ *  after a block of n was written, tap d + n is that block delayed by
+ *  d.  A delay is at most the length asked for at DLY_init(), less one
+ *  for an interpolated tap.
+ *
+ *  DLY_readFrac() takes a fractional delay, the same for the block, and
+ *  DLY_readMod() one per sample, e.g. swept by an LFO; both interpolate
+ *  linearly between the two nearest samples, and give exactly the
+ *  sample of a whole delay.
+ *
+ *  The samples are stored as floats (DLY_FLOAT), or in 16 bits to halve
+ *  the memory of a long line and the bandwidth of its taps:
+ *
+ *      DLY_Q15     fixed point, full scale 1: a sample of magnitude 1 or
+ *                  more saturates, and the noise is that of the codec
+ *                  (about -96 dB of full scale), whatever the level;
+ *      DLY_BFP     block floating point: each DLY_BFPBLOCK samples share
+ *                  an exponent, that of their peak, so the noise follows
+ *                  the level (about -90 dB of the block's peak) and peaks
+ *                  up to 2^DLY_MAXEXP pass.  The exponents take 1 byte
+ *                  per block.
+ *
+ *  Samples are converted as they are written and read, by blocks (SSE2
+ *  on the host, _spint on the C67x); the conversion rounds to the
+ *  nearest, so that a feedback loop does not drift.  "bench -d" measures
+ *  the cost and the error of each format.
+ */
+#ifndef DLY_
+#define DLY_
+
+#include <std.h>
+
+#define DLY_FLOAT       0
+#define DLY_Q15         1
+#define DLY_BFP         2
+
+#define DLY_BFPBLOCK    32
+#define DLY_MINEXP      (-16)       /* exponent of a block, peak < 2^exponent */
+#define DLY_MAXEXP      8
+
+typedef struct DLY_Obj {
+    Int         format;             /* DLY_FLOAT, DLY_Q15 or DLY_BFP */
+    Int         length;             /* a power of two */
+    Int         mask;               /* length - 1 */
+    Int         pos;                /* where time 0 goes */
+    Float       *buf;               /* DLY_FLOAT */
+    Short       *q;                 /* DLY_Q15 and DLY_BFP: 16-bit mantissas */
+    Char        *exponent;          /* DLY_BFP: of each block */
+} DLY_Obj;
+
+extern Bool DLY_init(DLY_Obj *dly, Int maxDelay, Int format, Int segid);
+extern Void DLY_write(DLY_Obj *dly, const Float *x, Int n);
+extern Void DLY_read(const DLY_Obj *dly, Int delay, Float *y, Int n);
+extern Void DLY_mix(const DLY_Obj *dly, Int delay, Float gain, Float *y, Int n);
+extern Void DLY_readFrac(const DLY_Obj *dly, Float delay, Float *y, Int n);
+extern Void DLY_readMod(const DLY_Obj *dly, const Float *delay, Float *y, Int n);
+extern Void DLY_reset(DLY_Obj *dly);
+
+#endif /* DLY_ */
@@ -0,0 +1,335 @@
+/*
+ *  ======== fdn.c ========
+ *  Feedback delay network reverb on planar channels (see fdn.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "dly.h"
+#include "fdn.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#define SHORTEST    0.023           /* s, length of the first line */
+#define LONGEST     0.053           /* s, of the last one */
+#define INSIGNS     0x96e5          /* bit j set: the input goes into line j inverted */
+#define LEFTMASK    0x5             /* line j is inverted in the left output if j & LEFTMASK has odd parity */
+#define RIGHTMASK   0x6
+
+/*
+ *  ======== parity ========
+ *  -1 if 'x' has an odd number of bits set, else 1.
+ */
+static Float parity(Int x)
+{
+    Int p = 0;
+
+    for (; x != 0; x >>= 1) {
+        p ^= x & 1;
+    }
+    return (p ? -1.0f : 1.0f);
+}
+
+/*
+ *  ======== isPrime ========
+ */
+static Bool isPrime(Int d)
+{
+    Int k;
+
+    for (k = 2; k * k <= d; k++) {
+        if (d % k == 0) {
+            return (FALSE);
+        }
+    }
+    return (d > 1);
+}
+
+#if defined(__SSE2__) && !defined(_TMS320C6X)
+/*
+ *  ======== hsum ========
+ *  Sum of the four lanes of 'v'.
+ */
+static inline Float hsum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return (_mm_cvtss_f32(v));
+}
+
+/*
+ *  ======== network ========
+ *  Run the 'm' samples of a chunk through the network.  work[i * N + j]
+ *  holds the output of line j at sample i, and is replaced by its input;
+ *  'l' and 'r' are mixed with the outputs of the network.  Lines 4k to
+ *  4k + 3 are the lanes of register k.
+ */
+static Void network(FDN_Obj *fdn, Float *restrict l, Float *restrict r, Int m)
+{
+    const Int K = fdn->numLines / 4;
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 pm1 = _mm_set_ps(-1.0f, 1.0f, -1.0f, 1.0f);   /* lanes 0..3: +, -, +, - */
+    const __m128 pm2 = _mm_set_ps(-1.0f, -1.0f, 1.0f, 1.0f);   /* +, +, -, - */
+    __m128 gain[FDN_MAXLINES / 4], damp[FDN_MAXLINES / 4], s[FDN_MAXLINES / 4], in[FDN_MAXLINES / 4];
+    __m128 left[FDN_MAXLINES / 4], right[FDN_MAXLINES / 4], y[FDN_MAXLINES / 4], a, b, x, accL, accR;
+    Float *w, norm;
+    Int i, k, h;
+
+    norm = fdn->matrix == FDN_HADAMARD ? 1.0f / sqrtf((Float)fdn->numLines) : -2.0f / fdn->numLines;
+    for (k = 0; k < K; k++) {
+        gain[k] = _mm_loadu_ps(&fdn->gain[4 * k]);
+        damp[k] = _mm_loadu_ps(&fdn->damp[4 * k]);
+        s[k] = _mm_loadu_ps(&fdn->state[4 * k]);
+        in[k] = _mm_loadu_ps(&fdn->in[4 * k]);
+        left[k] = _mm_loadu_ps(&fdn->left[4 * k]);
+        right[k] = _mm_loadu_ps(&fdn->right[4 * k]);
+    }
+
+    for (i = 0; i < m; i++) {
+        w = &fdn->work[i * fdn->numLines];
+        x = _mm_mul_ps(half, _mm_add_ps(_mm_set1_ps(l[i]), _mm_set1_ps(r[i])));
+        accL = accR = _mm_setzero_ps();
+
+        /* damped outputs of the lines, and their sums into the outputs */
+        for (k = 0; k < K; k++) {
+            s[k] = _mm_add_ps(s[k], _mm_mul_ps(damp[k], _mm_sub_ps(_mm_mul_ps(gain[k], _mm_loadu_ps(&w[4 * k])), s[k])));
+            y[k] = s[k];
+            accL = _mm_add_ps(accL, _mm_mul_ps(left[k], y[k]));
+            accR = _mm_add_ps(accR, _mm_mul_ps(right[k], y[k]));
+        }
+
+        if (fdn->matrix == FDN_HADAMARD) {
+            /* butterflies of stride 1 and 2 inside each register, then 4 and 8 across them */
+            for (k = 0; k < K; k++) {
+                a = _mm_shuffle_ps(y[k], y[k], _MM_SHUFFLE(2, 2, 0, 0));
+                b = _mm_shuffle_ps(y[k], y[k], _MM_SHUFFLE(3, 3, 1, 1));
+                y[k] = _mm_add_ps(a, _mm_mul_ps(pm1, b));
+                a = _mm_movelh_ps(y[k], y[k]);
+                b = _mm_movehl_ps(y[k], y[k]);
+                y[k] = _mm_add_ps(a, _mm_mul_ps(pm2, b));
+            }
+            for (h = 1; h < K; h *= 2) {
+                for (k = 0; k < K; k++) {
+                    if ((k & h) == 0) {
+                        a = y[k];
+                        y[k] = _mm_add_ps(a, y[k + h]);
+                        y[k + h] = _mm_sub_ps(a, y[k + h]);
+                    }
+                }
+            }
+            for (k = 0; k < K; k++) {
+                _mm_storeu_ps(&w[4 * k], _mm_add_ps(_mm_mul_ps(_mm_set1_ps(norm), y[k]), _mm_mul_ps(in[k], x)));
+            }
+        }
+        else {
+            /* y - 2/N sum(y) */
+            for (a = y[0], k = 1; k < K; k++) {
+                a = _mm_add_ps(a, y[k]);
+            }
+            a = _mm_set1_ps(norm * hsum(a));
+            for (k = 0; k < K; k++) {
+                _mm_storeu_ps(&w[4 * k], _mm_add_ps(_mm_add_ps(y[k], a), _mm_mul_ps(in[k], x)));
+            }
+        }
+
+        l[i] = fdn->dry * l[i] + fdn->wet * hsum(accL);
+        r[i] = fdn->dry * r[i] + fdn->wet * hsum(accR);
+    }
+
+    for (k = 0; k < K; k++) {
+        _mm_storeu_ps(&fdn->state[4 * k], s[k]);
+    }
+}
+#else
+/*
+ *  ======== network ========
+ *  Run the 'm' samples of a chunk through the network.  work[i * N + j]
+ *  holds the output of line j at sample i, and is replaced by its input;
+ *  'l' and 'r' are mixed with the outputs of the network.  The loops over
+ *  the lines are independent, for the software pipeline.
+ */
+static Void network(FDN_Obj *fdn, Float *restrict l, Float *restrict r, Int m)
+{
+    const Int N = fdn->numLines;
+    Float y[FDN_MAXLINES], *w, x, a, accL, accR, sum, norm;
+    Int i, j, h;
+
+    norm = fdn->matrix == FDN_HADAMARD ? 1.0f / sqrtf((Float)N) : -2.0f / N;
+    for (i = 0; i < m; i++) {
+        w = &fdn->work[i * N];
+        x = 0.5f * (l[i] + r[i]);
+        accL = accR = sum = 0.0f;
+
+        for (j = 0; j < N; j++) {
+            fdn->state[j] += fdn->damp[j] * (fdn->gain[j] * w[j] - fdn->state[j]);
+            y[j] = fdn->state[j];
+            accL += fdn->left[j] * y[j];
+            accR += fdn->right[j] * y[j];
+            sum += y[j];
+        }
+
+        if (fdn->matrix == FDN_HADAMARD) {
+            for (h = 1; h < N; h *= 2) {
+                for (j = 0; j < N; j++) {
+                    if ((j & h) == 0) {
+                        a = y[j];
+                        y[j] = a + y[j + h];
+                        y[j + h] = a - y[j + h];
+                    }
+                }
+            }
+            for (j = 0; j < N; j++) {
+                w[j] = norm * y[j] + fdn->in[j] * x;
+            }
+        }
+        else {
+            for (j = 0; j < N; j++) {
+                w[j] = y[j] + norm * sum + fdn->in[j] * x;
+            }
+        }
+
+        l[i] = fdn->dry * l[i] + fdn->wet * accL;
+        r[i] = fdn->dry * r[i] + fdn->wet * accR;
+    }
+}
+#endif
+
+/*
+ *  ======== FDN_init ========
+ *  Allocate a network of 'numLines' lines (4, 8 or 16) mixed by
+ *  'matrix', for a sampling frequency of 'rate', in 'segid'.  It starts
+ *  with a reverb time of 2 s, half damping, and the reverb alone.
+ */
+Bool FDN_init(FDN_Obj *fdn, Int numLines, Int matrix, LgUns rate, Int segid)
+{
+    Int j, d;
+
+    if ((numLines != 4 && numLines != 8 && numLines != 16) ||
+        (matrix != FDN_HOUSEHOLDER && matrix != FDN_HADAMARD) || rate * SHORTEST < FDN_BLOCK) {
+        return (FALSE);
+    }
+    fdn->numLines = numLines;
+    fdn->matrix = matrix;
+    fdn->rate = rate;
+
+    /* lengths in geometric progression, each the next prime up, so that no two share a period */
+    for (j = 0; j < numLines; j++) {
+        d = (Int)(rate * SHORTEST * pow(LONGEST / SHORTEST, (Double)j / (numLines - 1)));
+        if (j > 0 && d <= fdn->delay[j - 1]) {
+            d = fdn->delay[j - 1] + 1;
+        }
+        while (!isPrime(d)) {
+            d++;
+        }
+        fdn->delay[j] = d;
+        if (!DLY_init(&fdn->line[j], d, DLY_FLOAT, segid)) {
+            return (FALSE);
+        }
+    }
+
+    fdn->gain = MEM_alloc(segid, numLines * sizeof(Float), 16);
+    fdn->damp = MEM_alloc(segid, numLines * sizeof(Float), 16);
+    fdn->state = MEM_calloc(segid, numLines * sizeof(Float), 16);
+    fdn->in = MEM_alloc(segid, numLines * sizeof(Float), 16);
+    fdn->left = MEM_alloc(segid, numLines * sizeof(Float), 16);
+    fdn->right = MEM_alloc(segid, numLines * sizeof(Float), 16);
+    fdn->work = MEM_alloc(segid, FDN_BLOCK * numLines * sizeof(Float), 16);
+    fdn->chunk = MEM_alloc(segid, FDN_BLOCK * sizeof(Float), 16);
+    if (fdn->gain == MEM_ILLEGAL || fdn->damp == MEM_ILLEGAL || fdn->state == MEM_ILLEGAL ||
+        fdn->in == MEM_ILLEGAL || fdn->left == MEM_ILLEGAL || fdn->right == MEM_ILLEGAL ||
+        fdn->work == MEM_ILLEGAL || fdn->chunk == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (j = 0; j < numLines; j++) {
+        fdn->in[j] = (INSIGNS >> j & 1 ? -1.0f : 1.0f) / sqrtf((Float)numLines);
+        fdn->left[j] = parity(j & LEFTMASK) / sqrtf((Float)numLines);
+        fdn->right[j] = parity(j & RIGHTMASK) / sqrtf((Float)numLines);
+    }
+    FDN_setDecay(fdn, 2.0, 0.5);
+    FDN_setMix(fdn, 0.0f, 1.0f);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== FDN_setDecay ========
+ *  Reverb time 't60' (s, to -60 dB at low frequencies) and 'damping',
+ *  0 (none) to 1 (excluded), of the high frequencies.
+ */
+Bool FDN_setDecay(FDN_Obj *fdn, Double t60, Double damping)
+{
+    Int j;
+
+    if (t60 <= 0.0 || damping < 0.0 || damping >= 1.0) {
+        return (FALSE);
+    }
+    for (j = 0; j < fdn->numLines; j++) {
+        fdn->gain[j] = (Float)pow(10.0, -3.0 * fdn->delay[j] / (t60 * fdn->rate));
+        fdn->damp[j] = (Float)(1.0 - damping);
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== FDN_setMix ========
+ *  Linear gains of the input and of the reverb in the output.
+ */
+Void FDN_setMix(FDN_Obj *fdn, Float dry, Float wet)
+{
+    fdn->dry = dry;
+    fdn->wet = wet;
+}
+
+/*
+ *  ======== FDN_reset ========
+ *  Silence in every line.
+ */
+Void FDN_reset(FDN_Obj *fdn)
+{
+    Int j;
+
+    for (j = 0; j < fdn->numLines; j++) {
+        DLY_reset(&fdn->line[j]);
+    }
+    memset(fdn->state, 0, fdn->numLines * sizeof(Float));
+}
+
+/*
+ *  ======== FDN_apply ========
+ *  Reverberate the 'n' samples of the stereo pair ch[0], ch[1], in
+ *  place.
+ */
+Void FDN_apply(FDN_Obj *fdn, Float *ch[], Int n)
+{
+    const Int N = fdn->numLines;
+    Int pos, m, i, j;
+
+    for (pos = 0; pos < n; pos += m) {
+        m = n - pos < FDN_BLOCK ? n - pos : FDN_BLOCK;
+
+        /* the outputs of the lines, FDN_BLOCK or more samples old, side by side */
+        for (j = 0; j < N; j++) {
+            DLY_read(&fdn->line[j], fdn->delay[j], fdn->chunk, m);
+            for (i = 0; i < m; i++) {
+                fdn->work[i * N + j] = fdn->chunk[i];
+            }
+        }
+
+        network(fdn, ch[0] + pos, ch[1] + pos, m);
+
+        for (j = 0; j < N; j++) {
+            for (i = 0; i < m; i++) {
+                fdn->chunk[i] = fdn->work[i * N + j];
+            }
+            DLY_write(&fdn->line[j], fdn->chunk, m);
+        }
+    }
+}
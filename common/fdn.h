@@ -0,0 +1,69 @@
+/*
+ *  ======== fdn.h ========
+ *  Feedback delay network reverb on a stereo pair of planar channels.
+ *
+ *  Exercice3's echo is one feedback comb: a delay line whose output,
+ *  scaled, goes back into its input.  Its echoes come at one period, and
+ *  it rings at the harmonics of that period.  Here FDN_MAXLINES or fewer
+ *  combs (8 or 16) of mutually prime lengths, from about 23 to 53 ms,
+ *  feed back into each other through an orthogonal matrix, so that each
+ *  echo spreads into all the lines and the density of echoes grows with
+ *  time instead of repeating.  The matrix keeps the energy of the loop,
+ *  so the decay is set by the gain of each line alone, from the reverb
+ *  time: the loop of a line of d samples loses 60 dB in T60 seconds at
+ *  a gain of 10^(-3 d / (T60 rate)).  A one-pole low-pass in each loop
+ *  damps the high frequencies faster, as air and walls do.
+ *
+ *  The matrix is FDN_HOUSEHOLDER, I - 2/N 11', in N additions and
+ *  multiplications (a sum and a subtraction), or FDN_HADAMARD, the
+ *  normalised Walsh-Hadamard transform, in N log2(N) additions by
+ *  butterflies.  Neither is the N^2 multiply-adds of a general matrix.
+ *
+ *  No line is shorter than FDN_BLOCK samples, so a chunk of FDN_BLOCK
+ *  samples of a line's output only depends on inputs before the chunk:
+ *  FDN_apply() reads each line's chunk at once (dly.h), runs the whole
+ *  network one sample at a time with the lines in the lanes of SIMD
+ *  registers (4 lines per SSE register on the host, the Hadamard stages
+ *  inside a register as shuffles), and writes each line's chunk back.
+ *
+ *  The input of the network is the mono sum of the pair, with signs
+ *  that differ from line to line.  The left and right outputs are two
+ *  orthogonal sign patterns over the lines, so they are uncorrelated.
+ *  FDN_setDecay() and FDN_setMix() apply from the next block.
+ */
+#ifndef FDN_
+#define FDN_
+
+#include <std.h>
+
+#include "dly.h"
+
+#define FDN_HOUSEHOLDER 0
+#define FDN_HADAMARD    1
+
+#define FDN_MAXLINES    16
+#define FDN_BLOCK       64      /* samples per chunk, at most the shortest line */
+
+typedef struct FDN_Obj {
+    Int         numLines;               /* 4, 8 or 16 */
+    Int         matrix;                 /* FDN_HOUSEHOLDER or FDN_HADAMARD */
+    LgUns       rate;
+    DLY_Obj     line[FDN_MAXLINES];
+    Int         delay[FDN_MAXLINES];    /* samples */
+    Float       *gain;                  /* of each line's loop */
+    Float       *damp;                  /* coefficient of each line's low-pass */
+    Float       *state;                 /* of each line's low-pass */
+    Float       *in;                    /* gain of the input in each line */
+    Float       *left, *right;          /* gains of each line in the outputs */
+    Float       dry, wet;
+    Float       *work;                  /* one chunk of every line, sample after sample */
+    Float       *chunk;                 /* one chunk of one line */
+} FDN_Obj;
+
+extern Bool FDN_init(FDN_Obj *fdn, Int numLines, Int matrix, LgUns rate, Int segid);
+extern Bool FDN_setDecay(FDN_Obj *fdn, Double t60, Double damping);
+extern Void FDN_setMix(FDN_Obj *fdn, Float dry, Float wet);
+extern Void FDN_apply(FDN_Obj *fdn, Float *ch[], Int n);
+extern Void FDN_reset(FDN_Obj *fdn);
+
+#endif /* FDN_ */
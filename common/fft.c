@@ -0,0 +1,143 @@
+/*
+ *  ======== fft.c ========
+ *  In-place complex FFT of a power of two size (see fft.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+
+#include "fft.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define PI  3.14159265358979
+
+/*
+ *  ======== FFT_init ========
+ *  Tables of an FFT of 'size' points, allocated in 'segid'.
+ */
+Bool FFT_init(FFT_Obj *fft, Int size, Int segid)
+{
+    Uns j, r, b;
+    Int h, k;
+    Float *w;
+
+    if (size < FFT_MINSIZE || size > FFT_MAXSIZE || (size & (size - 1)) != 0) {
+        return (FALSE);
+    }
+    fft->size = size;
+    for (fft->log2Size = 0; (1 << fft->log2Size) < size; fft->log2Size++) {
+    }
+
+    fft->twiddle = MEM_alloc(segid, (size > 2 ? 2 * (size - 2) : 2) * sizeof(Float), 16);
+    fft->swap = MEM_alloc(segid, size * sizeof(Uns), 0);
+    if (fft->twiddle == MEM_ILLEGAL || fft->swap == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (h = 2; h < size; h *= 2) {
+        w = fft->twiddle + 2 * (h - 2);
+        for (k = 0; k < h; k++) {
+            w[2 * k] = cos(PI * k / h);
+            w[2 * k + 1] = -sin(PI * k / h);
+        }
+    }
+    for (fft->numSwaps = 0, j = 0; j < (Uns)size; j++) {
+        for (r = 0, b = 0; b < (Uns)fft->log2Size; b++) {
+            r |= ((j >> b) & 1) << (fft->log2Size - 1 - b);
+        }
+        if (j < r) {
+            fft->swap[fft->numSwaps++] = j;
+            fft->swap[fft->numSwaps++] = r;
+        }
+    }
+    fft->numSwaps /= 2;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== FFT_delete ========
+ *  Free the tables of FFT_init(), allocated in 'segid'.
+ */
+Void FFT_delete(FFT_Obj *fft, Int segid)
+{
+    MEM_free(segid, fft->twiddle, (fft->size > 2 ? 2 * (fft->size - 2) : 2) * sizeof(Float));
+    MEM_free(segid, fft->swap, fft->size * sizeof(Uns));
+}
+
+/*
+ *  ======== FFT_apply ========
+ *  Transform the 'size' complex numbers of 'x' in place, FFT_FORWARD
+ *  or FFT_INVERSE (not scaled).
+ */
+Void FFT_apply(FFT_Obj *fft, Float *x, Int dir)
+{
+#ifndef __SSE2__
+    Float sign = dir == FFT_INVERSE ? -1.0f : 1.0f;
+    Float wr, wi;
+#endif
+    Float tr, ti, t;
+    Float *a, *b;
+    const Float *w;
+    Int half, i, j, k;
+
+    for (k = 0; k < fft->numSwaps; k++) {
+        i = 2 * fft->swap[2 * k];
+        j = 2 * fft->swap[2 * k + 1];
+        t = x[i]; x[i] = x[j]; x[j] = t;
+        t = x[i + 1]; x[i + 1] = x[j + 1]; x[j + 1] = t;
+    }
+
+    /* first pass: the twiddle factor is 1 */
+    for (i = 0; i < 2 * fft->size; i += 4) {
+        tr = x[i + 2];
+        ti = x[i + 3];
+        x[i + 2] = x[i] - tr;
+        x[i + 3] = x[i + 1] - ti;
+        x[i] += tr;
+        x[i + 1] += ti;
+    }
+
+    /* butterflies of 2 * half points */
+    for (half = 2; half < fft->size; half *= 2) {
+        w = fft->twiddle + 2 * (half - 2);
+        for (i = 0; i < fft->size; i += 2 * half) {
+            a = x + 2 * i;
+            b = a + 2 * half;
+#ifdef __SSE2__
+            {
+                /* two butterflies at a time: t = b * w, b = a - t, a = a + t */
+                const __m128 re = _mm_castsi128_ps(_mm_set_epi32(0, 0x80000000, 0, 0x80000000));
+                const __m128 im = _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0x80000000, 0));
+                const __m128 conj = dir == FFT_INVERSE ? im : _mm_setzero_ps();
+
+                for (k = 0; k < 2 * half; k += 4) {
+                    __m128 wk = _mm_xor_ps(_mm_load_ps(&w[k]), conj);
+                    __m128 bk = _mm_loadu_ps(&b[k]);
+                    __m128 ak = _mm_loadu_ps(&a[k]);
+                    __m128 tk = _mm_add_ps(
+                        _mm_mul_ps(bk, _mm_shuffle_ps(wk, wk, _MM_SHUFFLE(2, 2, 0, 0))),
+                        _mm_xor_ps(_mm_mul_ps(_mm_shuffle_ps(bk, bk, _MM_SHUFFLE(2, 3, 0, 1)),
+                            _mm_shuffle_ps(wk, wk, _MM_SHUFFLE(3, 3, 1, 1))), re));
+
+                    _mm_storeu_ps(&b[k], _mm_sub_ps(ak, tk));
+                    _mm_storeu_ps(&a[k], _mm_add_ps(ak, tk));
+                }
+            }
+#else
+            for (k = 0; k < 2 * half; k += 2) {
+                wr = w[k];
+                wi = sign * w[k + 1];
+                tr = b[k] * wr - b[k + 1] * wi;
+                ti = b[k] * wi + b[k + 1] * wr;
+                b[k] = a[k] - tr;
+                b[k + 1] = a[k + 1] - ti;
+                a[k] += tr;
+                a[k + 1] += ti;
+            }
+#endif
+        }
+    }
+}
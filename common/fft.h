@@ -0,0 +1,40 @@
+/*
+ *  ======== fft.h ========
+ *  In-place complex FFT of a power of two size.
+ *
+ *  The data is an array of 'size' complex numbers stored as (re, im)
+ *  pairs of floats.  FFT_apply() computes
+ *
+ *      X[k] = sum(x[j] * exp(-+2*pi*i*j*k/size), j = 0..size-1)
+ *
+ *  with the minus sign forward and the plus sign for the inverse, which
+ *  is not divided by 'size'.  Iterative radix-2 decimation in time, with
+ *  the twiddle factors and the bit-reversal permutation computed by
+ *  FFT_init().  The twiddle factors of each pass are stored one after
+ *  the other, so that the butterflies of a pass read them in sequence:
+ *  on the host they run two at a time with SSE2.
+ */
+#ifndef FFT_
+#define FFT_
+
+#include <std.h>
+
+#define FFT_MINSIZE     2
+#define FFT_MAXSIZE     65536
+
+#define FFT_FORWARD     0
+#define FFT_INVERSE     1
+
+typedef struct FFT_Obj {
+    Int         size;
+    Int         log2Size;
+    Float       *twiddle;           /* pass of 2h points: h complex exp(-pi*i*k/h) from 2*(h-2) */
+    Uns         *swap;              /* pairs (j, bitreverse(j)) with j < bitreverse(j) */
+    Int         numSwaps;
+} FFT_Obj;
+
+extern Bool FFT_init(FFT_Obj *fft, Int size, Int segid);
+extern Void FFT_delete(FFT_Obj *fft, Int segid);
+extern Void FFT_apply(FFT_Obj *fft, Float *x, Int dir);
+
+#endif /* FFT_ */
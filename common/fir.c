@@ -0,0 +1,338 @@
+/*
+ *  ======== fir.c ========
+ *  FIR filter of any length on planar channels (see fir.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "fir.h"
+
+#ifdef _TMS320C6X
+#include <DSPF_sp_fir_gen.h>
+#else
+#define restrict    __restrict
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#define PI  3.14159265358979
+
+/*
+ *  ======== filter ========
+ *  r[j] = sum(h[i] * x[i + j], i = 0..nh-1) for j = 0..nr-1, with the
+ *  arguments of DSPF_sp_fir_gen().
+ */
+static Void filter(const Float *restrict x, const Float *restrict h, Float *restrict r, Int nh, Int nr)
+{
+    Float acc;
+    Int i, j = 0;
+
+#ifdef __SSE2__
+    /* 16 outputs per pass: 4 independent sums hide the latency of the additions */
+    for (; j + 16 <= nr; j += 16) {
+        __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+        __m128 a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+
+        for (i = 0; i < nh; i++) {
+            __m128 hi = _mm_set1_ps(h[i]);
+            const Float *xi = &x[i + j];
+
+            a0 = _mm_add_ps(a0, _mm_mul_ps(hi, _mm_loadu_ps(xi)));
+            a1 = _mm_add_ps(a1, _mm_mul_ps(hi, _mm_loadu_ps(xi + 4)));
+            a2 = _mm_add_ps(a2, _mm_mul_ps(hi, _mm_loadu_ps(xi + 8)));
+            a3 = _mm_add_ps(a3, _mm_mul_ps(hi, _mm_loadu_ps(xi + 12)));
+        }
+        _mm_storeu_ps(&r[j], a0);
+        _mm_storeu_ps(&r[j + 4], a1);
+        _mm_storeu_ps(&r[j + 8], a2);
+        _mm_storeu_ps(&r[j + 12], a3);
+    }
+    for (; j + 4 <= nr; j += 4) {
+        __m128 a0 = _mm_setzero_ps();
+
+        for (i = 0; i < nh; i++) {
+            a0 = _mm_add_ps(a0, _mm_mul_ps(_mm_set1_ps(h[i]), _mm_loadu_ps(&x[i + j])));
+        }
+        _mm_storeu_ps(&r[j], a0);
+    }
+#endif
+    for (; j < nr; j++) {
+        for (acc = 0.0f, i = 0; i < nh; i++) {
+            acc += h[i] * x[i + j];
+        }
+        r[j] = acc;
+    }
+}
+
+/*
+ *  ======== FIR_init ========
+ *  Allocate the coefficients and the windows of 'numChannels' channels
+ *  in 'segid', for up to 'maxTaps' taps and blocks of up to 'maxBlock'
+ *  samples.  The filter passes its input through until FIR_setCoefs().
+ */
+Bool FIR_init(FIR_Obj *fir, Int maxTaps, Int numChannels, Int maxBlock, Int segid)
+{
+    static const Float identity = 1.0f;
+    Int room, c;
+
+    if (maxTaps < 1 || maxTaps > FIR_MAXTAPS || numChannels < 1 || numChannels > FIR_MAXCHANNELS ||
+        maxBlock < 1) {
+        return (FALSE);
+    }
+    fir->maxTaps = (maxTaps + 3) & ~3;
+    fir->numChannels = numChannels;
+    fir->maxBlock = maxBlock;
+
+    /* room for FIR_SLACK blocks, and at least for the history it copies */
+    room = FIR_SLACK * maxBlock > fir->maxTaps ? FIR_SLACK * maxBlock : fir->maxTaps;
+    fir->length = fir->maxTaps - 1 + room;
+
+    fir->coefs = MEM_alloc(segid, fir->maxTaps * sizeof(Float), 8);
+    if (fir->coefs == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (c = 0; c < numChannels; c++) {
+        fir->hist[c] = MEM_alloc(segid, fir->length * sizeof(Float), 8);
+        if (fir->hist[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+    FIR_reset(fir);
+
+    return (FIR_setCoefs(fir, &identity, 1));
+}
+
+/*
+ *  ======== FIR_delete ========
+ *  Free the coefficients and windows of FIR_init(), allocated in 'segid'.
+ */
+Void FIR_delete(FIR_Obj *fir, Int segid)
+{
+    Int c;
+
+    for (c = 0; c < fir->numChannels; c++) {
+        MEM_free(segid, fir->hist[c], fir->length * sizeof(Float));
+    }
+    MEM_free(segid, fir->coefs, fir->maxTaps * sizeof(Float));
+}
+
+/*
+ *  ======== FIR_setCoefs ========
+ *  Filter with the 'numTaps' coefficients of 'h', h[0] weighing the
+ *  newest input.  The history is kept.
+ */
+Bool FIR_setCoefs(FIR_Obj *fir, const Float *h, Int numTaps)
+{
+    Int padded = (numTaps + 3) & ~3, k;
+
+    if (numTaps < 1 || numTaps > fir->maxTaps) {
+        return (FALSE);
+    }
+    for (k = 0; k < padded - numTaps; k++) {
+        fir->coefs[k] = 0.0f;
+    }
+    for (k = 0; k < numTaps; k++) {
+        fir->coefs[padded - 1 - k] = h[k];
+    }
+    fir->numTaps = padded;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== FIR_reset ========
+ *  Clear the history of every channel.
+ */
+Void FIR_reset(FIR_Obj *fir)
+{
+    Int c;
+
+    for (c = 0; c < fir->numChannels; c++) {
+        memset(fir->hist[c], 0, fir->length * sizeof(Float));
+        fir->pos[c] = fir->maxTaps - 1;
+    }
+}
+
+/*
+ *  ======== FIR_apply ========
+ *  Filter 'n' samples (at most maxBlock) of channel 'ch' from 'in' into
+ *  'out', which may be the same array.
+ */
+Void FIR_apply(FIR_Obj *fir, Int ch, const Float *in, Float *out, Int n)
+{
+    Float *w = fir->hist[ch];
+    Float *x;
+    Int keep = fir->maxTaps - 1;
+
+    /* window full: start again behind the last inputs */
+    if (fir->pos[ch] + n > fir->length) {
+        memmove(w, w + fir->pos[ch] - keep, keep * sizeof(Float));
+        fir->pos[ch] = keep;
+    }
+    memcpy(w + fir->pos[ch], in, n * sizeof(Float));
+    x = w + fir->pos[ch] + 1 - fir->numTaps;
+    fir->pos[ch] += n;
+
+#ifdef _TMS320C6X
+    /* DSPLIB wants nr a multiple of 4 and x double-word aligned */
+    if ((n & 3) == 0 && ((Uns)x & 7) == 0) {
+        DSPF_sp_fir_gen(x, fir->coefs, out, fir->numTaps, n);
+        return;
+    }
+#endif
+    filter(x, fir->coefs, out, fir->numTaps, n);
+}
+
+/*
+ *  ======== blackman ========
+ *  Tap 'k' of the Blackman window of 'numTaps' taps.
+ */
+static Double blackman(Int k, Int numTaps)
+{
+    return (0.42 - 0.5 * cos(2.0 * PI * k / (numTaps - 1)) + 0.08 * cos(4.0 * PI * k / (numTaps - 1)));
+}
+
+/*
+ *  ======== normalise ========
+ *  Scale the 'numTaps' taps of 'h', of sum 'sum', to a gain of 1 at DC,
+ *  then take the complement for a high-pass.  Returns 'numTaps'.
+ */
+static Int normalise(Float *h, Int numTaps, Double sum, Int type)
+{
+    Int k;
+
+    for (k = 0; k < numTaps; k++) {
+        h[k] /= sum;
+        if (type == FIR_HIGHPASS) {
+            h[k] = (k == numTaps / 2 ? 1.0f : 0.0f) - h[k];
+        }
+    }
+
+    return (numTaps);
+}
+
+/*
+ *  ======== FIR_design ========
+ *  Windowed-sinc (Blackman) filter of 'numTaps' taps into 'h', cut off
+ *  at 'cutoff' times the sampling frequency (0 to 0.5), with a gain of
+ *  1 in its pass band.  A high-pass filter needs an odd number of taps,
+ *  one is added if needed.  Returns the number of taps.
+ */
+Int FIR_design(Float *h, Int numTaps, Float cutoff, Int type)
+{
+    Double m, t, s, sum = 0.0;
+    Int k;
+
+    if (type == FIR_HIGHPASS) {
+        numTaps |= 1;
+    }
+    if (numTaps > FIR_MAXTAPS) {
+        numTaps = FIR_MAXTAPS - 1;
+    }
+    if (numTaps < 3) {
+        numTaps = 3;
+    }
+
+    m = (numTaps - 1) / 2.0;
+    for (k = 0; k < numTaps; k++) {
+        t = k - m;
+        s = t == 0.0 ? 2.0 * cutoff : sin(2.0 * PI * cutoff * t) / (PI * t);
+        s *= blackman(k, numTaps);
+        h[k] = s;
+        sum += s;
+    }
+
+    return (normalise(h, numTaps, sum, type));
+}
+
+/*
+ *  ======== FIR_initTable ========
+ *  Compute, in 'segid', the Blackman window of each of the 'numLengths'
+ *  odd 'lengths' (3 to FIR_MAXTAPS - 1) and the sinc of each of the
+ *  'numCutoffs' 'cutoffs' (times the sampling frequency) for
+ *  FIR_designFrom().  Both are symmetric, so only their half from the
+ *  centre out is kept.  Returns FALSE if a length is not allowed or
+ *  out of memory.
+ */
+Bool FIR_initTable(FIR_Table *tab, Int numLengths, const Int lengths[], Int numCutoffs,
+    const Float cutoffs[], Int segid)
+{
+    Float *p;
+    Double t;
+    Int l, c, k;
+
+    if (numLengths < 1 || numLengths > FIR_MAXDESIGNS || numCutoffs < 1 || numCutoffs > FIR_MAXDESIGNS) {
+        return (FALSE);
+    }
+    tab->numLengths = numLengths;
+    tab->numCutoffs = numCutoffs;
+    tab->maxHalf = 0;
+    tab->size = 0;
+    for (l = 0; l < numLengths; l++) {
+        if (lengths[l] < 3 || lengths[l] >= FIR_MAXTAPS || (lengths[l] & 1) == 0) {
+            return (FALSE);
+        }
+        tab->lengths[l] = lengths[l];
+        if ((lengths[l] - 1) / 2 > tab->maxHalf) {
+            tab->maxHalf = (lengths[l] - 1) / 2;
+        }
+        tab->size += (lengths[l] - 1) / 2 + 1;
+    }
+    tab->size += numCutoffs * (tab->maxHalf + 1);
+
+    p = MEM_alloc(segid, tab->size * sizeof(Float), 8);
+    if (p == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (l = 0; l < numLengths; l++) {
+        tab->window[l] = p;
+        for (k = 0; k <= (lengths[l] - 1) / 2; k++) {
+            *p++ = blackman((lengths[l] - 1) / 2 + k, lengths[l]);
+        }
+    }
+    for (c = 0; c < numCutoffs; c++) {
+        tab->sinc[c] = p;
+        *p++ = 2.0f * cutoffs[c];
+        for (k = 1; k <= tab->maxHalf; k++) {
+            t = k;
+            *p++ = sin(2.0 * PI * cutoffs[c] * t) / (PI * t);
+        }
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== FIR_deleteTable ========
+ *  Free the table of FIR_initTable(), allocated in 'segid'.
+ */
+Void FIR_deleteTable(FIR_Table *tab, Int segid)
+{
+    MEM_free(segid, tab->window[0], tab->size * sizeof(Float));
+}
+
+/*
+ *  ======== FIR_designFrom ========
+ *  FIR_design() of length 'tab->lengths[length]' and cutoff
+ *  'cutoffs[cutoff]' of FIR_initTable(), from the precomputed window
+ *  and sinc: one multiply and one add per tap.  The coefficients match
+ *  FIR_design()'s to within the rounding of the tables to Float.
+ *  Returns the number of taps.
+ */
+Int FIR_designFrom(const FIR_Table *tab, Float *h, Int length, Int cutoff, Int type)
+{
+    const Float *w = tab->window[length], *s = tab->sinc[cutoff];
+    Int numTaps = tab->lengths[length], m = (numTaps - 1) / 2, k, t;
+    Double sum = 0.0;
+
+    for (k = 0; k < numTaps; k++) {
+        t = k < m ? m - k : k - m;
+        h[k] = w[t] * s[t];
+        sum += h[k];
+    }
+
+    return (normalise(h, numTaps, sum, type));
+}
@@ -0,0 +1,70 @@
+/*
+ *  ======== fir.h ========
+ *  FIR filter of any length on planar channels.
+ *
+ *  FIR_apply() filters one block of one channel (a PLN_split() array)
+ *  with the coefficients given to FIR_setCoefs(), which may change
+ *  between blocks.  Each channel keeps its input history in a sliding
+ *  window: a block is appended behind the last numTaps - 1 inputs and
+ *  the filter runs over the contiguous window, so the inner loop has no
+ *  wrap-around.  The window holds FIR_SLACK blocks, and only when it is
+ *  full are the last inputs copied back to its start, once every
+ *  FIR_SLACK blocks instead of a memmove per block.
+ *
+ *  The inner loop is DSPLIB's DSPF_sp_fir_gen() on the C67x (link
+ *  dsp67x.lib), and on the host computes 16 outputs at a time with SSE2,
+ *  the taps summed in the same order as the plain C loop.
+ *
+ *  FIR_design() makes windowed-sinc (Blackman) low-pass and high-pass
+ *  filters.  When the lengths and cutoffs come from a fixed set (sliders),
+ *  FIR_initTable() computes the window of each length and the sinc of
+ *  each cutoff once, at start-up, and FIR_designFrom() makes a filter of
+ *  the set with one multiply per tap: no sin() or cos() in real time.
+ */
+#ifndef FIR_
+#define FIR_
+
+#include <std.h>
+
+#define FIR_MAXTAPS     1024
+#define FIR_MAXCHANNELS 8
+#define FIR_SLACK       8           /* blocks between two copies of the history */
+
+#define FIR_LOWPASS     0
+#define FIR_HIGHPASS    1
+
+#define FIR_MAXDESIGNS  32          /* lengths and cutoffs of a FIR_Table */
+
+typedef struct FIR_Obj {
+    Int         maxTaps;            /* multiple of 4 */
+    Int         numTaps;            /* in use, rounded up to a multiple of 4 */
+    Int         numChannels;
+    Int         maxBlock;           /* samples per channel and call */
+    Int         length;             /* samples of each window */
+    Float       *coefs;             /* reversed: coefs[numTaps - 1] weighs the newest input */
+    Float       *hist[FIR_MAXCHANNELS];
+    Int         pos[FIR_MAXCHANNELS]; /* where the next block of each channel goes */
+} FIR_Obj;
+
+typedef struct FIR_Table {
+    Int         numLengths;
+    Int         numCutoffs;
+    Int         maxHalf;            /* (longest length - 1) / 2 */
+    Int         size;               /* Floats allocated */
+    Int         lengths[FIR_MAXDESIGNS]; /* odd */
+    Float       *window[FIR_MAXDESIGNS]; /* Blackman of each length, from its centre out */
+    Float       *sinc[FIR_MAXDESIGNS];   /* sin(2 pi fc t) / (pi t) of each cutoff, t = 0..maxHalf */
+} FIR_Table;
+
+extern Bool FIR_init(FIR_Obj *fir, Int maxTaps, Int numChannels, Int maxBlock, Int segid);
+extern Void FIR_delete(FIR_Obj *fir, Int segid);
+extern Bool FIR_setCoefs(FIR_Obj *fir, const Float *h, Int numTaps);
+extern Void FIR_apply(FIR_Obj *fir, Int ch, const Float *in, Float *out, Int n);
+extern Void FIR_reset(FIR_Obj *fir);
+extern Int FIR_design(Float *h, Int numTaps, Float cutoff, Int type);
+extern Bool FIR_initTable(FIR_Table *tab, Int numLengths, const Int lengths[], Int numCutoffs,
+    const Float cutoffs[], Int segid);
+extern Void FIR_deleteTable(FIR_Table *tab, Int segid);
+extern Int FIR_designFrom(const FIR_Table *tab, Float *h, Int length, Int cutoff, Int type);
+
+#endif /* FIR_ */
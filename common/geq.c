@@ -0,0 +1,370 @@
+/*
+ *  ======== geq.c ========
+ *  Graphic equaliser with its sections in SIMD lanes (see geq.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "biq.h"
+#include "geq.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#endif
+
+/*
+ *  Lanes of one register: the vector operations of the skewed cascade
+ *  for each instruction set, VSHIFT() moving every lane up by one with
+ *  'x' into lane 0 and VACTIVE() the lanes whose sample at step 't' is
+ *  one of the 'n' of the block.
+ */
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define LANES           16
+typedef __m512          Vec;
+typedef __mmask16       Mask;
+#define VLOAD(p)        _mm512_load_ps(p)
+#define VSTORE(p, v)    _mm512_store_ps(p, v)
+#define VSET1(x)        _mm512_set1_ps(x)
+#define VADD(a, b)      _mm512_add_ps(a, b)
+#define VSUB(a, b)      _mm512_sub_ps(a, b)
+#define VMUL(a, b)      _mm512_mul_ps(a, b)
+#define VINDEX          _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)
+#define VSHIFT(v, x)    _mm512_mask_mov_ps(_mm512_permutexvar_ps(_mm512_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6, \
+                            7, 8, 9, 10, 11, 12, 13, 14), v), 1, _mm512_set1_ps(x))
+#define VLAST(v)        _mm_cvtss_f32(_mm_shuffle_ps(_mm512_extractf32x4_ps(v, 3), \
+                            _mm512_extractf32x4_ps(v, 3), 3))
+#define VACTIVE(i, t, n) (_mm512_cmp_ps_mask(i, _mm512_set1_ps(t), _CMP_LE_OQ) & \
+                            _mm512_cmp_ps_mask(i, _mm512_set1_ps((t) - (n)), _CMP_GT_OQ))
+#define VSELECT(m, a, b) _mm512_mask_blend_ps(m, b, a)
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define LANES           8
+typedef __m256          Vec;
+typedef __m256          Mask;
+#define VLOAD(p)        _mm256_load_ps(p)
+#define VSTORE(p, v)    _mm256_store_ps(p, v)
+#define VSET1(x)        _mm256_set1_ps(x)
+#define VADD(a, b)      _mm256_add_ps(a, b)
+#define VSUB(a, b)      _mm256_sub_ps(a, b)
+#define VMUL(a, b)      _mm256_mul_ps(a, b)
+#define VINDEX          _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)
+#define VSHIFT(v, x)    _mm256_blend_ps(_mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6)), \
+                            _mm256_set1_ps(x), 1)
+#define VLAST(v)        _mm_cvtss_f32(_mm_shuffle_ps(_mm256_extractf128_ps(v, 1), _mm256_extractf128_ps(v, 1), 3))
+#define VACTIVE(i, t, n) _mm256_and_ps(_mm256_cmp_ps(i, _mm256_set1_ps(t), _CMP_LE_OQ), \
+                            _mm256_cmp_ps(i, _mm256_set1_ps((t) - (n)), _CMP_GT_OQ))
+#define VSELECT(m, a, b) _mm256_blendv_ps(b, a, m)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define LANES           4
+typedef __m128          Vec;
+typedef __m128          Mask;
+#define VLOAD(p)        _mm_load_ps(p)
+#define VSTORE(p, v)    _mm_store_ps(p, v)
+#define VSET1(x)        _mm_set1_ps(x)
+#define VADD(a, b)      _mm_add_ps(a, b)
+#define VSUB(a, b)      _mm_sub_ps(a, b)
+#define VMUL(a, b)      _mm_mul_ps(a, b)
+#define VINDEX          _mm_setr_ps(0, 1, 2, 3)
+#define VSHIFT(v, x)    _mm_move_ss(_mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)), _mm_set_ss(x))
+#define VLAST(v)        _mm_cvtss_f32(_mm_shuffle_ps(v, v, 3))
+#define VACTIVE(i, t, n) _mm_and_ps(_mm_cmple_ps(i, _mm_set1_ps(t)), _mm_cmpgt_ps(i, _mm_set1_ps((t) - (n))))
+#define VSELECT(m, a, b) _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b))
+#else
+#define LANES           4
+#endif
+
+#define STEPS       (2 * GEQ_MAXGAIN + 1)   /* gains in the table */
+
+#define COEFS(geq, g)       (&(geq)->coefs[(g) * 5 * LANES])
+#define STATE(geq, c, g)    (&(geq)->state[c][(g) * 2 * LANES])
+
+/* ISO centre frequencies */
+static const Float octave[] = {
+    31.5f, 63.0f, 125.0f, 250.0f, 500.0f, 1000.0f, 2000.0f, 4000.0f, 8000.0f, 16000.0f
+};
+static const Float third[] = {
+    20.0f, 25.0f, 31.5f, 40.0f, 50.0f, 63.0f, 80.0f, 100.0f, 125.0f, 160.0f, 200.0f, 250.0f, 315.0f,
+    400.0f, 500.0f, 630.0f, 800.0f, 1000.0f, 1250.0f, 1600.0f, 2000.0f, 2500.0f, 3150.0f, 4000.0f,
+    5000.0f, 6300.0f, 8000.0f, 10000.0f, 12500.0f, 16000.0f, 20000.0f
+};
+
+/*
+ *  ======== GEQ_init ========
+ *  Allocate an equaliser of 'type' (GEQ_OCTAVE or GEQ_THIRD) on
+ *  'numChannels' channels at 'rate' Hz in 'segid', and compute its
+ *  table.  Every band starts at 0 dB; a band too close to the Nyquist
+ *  frequency for 'rate' stays flat.
+ */
+Bool GEQ_init(GEQ_Obj *geq, Int type, Int numChannels, LgUns rate, Int segid)
+{
+    Double q = type == GEQ_OCTAVE ? sqrt(2.0) : pow(2.0, 1.0 / 6.0) / (pow(2.0, 1.0 / 3.0) - 1.0);
+    BIQ_Coefs k;
+    Float *t;
+    Int b, c, g;
+
+    if ((type != GEQ_OCTAVE && type != GEQ_THIRD) || numChannels < 1 || numChannels > GEQ_MAXCHANNELS ||
+        rate == 0) {
+        return (FALSE);
+    }
+    geq->freq = type == GEQ_OCTAVE ? octave : third;
+    geq->numBands = type == GEQ_OCTAVE ? sizeof(octave) / sizeof(octave[0]) : sizeof(third) / sizeof(third[0]);
+    geq->numChannels = numChannels;
+    geq->numGroups = (geq->numBands + LANES - 1) / LANES;
+
+    geq->table = MEM_alloc(segid, geq->numBands * STEPS * 5 * sizeof(Float), 8);
+    geq->coefs = MEM_alloc(segid, geq->numGroups * 5 * LANES * sizeof(Float), LANES * sizeof(Float));
+    geq->gain = MEM_calloc(segid, geq->numBands * sizeof(Int), 8);
+    geq->reload = MEM_alloc(segid, geq->numGroups * sizeof(Bool), 8);
+    if (geq->table == MEM_ILLEGAL || geq->coefs == MEM_ILLEGAL || geq->gain == MEM_ILLEGAL ||
+        geq->reload == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (c = 0; c < numChannels; c++) {
+        geq->state[c] = MEM_alloc(segid, geq->numGroups * 2 * LANES * sizeof(Float), LANES * sizeof(Float));
+        if (geq->state[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+
+    for (b = 0; b < geq->numBands; b++) {
+        for (g = -GEQ_MAXGAIN; g <= GEQ_MAXGAIN; g++) {
+            if (geq->freq[b] < 0.45 * rate) {
+                BIQ_design(&k, BIQ_PEAK, geq->freq[b] / rate, g, q);
+            }
+            else {
+                k.b0 = 1.0f;
+                k.b1 = k.b2 = k.a1 = k.a2 = 0.0f;
+            }
+            t = &geq->table[(b * STEPS + g + GEQ_MAXGAIN) * 5];
+            t[0] = k.b0;
+            t[1] = k.b1;
+            t[2] = k.b2;
+            t[3] = k.a1;
+            t[4] = k.a2;
+        }
+    }
+    for (g = 0; g < geq->numGroups; g++) {
+        geq->reload[g] = TRUE;
+    }
+    GEQ_reset(geq);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== GEQ_setGain ========
+ *  Gain of 'band' in dB, from the next block on.
+ */
+Bool GEQ_setGain(GEQ_Obj *geq, Int band, Int gainDb)
+{
+    if (band < 0 || band >= geq->numBands || gainDb < -GEQ_MAXGAIN || gainDb > GEQ_MAXGAIN) {
+        return (FALSE);
+    }
+    geq->gain[band] = gainDb;
+    geq->reload[band / LANES] = TRUE;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== GEQ_reset ========
+ *  Clear the state of every band and channel.
+ */
+Void GEQ_reset(GEQ_Obj *geq)
+{
+    Int c;
+
+    for (c = 0; c < geq->numChannels; c++) {
+        memset(geq->state[c], 0, geq->numGroups * 2 * LANES * sizeof(Float));
+    }
+}
+
+/*
+ *  ======== load ========
+ *  Coefficients of the lanes of group 'g' from the table, pass-through
+ *  for the lanes past the last band.
+ */
+static Void load(GEQ_Obj *geq, Int g)
+{
+    Float *k = COEFS(geq, g);
+    const Float *t;
+    Int b, l, i;
+
+    for (l = 0; l < LANES; l++) {
+        b = g * LANES + l;
+        if (b < geq->numBands) {
+            t = &geq->table[(b * STEPS + geq->gain[b] + GEQ_MAXGAIN) * 5];
+            for (i = 0; i < 5; i++) {
+                k[i * LANES + l] = t[i];
+            }
+        }
+        else {
+            k[l] = 1.0f;
+            for (i = 1; i < 5; i++) {
+                k[i * LANES + l] = 0.0f;
+            }
+        }
+    }
+}
+
+#ifdef VSHIFT
+/*
+ *  ======== group2 ========
+ *  The LANES sections of a group on two channels in place, skewed: at
+ *  step t, lane s filters sample t - s.  The output of the last lane at
+ *  step t is sample t - LANES + 1, whose input has been read already.
+ */
+static Void group2(const Float *k, Float *restrict sa, Float *restrict sb, Float *restrict xa,
+    Float *restrict xb, Int n)
+{
+    Vec b0 = VLOAD(k), b1 = VLOAD(k + LANES), b2 = VLOAD(k + 2 * LANES);
+    Vec a1 = VLOAD(k + 3 * LANES), a2 = VLOAD(k + 4 * LANES);
+    Vec a_1 = VLOAD(sa), a_2 = VLOAD(sa + LANES), b_1 = VLOAD(sb), b_2 = VLOAD(sb + LANES);
+    Vec ya = VSET1(0.0f), yb = VSET1(0.0f), lane = VINDEX, x, s1, s2;
+    Mask m;
+    Int t;
+
+    for (t = 0; t < n + LANES - 1; t++) {
+        x = VSHIFT(ya, t < n ? xa[t] : 0.0f);
+        ya = VADD(VMUL(b0, x), a_1);
+        s1 = VADD(VSUB(VMUL(b1, x), VMUL(a1, ya)), a_2);
+        s2 = VSUB(VMUL(b2, x), VMUL(a2, ya));
+        if (t >= LANES - 1 && t < n) {
+            a_1 = s1;
+            a_2 = s2;
+        }
+        else {
+            m = VACTIVE(lane, (Float)t, (Float)n);
+            a_1 = VSELECT(m, s1, a_1);
+            a_2 = VSELECT(m, s2, a_2);
+        }
+
+        x = VSHIFT(yb, t < n ? xb[t] : 0.0f);
+        yb = VADD(VMUL(b0, x), b_1);
+        s1 = VADD(VSUB(VMUL(b1, x), VMUL(a1, yb)), b_2);
+        s2 = VSUB(VMUL(b2, x), VMUL(a2, yb));
+        if (t >= LANES - 1 && t < n) {
+            b_1 = s1;
+            b_2 = s2;
+        }
+        else {
+            b_1 = VSELECT(m, s1, b_1);
+            b_2 = VSELECT(m, s2, b_2);
+        }
+
+        if (t >= LANES - 1) {
+            xa[t - LANES + 1] = VLAST(ya);
+            xb[t - LANES + 1] = VLAST(yb);
+        }
+    }
+    VSTORE(sa, a_1);
+    VSTORE(sa + LANES, a_2);
+    VSTORE(sb, b_1);
+    VSTORE(sb + LANES, b_2);
+}
+
+/*
+ *  ======== group1 ========
+ *  group2() on one channel.
+ */
+static Void group1(const Float *k, Float *restrict st, Float *restrict x, Int n)
+{
+    Vec b0 = VLOAD(k), b1 = VLOAD(k + LANES), b2 = VLOAD(k + 2 * LANES);
+    Vec a1 = VLOAD(k + 3 * LANES), a2 = VLOAD(k + 4 * LANES);
+    Vec z1 = VLOAD(st), z2 = VLOAD(st + LANES);
+    Vec y = VSET1(0.0f), lane = VINDEX, in, s1, s2;
+    Mask m;
+    Int t;
+
+    for (t = 0; t < n + LANES - 1; t++) {
+        in = VSHIFT(y, t < n ? x[t] : 0.0f);
+        y = VADD(VMUL(b0, in), z1);
+        s1 = VADD(VSUB(VMUL(b1, in), VMUL(a1, y)), z2);
+        s2 = VSUB(VMUL(b2, in), VMUL(a2, y));
+        if (t >= LANES - 1 && t < n) {
+            z1 = s1;
+            z2 = s2;
+        }
+        else {
+            m = VACTIVE(lane, (Float)t, (Float)n);
+            z1 = VSELECT(m, s1, z1);
+            z2 = VSELECT(m, s2, z2);
+        }
+        if (t >= LANES - 1) {
+            x[t - LANES + 1] = VLAST(y);
+        }
+    }
+    VSTORE(st, z1);
+    VSTORE(st + LANES, z2);
+}
+#else
+/*
+ *  ======== group1 ========
+ *  The LANES sections of a group on one channel in place, one after
+ *  the other.
+ */
+static Void group1(const Float *k, Float *restrict st, Float *restrict x, Int n)
+{
+    Float b0, b1, b2, a1, a2, s1, s2, in, y;
+    Int i, l;
+
+    for (l = 0; l < LANES; l++) {
+        b0 = k[l];
+        b1 = k[LANES + l];
+        b2 = k[2 * LANES + l];
+        a1 = k[3 * LANES + l];
+        a2 = k[4 * LANES + l];
+        s1 = st[l];
+        s2 = st[LANES + l];
+        for (i = 0; i < n; i++) {
+            in = x[i];
+            y = b0 * in + s1;
+            s1 = b1 * in - a1 * y + s2;
+            s2 = b2 * in - a2 * y;
+            x[i] = y;
+        }
+        st[l] = s1;
+        st[LANES + l] = s2;
+    }
+}
+
+static Void group2(const Float *k, Float *sa, Float *sb, Float *xa, Float *xb, Int n)
+{
+    group1(k, sa, xa, n);
+    group1(k, sb, xb, n);
+}
+#endif
+
+/*
+ *  ======== GEQ_apply ========
+ *  Equalise 'n' samples of each channel of 'ch' in place, with the
+ *  gains last set.
+ */
+Void GEQ_apply(GEQ_Obj *geq, Float *ch[], Int n)
+{
+    Int c, g;
+
+    for (g = 0; g < geq->numGroups; g++) {
+        if (geq->reload[g]) {
+            geq->reload[g] = FALSE;
+            load(geq, g);
+        }
+    }
+    if (n < 1) {
+        return;
+    }
+    for (c = 0; c + 1 < geq->numChannels; c += 2) {
+        for (g = 0; g < geq->numGroups; g++) {
+            group2(COEFS(geq, g), STATE(geq, c, g), STATE(geq, c + 1, g), ch[c], ch[c + 1], n);
+        }
+    }
+    if (c < geq->numChannels) {
+        for (g = 0; g < geq->numGroups; g++) {
+            group1(COEFS(geq, g), STATE(geq, c, g), ch[c], n);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ *  ======== geq.h ========
+ *  Graphic equaliser of 10 (octave) or 31 (third-octave) bands on
+ *  planar channels.
+ *
+ *  Each band is a peaking section (biq.h) at its ISO centre frequency,
+ *  with the bandwidth of its slider, and the bands are in cascade.  A
+ *  cascade is serial, but not in time: section s can filter sample t
+ *  while section s + 1 filters sample t - 1.  GEQ_apply() runs the
+ *  sections in the lanes of a SIMD register, skewed that way: at each
+ *  step every lane takes the output of the lane below from the previous
+ *  step, lane 0 takes the next input and the last lane gives an output.
+ *  One step of recursion then advances as many sections as there are
+ *  lanes, with the same operations as biq.c and no added latency (the
+ *  first and last steps of a block only update the lanes whose sample
+ *  is in the block).  The lanes are 4 with SSE2, 8 with AVX2 and 16
+ *  with AVX-512 (host built with ARCHFLAGS=-march=native), and two
+ *  channels share each loop.  Without SIMD (C6x) the same layout is
+ *  run one section after the other.
+ *
+ *  The coefficients of every band at every whole dB from -GEQ_MAXGAIN
+ *  to +GEQ_MAXGAIN are computed by GEQ_init(), so GEQ_setGain() does no
+ *  arithmetic: it records the gain and marks the band's group of lanes,
+ *  which GEQ_apply() reloads from the table before its next block.  It
+ *  may be called from any thread.  The new coefficients apply from the
+ *  next block, without a ramp: 1 dB steps do not click.
+ */
+#ifndef GEQ_
+#define GEQ_
+
+#include <std.h>
+
+#define GEQ_OCTAVE      0           /* 10 bands, 31.5 Hz to 16 kHz */
+#define GEQ_THIRD       1           /* 31 bands, 20 Hz to 20 kHz */
+
+#define GEQ_MAXBANDS    31
+#define GEQ_MAXCHANNELS 8
+#define GEQ_MAXGAIN     12          /* dB, either way */
+
+typedef struct GEQ_Obj {
+    Int         numBands;
+    Int         numChannels;
+    Int         numGroups;          /* of lanes */
+    const Float *freq;              /* centre of each band, Hz */
+    Float       *table;             /* b0, b1, b2, a1, a2 of each band and gain */
+    Float       *coefs;             /* b0, b1, b2, a1, a2 of each lane, per group */
+    volatile Int *gain;             /* dB, of each band */
+    volatile Bool *reload;          /* of each group, set by GEQ_setGain() */
+    Float       *state[GEQ_MAXCHANNELS]; /* s1, s2 of each lane, per group */
+} GEQ_Obj;
+
+extern Bool GEQ_init(GEQ_Obj *geq, Int type, Int numChannels, LgUns rate, Int segid);
+extern Bool GEQ_setGain(GEQ_Obj *geq, Int band, Int gainDb);
+extern Void GEQ_apply(GEQ_Obj *geq, Float *ch[], Int n);
+extern Void GEQ_reset(GEQ_Obj *geq);
+
+#endif /* GEQ_ */
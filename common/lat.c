@@ -0,0 +1,110 @@
+/*
+ *  ======== lat.c ========
+ *  Measured input to output latency (see lat.h).
+ */
+#include <std.h>
+#include <log.h>
+#include <mem.h>
+
+#include "lat.h"
+
+/*
+ *  ======== LAT_init ========
+ *  Allocate the recording in 'segid' and generate the sequence, with
+ *  the feedback polynomial x^7 + x^6 + 1.
+ */
+Bool LAT_init(LAT_Obj *lat, LOG_Obj *log, Int segid)
+{
+    Uns reg = 1;
+    Int i;
+
+    lat->log = log;
+    lat->state = LAT_IDLE;
+    lat->request = 0;
+    lat->latency = -1;
+    for (i = 0; i < LAT_MLSLEN; i++) {
+        lat->mls[i] = (reg & 1) ? 1 : -1;
+        reg = ((reg << 1) | (((reg >> 6) ^ (reg >> 5)) & 1)) & LAT_MLSLEN;
+    }
+    lat->rec = MEM_alloc(segid, LAT_RECLEN * sizeof(Short), 0);
+
+    return (lat->rec != MEM_ILLEGAL);
+}
+
+/*
+ *  ======== correlate ========
+ *  Analyse 'n' more lags and keep the peak.
+ */
+static Void correlate(LAT_Obj *lat, Int n)
+{
+    Short *x;
+    LgInt c;
+    Int i;
+
+    for (; n > 0 && lat->pos < LAT_MAXLAG; n--, lat->pos++) {
+        x = lat->rec + lat->pos;
+        for (c = 0, i = 0; i < LAT_MLSLEN; i++) {
+            c += lat->mls[i] > 0 ? x[i] : -x[i];
+        }
+        if (c < 0) {
+            c = -c;
+        }
+        lat->sum += c;
+        if (c > lat->peak) {
+            lat->peak = c;
+            lat->latency = lat->pos;
+        }
+    }
+}
+
+/*
+ *  ======== LAT_loop ========
+ *  Called by echo() with its input frame and its output frame of 'size'
+ *  interleaved stereo samples, after it processed them.
+ */
+Void LAT_loop(LAT_Obj *lat, Int request, Short *src, Short *dst, Int size)
+{
+    Int i;
+
+    if (request != 0 && lat->request == 0 && lat->rec != MEM_ILLEGAL) {
+        lat->state = LAT_RECORD;
+        lat->pos = 0;
+    }
+    lat->request = request;
+
+    switch (lat->state) {
+        case LAT_RECORD:
+            for (i = 0; i < size; i += 2) {
+                if (lat->pos < LAT_RECLEN) {
+                    lat->rec[lat->pos] = src[i];
+                }
+                dst[i] = dst[i + 1] = lat->pos < LAT_MLSLEN ? lat->mls[lat->pos] * LAT_AMPLITUDE : 0;
+                lat->pos++;
+            }
+            if (lat->pos >= LAT_RECLEN) {
+                lat->state = LAT_ANALYSE;
+                lat->pos = 0;
+                lat->peak = 0;
+                lat->sum = 0;
+                lat->latency = -1;
+            }
+            break;
+
+        case LAT_ANALYSE:
+            for (i = 0; i < size; i++) {
+                dst[i] = 0;
+            }
+            correlate(lat, size / 2);
+            if (lat->pos == LAT_MAXLAG) {
+                if (lat->peak < LAT_MINRATIO * (LgInt)(lat->sum / LAT_MAXLAG)) {
+                    lat->latency = -1;
+                }
+                LOG_printf(lat->log, "latence: %d echantillons (crete %d)", (Int)lat->latency, (Int)lat->peak);
+                lat->state = LAT_DONE;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
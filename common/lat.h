@@ -0,0 +1,56 @@
+/*
+ *  ======== lat.h ========
+ *  Measured input to output latency.
+ *
+ *  With the line output wired back to the line input, LAT_loop() plays
+ *  a burst of maximum length sequence (MLS) in place of the output of
+ *  echo() and records the left channel of the input.  Once the
+ *  recording is complete it cross-correlates it with the sequence, a
+ *  few lags per frame so that the SWI keeps its deadline, and logs the
+ *  lag of the correlation peak: the number of samples (per channel)
+ *  between the moment echo() writes a sample and the moment it reads
+ *  it back, i.e. the primed transmit frames plus the delay of the
+ *  converters and of the cable.
+ *
+ *  On the host the simulated codec provides the loop (host -m), so the
+ *  result is exactly the primed frames times the frame size.
+ *
+ *  A measurement starts each time the request passed to LAT_loop()
+ *  changes from 0 to non-zero (a slider).  The peak must stand out of
+ *  the mean of the correlation by LAT_MINRATIO, otherwise nothing came
+ *  back and the latency is reported as -1.
+ */
+#ifndef LAT_
+#define LAT_
+
+#include <std.h>
+#include <log.h>
+
+#define LAT_ORDER       7                           /* MLS of 2^7-1 samples */
+#define LAT_MLSLEN      ((1 << LAT_ORDER) - 1)
+#define LAT_MAXLAG      16384                       /* samples per channel */
+#define LAT_RECLEN      (LAT_MAXLAG + LAT_MLSLEN)
+#define LAT_AMPLITUDE   8192                        /* -12 dBFS */
+#define LAT_MINRATIO    8
+
+#define LAT_IDLE        0
+#define LAT_RECORD      1
+#define LAT_ANALYSE     2
+#define LAT_DONE        3
+
+typedef struct LAT_Obj {
+    LOG_Obj     *log;           /* where the result is printed */
+    Short       *rec;           /* LAT_RECLEN samples of the left input */
+    Short       mls[LAT_MLSLEN]; /* +1/-1 */
+    Int         state;
+    Int         request;        /* last value of the request */
+    Int         pos;            /* samples recorded, then lags analysed */
+    LgInt       peak;
+    LgUns       sum;            /* of |correlation| over the lags */
+    Int         latency;        /* samples per channel, -1 if not found */
+} LAT_Obj;
+
+extern Bool LAT_init(LAT_Obj *lat, LOG_Obj *log, Int segid);
+extern Void LAT_loop(LAT_Obj *lat, Int request, Short *src, Short *dst, Int size);
+
+#endif /* LAT_ */
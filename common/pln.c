@@ -0,0 +1,175 @@
+/*
+ *  ======== pln.c ========
+ *  Conversion of 16-bit frames to and from float, planar (deinterleaved)
+ *  or interleaved (see pln.h).
+ */
+#include <std.h>
+
+#include "blk.h"
+#include "pln.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#endif
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/*
+ *  ======== PLN_split ========
+ *  Deinterleave 'n' stereo samples of 'src' into 'left' and 'right',
+ *  normalised to [-1, 1).
+ */
+Void PLN_split(const Short *restrict src, Float *restrict left, Float *restrict right, Int n)
+{
+    const Float scale = 1.0f / PLN_SCALE;
+    Int i = 0;
+
+#if defined(_TMS320C6X)
+    /* one 32-bit load per sample pair: left in the low half, right in the high half */
+    #pragma MUST_ITERATE(BLK_MINSIZE / 2)
+    for (i = 0; i < n; i++) {
+        Int pair = _amem4_const(&src[2 * i]);
+
+        left[i] = (Float)_ext(pair, 16, 16) * scale;
+        right[i] = (Float)(pair >> 16) * scale;
+    }
+#else
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    /* 4 sample pairs per iteration, split by sign-extending the halves of each 32-bit lane */
+    for (; i + 4 <= n; i += 4) {
+        __m128i pairs = _mm_loadu_si128((const __m128i *)&src[2 * i]);
+        __m128i l = _mm_srai_epi32(_mm_slli_epi32(pairs, 16), 16);
+        __m128i r = _mm_srai_epi32(pairs, 16);
+
+        _mm_storeu_ps(&left[i], _mm_mul_ps(_mm_cvtepi32_ps(l), vscale));
+        _mm_storeu_ps(&right[i], _mm_mul_ps(_mm_cvtepi32_ps(r), vscale));
+    }
+#endif
+    for (; i < n; i++) {
+        left[i] = (Float)src[2 * i] * scale;
+        right[i] = (Float)src[2 * i + 1] * scale;
+    }
+#endif
+}
+
+/*
+ *  ======== PLN_merge ========
+ *  Interleave 'n' samples of 'left' and 'right' into 'dst', scaled back
+ *  to 16 bits, truncated and saturated.
+ */
+Void PLN_merge(const Float *restrict left, const Float *restrict right, Short *restrict dst, Int n)
+{
+    Int i = 0;
+
+#if defined(_TMS320C6X)
+    /* one 32-bit store per sample pair */
+    #pragma MUST_ITERATE(BLK_MINSIZE / 2)
+    for (i = 0; i < n; i++) {
+        Int l = PLN_sat16(left[i] * PLN_SCALE);
+        Int r = PLN_sat16(right[i] * PLN_SCALE);
+
+        _amem4(&dst[2 * i]) = (r << 16) | (l & 0xffff);
+    }
+#else
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(PLN_SCALE);
+    const __m128 lo = _mm_set1_ps(-PLN_SCALE);
+    const __m128 hi = _mm_set1_ps(PLN_SCALE - 1.0f);
+
+    /* truncate 4 samples of each channel, interleave the 32-bit lanes and pack them with saturation */
+    for (; i + 4 <= n; i += 4) {
+        __m128 fl = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&left[i]), vscale), lo), hi);
+        __m128 fr = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&right[i]), vscale), lo), hi);
+        __m128i l = _mm_cvttps_epi32(fl);
+        __m128i r = _mm_cvttps_epi32(fr);
+
+        _mm_storeu_si128((__m128i *)&dst[2 * i],
+            _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[2 * i] = PLN_sat16(left[i] * PLN_SCALE);
+        dst[2 * i + 1] = PLN_sat16(right[i] * PLN_SCALE);
+    }
+#endif
+}
+
+/*
+ *  ======== PLN_toFloat ========
+ *  Convert 'n' samples of 'src' to floats in 'dst', normalised to
+ *  [-1, 1), in the same (interleaved) order.
+ */
+Void PLN_toFloat(const Short *restrict src, Float *restrict dst, Int n)
+{
+    const Float scale = 1.0f / PLN_SCALE;
+    Int i = 0;
+
+#if defined(_TMS320C6X)
+    /* one 32-bit load per sample pair, n is even */
+    #pragma MUST_ITERATE(BLK_MINSIZE / 2)
+    for (i = 0; i < n; i += 2) {
+        Int pair = _amem4_const(&src[i]);
+
+        dst[i] = (Float)_ext(pair, 16, 16) * scale;
+        dst[i + 1] = (Float)(pair >> 16) * scale;
+    }
+#else
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+
+    /* 8 samples per iteration, sign-extended by unpacking each one into the high half of a lane */
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+        _mm_storeu_ps(&dst[i], _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(&dst[i + 4], _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = (Float)src[i] * scale;
+    }
+#endif
+}
+
+/*
+ *  ======== PLN_toShort ========
+ *  Convert 'n' floats of 'src' back to 16 bits in 'dst', in the same
+ *  order, truncated and saturated.
+ */
+Void PLN_toShort(const Float *restrict src, Short *restrict dst, Int n)
+{
+    Int i = 0;
+
+#if defined(_TMS320C6X)
+    /* one 32-bit store per sample pair, n is even */
+    #pragma MUST_ITERATE(BLK_MINSIZE / 2)
+    for (i = 0; i < n; i += 2) {
+        Int a = PLN_sat16(src[i] * PLN_SCALE);
+        Int b = PLN_sat16(src[i + 1] * PLN_SCALE);
+
+        _amem4(&dst[i]) = (b << 16) | (a & 0xffff);
+    }
+#else
+#if defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(PLN_SCALE);
+    const __m128 lo = _mm_set1_ps(-PLN_SCALE);
+    const __m128 hi = _mm_set1_ps(PLN_SCALE - 1.0f);
+
+    /* 8 samples per iteration, packed with saturation */
+    for (; i + 8 <= n; i += 8) {
+        __m128 f0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&src[i]), vscale), lo), hi);
+        __m128 f1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(&src[i + 4]), vscale), lo), hi);
+
+        _mm_storeu_si128((__m128i *)&dst[i], _mm_packs_epi32(_mm_cvttps_epi32(f0), _mm_cvttps_epi32(f1)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = PLN_sat16(src[i] * PLN_SCALE);
+    }
+#endif
+}
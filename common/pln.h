@@ -0,0 +1,61 @@
+/*
+ *  ======== pln.h ========
+ *  Conversion of 16-bit frames to and from float, planar (deinterleaved)
+ *  or interleaved.  Every effect converts through this module.
+ *
+ *  A PIP frame holds interleaved 16-bit stereo samples (L R L R ...).
+ *  Kernels that read every other sample of it cannot be vectorised and
+ *  carry the state of both channels in the same loop.  PLN_split()
+ *  instead converts a frame into one contiguous array of floats per
+ *  channel, normalised to [-1, 1), so that each channel runs through
+ *  its own unit-stride loop, and PLN_merge() converts the two arrays
+ *  back into an interleaved frame.
+ *
+ *  Both conversions are fused with the deinterleaving and vectorised:
+ *  SSE2 on the host, paired 16-bit loads and stores (_amem4) on the
+ *  C67x.  The conversion to 16 bits truncates like a C cast and
+ *  saturates to [-32768, 32767] without a branch.
+ *
+ *  'n' is the number of samples per channel, i.e. half the size of the
+ *  frame (BLK_config.size / 2); the frame must be 4-byte aligned, as
+ *  PIP frames are.
+ *
+ *  PLN_toFloat() and PLN_toShort() do the same conversions without
+ *  deinterleaving, for effects that work on the interleaved frame; their
+ *  'n' is the number of samples of the frame (BLK_config.size), even.
+ *  "bench -c" compares all four with the loops they replace.
+ *
+ *  An effect that reads the receive frame and writes the transmit frame
+ *  in one loop, without a frame of floats in between, converts each
+ *  sample itself: x / PLN_SCALE on the way in, PLN_sat16(y * PLN_SCALE)
+ *  on the way out, the same conversions as above one sample at a time.
+ */
+#ifndef PLN_
+#define PLN_
+
+#include <std.h>
+
+#define PLN_SCALE       32768.0f        /* full scale of a 16-bit sample */
+
+/*
+ *  ======== PLN_sat16 ========
+ *  Truncate 'x' (in 16-bit units) to an integer and saturate it.
+ */
+static inline Int PLN_sat16(Float x)
+{
+#ifdef _TMS320C6X
+    return (_sshl((Int)x, 16) >> 16);
+#else
+    /* clamp first: the conversion of an out of range float is undefined */
+    x = x < -PLN_SCALE ? -PLN_SCALE : x;
+    x = x > PLN_SCALE - 1.0f ? PLN_SCALE - 1.0f : x;
+    return ((Int)x);
+#endif
+}
+
+extern Void PLN_split(const Short *src, Float *left, Float *right, Int n);
+extern Void PLN_merge(const Float *left, const Float *right, Short *dst, Int n);
+extern Void PLN_toFloat(const Short *src, Float *dst, Int n);
+extern Void PLN_toShort(const Float *src, Short *dst, Int n);
+
+#endif /* PLN_ */
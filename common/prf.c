@@ -0,0 +1,111 @@
+/*
+ *  ======== prf.c ========
+ *  Per-stage timing of the audio path (see prf.h).
+ */
+#include <std.h>
+#include <clk.h>
+#include <sts.h>
+
+#include "prf.h"
+
+#ifdef _TMS320C6X
+#define ilog2(x)    (31 - _lmbd(1, (x)))
+#define barrier()
+#else
+#define ilog2(x)    (31 - __builtin_clz(x))
+#define barrier()   __sync_synchronize()
+#endif
+
+/*
+ *  ======== PRF_init ========
+ */
+Void PRF_init(PRF_Obj *prf, Int numStages, String names[])
+{
+    Int i, b;
+
+    prf->seq = 0;
+    prf->numStages = numStages < PRF_MAXSTAGES ? numStages : PRF_MAXSTAGES;
+    prf->missed = 0;
+    prf->start = CLK_gethtime();
+    for (i = 0; i < prf->numStages; i++) {
+        prf->stage[i].name = names[i];
+        prf->stage[i].sts = NULL;
+        prf->stage[i].num = 0;
+        prf->stage[i].total = 0;
+        prf->stage[i].min = ~0UL;
+        prf->stage[i].max = 0;
+        for (b = 0; b < PRF_NUMBINS; b++) {
+            prf->stage[i].hist[b] = 0;
+        }
+    }
+}
+
+/*
+ *  ======== PRF_bindSts ========
+ */
+Void PRF_bindSts(PRF_Obj *prf, Int stage, STS_Obj *sts)
+{
+    prf->stage[stage].sts = sts;
+}
+
+/*
+ *  ======== PRF_record ========
+ *  Account the time since the previous mark to 'stage'.
+ */
+Void PRF_record(PRF_Obj *prf, Int stage)
+{
+    PRF_Stage *s = &prf->stage[stage];
+    LgUns now = CLK_gethtime();
+    LgUns delta = now - prf->start;
+    Uns d = delta > 0xffffffffUL ? 0xffffffffU : (Uns)delta;
+
+    prf->seq++;
+    barrier();
+    s->num++;
+    s->total += delta;
+    if (delta < s->min) {
+        s->min = delta;
+    }
+    if (delta > s->max) {
+        s->max = delta;
+    }
+    s->hist[d != 0 ? ilog2(d) : 0]++;
+    barrier();
+    prf->seq++;
+
+    if (s->sts != NULL) {
+        STS_add(s->sts, (LgInt)delta);
+    }
+
+    /* the next stage starts now, the cost of this mark is charged to it */
+    prf->start = now;
+}
+
+/*
+ *  ======== PRF_recordMissed ========
+ */
+Void PRF_recordMissed(PRF_Obj *prf)
+{
+    prf->seq++;
+    barrier();
+    prf->missed++;
+    barrier();
+    prf->seq++;
+}
+
+/*
+ *  ======== PRF_read ========
+ *  Consistent copy of 'prf', taken without stopping the writer.
+ */
+Void PRF_read(PRF_Obj *prf, PRF_Obj *copy)
+{
+    Uns seq;
+
+    do {
+        while ((seq = prf->seq) & 1) {
+        }
+        barrier();
+        *copy = *(PRF_Obj *)prf;
+        barrier();
+    } while (prf->seq != seq);
+}
@@ -0,0 +1,64 @@
+/*
+ *  ======== prf.h ========
+ *  Per-stage timing of the audio path.
+ *
+ *  echo() calls PRF_begin() when it starts working on a frame and
+ *  PRF_mark() at the end of each stage.  Each mark accumulates the time
+ *  since the previous one (CLK_gethtime() counts: timer ticks on the DSK,
+ *  time-stamp counter ticks on a host build) into the minimum, maximum,
+ *  total and a log2 histogram of its stage.  When a stage is bound to an
+ *  STS object of the configuration, its durations are also added there
+ *  so that they show in the Statistics View.
+ *
+ *  The statistics are written by the SWI only.  Readers take a copy with
+ *  PRF_read(), which retries when the SWI updated the object meanwhile
+ *  instead of locking it out, so the instrumentation never delays the
+ *  SWI.
+ *
+ *  Build with PRF_DISABLE defined to compile the marks out.
+ */
+#ifndef PRF_
+#define PRF_
+
+#include <std.h>
+#include <clk.h>
+#include <sts.h>
+
+#define PRF_MAXSTAGES   4
+#define PRF_NUMBINS     32      /* bin b counts durations in [2^b, 2^(b+1)) */
+
+typedef struct PRF_Stage {
+    String      name;
+    STS_Obj     *sts;           /* optional, NULL if not bound */
+    LgUns       num;
+    LgUns       total;
+    LgUns       min;
+    LgUns       max;
+    Uns         hist[PRF_NUMBINS];
+} PRF_Stage;
+
+typedef struct PRF_Obj {
+    volatile Uns seq;           /* odd while the SWI updates the object */
+    Int         numStages;
+    LgUns       missed;         /* frames echo() was posted for but could not process */
+    LgUns       start;          /* CLK_gethtime() at the previous mark */
+    PRF_Stage   stage[PRF_MAXSTAGES];
+} PRF_Obj;
+
+extern Void PRF_init(PRF_Obj *prf, Int numStages, String names[]);
+extern Void PRF_bindSts(PRF_Obj *prf, Int stage, STS_Obj *sts);
+extern Void PRF_record(PRF_Obj *prf, Int stage);
+extern Void PRF_recordMissed(PRF_Obj *prf);
+extern Void PRF_read(PRF_Obj *prf, PRF_Obj *copy);
+
+#ifndef PRF_DISABLE
+#define PRF_begin(prf)          ((prf)->start = CLK_gethtime())
+#define PRF_mark(prf, stage)    PRF_record((prf), (stage))
+#define PRF_missed(prf)         PRF_recordMissed(prf)
+#else
+#define PRF_begin(prf)
+#define PRF_mark(prf, stage)
+#define PRF_missed(prf)
+#endif
+
+#endif /* PRF_ */
@@ -0,0 +1,309 @@
+/*
+ *  ======== src.c ========
+ *  Sample-rate conversion of planar channels (see src.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "src.h"
+
+#ifdef _TMS320C6X
+#define restrict    restrict
+#else
+#define restrict    __restrict
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#define PI          3.14159265358979
+#define BETA        8.0             /* Kaiser window, about 80 dB of stop band */
+#define CUTOFF      0.95            /* of the lower Nyquist frequency */
+
+/*
+ *  ======== bessel ========
+ *  Modified Bessel function of the first kind of order 0.
+ */
+static Double bessel(Double x)
+{
+    Double sum = 1.0, term = 1.0;
+    Int k;
+
+    for (k = 1; k < 50 && term > 1e-12 * sum; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+
+    return (sum);
+}
+
+/*
+ *  ======== proto ========
+ *  Tap 'i' of an 'n'-tap Kaiser-windowed sinc cut off at 'fc' times its
+ *  sampling frequency.
+ */
+static Double proto(Int i, Int n, Double fc)
+{
+    Double t = i - (n - 1) / 2.0, r = 2.0 * i / (n - 1) - 1.0;
+    Double s = t == 0.0 ? 2.0 * fc : sin(2.0 * PI * fc * t) / (PI * t);
+
+    return (s * bessel(BETA * sqrt(r * r < 1.0 ? 1.0 - r * r : 0.0)) / bessel(BETA));
+}
+
+/*
+ *  ======== dot ========
+ *  sum(a[k] * b[k], k = 0..n-1), n a multiple of 4.
+ */
+static Float dot(const Float *restrict a, const Float *restrict b, Int n)
+{
+#ifdef __SSE2__
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    Float r[4];
+    Int k;
+
+    for (k = 0; k + 8 <= n; k += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&a[k]), _mm_loadu_ps(&b[k])));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(&a[k + 4]), _mm_loadu_ps(&b[k + 4])));
+    }
+    if (k < n) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(&a[k]), _mm_loadu_ps(&b[k])));
+    }
+    _mm_storeu_ps(r, _mm_add_ps(s0, s1));
+
+    return ((r[0] + r[1]) + (r[2] + r[3]));
+#else
+    Float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    Int k;
+
+    for (k = 0; k < n; k += 4) {
+        s0 += a[k] * b[k];
+        s1 += a[k + 1] * b[k + 1];
+        s2 += a[k + 2] * b[k + 2];
+        s3 += a[k + 3] * b[k + 3];
+    }
+
+    return ((s0 + s1) + (s2 + s3));
+#endif
+}
+
+/*
+ *  ======== stageInit ========
+ *  Allocate and design a stage converting by up / down, a half-band
+ *  stage if 'halfBand'.  Returns its largest output block.
+ */
+static Int stageInit(SRC_Stage *st, Int up, Int down, Bool halfBand, Int numChannels, Int maxIn, Int segid)
+{
+    Double sum, h;
+    Int n, keep, room, c, p, k;
+
+    st->up = up;
+    st->down = down;
+    st->halfBand = halfBand;
+    st->taps = halfBand ? SRC_HBTAPS : SRC_TAPS;
+    st->span = halfBand && down == 2 ? 2 * SRC_HBTAPS - 1 : st->taps;
+    st->phase = 0;
+    st->next = 0;
+    st->maxIn = maxIn;
+    keep = st->span - 1;
+    room = SRC_SLACK * maxIn > st->span ? SRC_SLACK * maxIn : st->span;
+    st->length = keep + room;
+    st->pos = keep;
+
+    st->coefs = MEM_alloc(segid, (halfBand ? 1 : up) * st->taps * sizeof(Float), 8);
+    if (st->coefs == MEM_ILLEGAL) {
+        return (-1);
+    }
+    for (c = 0; c < numChannels; c++) {
+        st->hist[c] = MEM_calloc(segid, st->length * sizeof(Float), 8);
+        if (st->hist[c] == MEM_ILLEGAL) {
+            return (-1);
+        }
+    }
+
+    if (halfBand) {
+        /* 2 * taps - 1 taps cut off at a quarter, the even ones summing to 1/2 */
+        n = 2 * st->taps - 1;
+        for (sum = 0.0, k = 0; k < st->taps; k++) {
+            sum += proto(2 * k, n, 0.25);
+        }
+        for (k = 0; k < st->taps; k++) {
+            h = proto(2 * k, n, 0.25) * 0.5 / sum;
+            if (up == 2) {
+                st->coefs[st->taps - 1 - k] = 2.0 * h;      /* y[2i] = sum(2 h[2k] x[i - k]) */
+            }
+            else {
+                st->coefs[k] = h;                           /* y[i] = sum(h[2k] x[2i - 2k]) + x[2i - middle] / 2 */
+            }
+        }
+
+        return (up == 2 ? 2 * maxIn : maxIn / 2 + 1);
+    }
+
+    /* up * taps taps, phase p holding taps p, p + up, ... reversed, each phase summing to about 1 */
+    n = up * st->taps;
+    for (sum = 0.0, k = 0; k < n; k++) {
+        sum += proto(k, n, CUTOFF * 0.5 / (up > down ? up : down));
+    }
+    for (p = 0; p < up; p++) {
+        for (k = 0; k < st->taps; k++) {
+            st->coefs[p * st->taps + st->taps - 1 - k] =
+                proto(p + k * up, n, CUTOFF * 0.5 / (up > down ? up : down)) * up / sum;
+        }
+    }
+
+    return ((Int)(((LgUns)maxIn * up + down - 1) / down) + 1);
+}
+
+/*
+ *  ======== stageRun ========
+ *  Convert a block of 'n' samples of each channel of 'in' into 'out',
+ *  returns the number of outputs.
+ */
+static Int stageRun(SRC_Stage *st, Int numChannels, Float *in[], Int n, Float *out[])
+{
+    const Float *x;
+    Float *y;
+    Int keep = st->span - 1, half = st->taps / 2 - 1, middle = st->taps - 1;
+    Int c, i = st->next, p = st->phase, m = 0;
+
+    for (c = 0; c < numChannels; c++) {
+        if (st->pos + n > st->length) {
+            memmove(st->hist[c], st->hist[c] + st->pos - keep, keep * sizeof(Float));
+        }
+    }
+    if (st->pos + n > st->length) {
+        st->pos = keep;
+    }
+
+    for (c = 0; c < numChannels; c++) {
+        memcpy(st->hist[c] + st->pos, in[c], n * sizeof(Float));
+        x = st->hist[c] + st->pos;          /* x[-1], x[-2]... : history */
+        y = out[c];
+        m = 0;
+        i = st->next;
+        p = st->phase;
+        if (st->halfBand && st->up == 2) {
+            for (; i < n; i++) {
+                y[m++] = dot(st->coefs, x + i - st->taps + 1, st->taps);
+                y[m++] = x[i - half];
+            }
+        }
+        else if (st->halfBand) {
+            for (; i < n; i += 2) {
+                const Float *xi = x + i;
+                Float s0 = 0.5f * xi[-middle], s1 = 0.0f;
+                Int k;
+
+                for (k = 0; k < st->taps; k += 2) {
+                    s0 += st->coefs[k] * xi[-2 * k];
+                    s1 += st->coefs[k + 1] * xi[-2 * k - 2];
+                }
+                y[m++] = s0 + s1;
+            }
+        }
+        else {
+            for (; i < n; ) {
+                y[m++] = dot(st->coefs + p * st->taps, x + i - st->taps + 1, st->taps);
+                p += st->down;
+                i += p / st->up;
+                p %= st->up;
+            }
+        }
+    }
+    st->next = i - n;
+    st->phase = p;
+    st->pos += n;
+
+    return (m);
+}
+
+/*
+ *  ======== SRC_init ========
+ *  Converter from 'inRate' to 'outRate' of 'numChannels' channels, for
+ *  blocks of up to 'maxIn' samples, allocated in 'segid'.  FALSE if the
+ *  ratio needs more than SRC_MAXUP phases.
+ */
+Bool SRC_init(SRC_Obj *src, LgUns inRate, LgUns outRate, Int numChannels, Int maxIn, Int segid)
+{
+    LgUns a = inRate, b = outRate, t;
+    Int up, down, c, s, maxOut;
+
+    if (inRate == 0 || outRate == 0 || numChannels < 1 || numChannels > SRC_MAXCHANNELS || maxIn < 1) {
+        return (FALSE);
+    }
+    while (b != 0) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    up = outRate / a;
+    down = inRate / a;
+    src->inRate = inRate;
+    src->outRate = outRate;
+    src->numChannels = numChannels;
+    src->maxIn = maxIn;
+
+    maxOut = maxIn;
+    if (up == down) {
+        src->numStages = 0;
+    }
+    else if ((up == 2 || up == 4) && down == 1) {
+        src->numStages = up / 2;
+        for (s = 0; s < src->numStages && maxOut > 0; s++) {
+            maxOut = stageInit(&src->stage[s], 2, 1, TRUE, numChannels, maxOut, segid);
+        }
+    }
+    else if (up == 1 && (down == 2 || down == 4)) {
+        src->numStages = down / 2;
+        for (s = 0; s < src->numStages && maxOut > 0; s++) {
+            maxOut = stageInit(&src->stage[s], 1, 2, TRUE, numChannels, maxOut, segid);
+        }
+    }
+    else if (up <= SRC_MAXUP) {
+        src->numStages = 1;
+        maxOut = stageInit(&src->stage[0], up, down, FALSE, numChannels, maxIn, segid);
+    }
+    else {
+        return (FALSE);
+    }
+    if (maxOut < 0) {
+        return (FALSE);
+    }
+    src->maxOut = maxOut;
+
+    if (src->numStages == 2) {
+        for (c = 0; c < numChannels; c++) {
+            src->work[c] = MEM_alloc(segid, src->stage[1].maxIn * sizeof(Float), 8);
+            if (src->work[c] == MEM_ILLEGAL) {
+                return (FALSE);
+            }
+        }
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== SRC_apply ========
+ *  Convert 'n' samples (at most maxIn) of each channel of 'in' into
+ *  'out', returns the number of samples per channel written.
+ */
+Int SRC_apply(SRC_Obj *src, Float *in[], Int n, Float *out[])
+{
+    Int c;
+
+    switch (src->numStages) {
+        case 0:
+            for (c = 0; c < src->numChannels; c++) {
+                memcpy(out[c], in[c], n * sizeof(Float));
+            }
+            return (n);
+        case 1:
+            return (stageRun(&src->stage[0], src->numChannels, in, n, out));
+        default:
+            n = stageRun(&src->stage[0], src->numChannels, in, n, src->work);
+            return (stageRun(&src->stage[1], src->numChannels, src->work, n, out));
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ *  ======== src.h ========
+ *  Sample-rate conversion of planar channels.
+ *
+ *  The effects are written for 44.1 kHz (FE).  A converter placed in
+ *  front of them brings other material to that rate, and one behind
+ *  takes their output back.  Each SRC_apply() call takes a block of up
+ *  to maxIn samples per channel.  It returns the number of output
+ *  samples, which varies from block to block around n * outRate / inRate
+ *  and never exceeds maxOut.
+ *
+ *  The ratio outRate / inRate is reduced to up / down.  A ratio of 2 or
+ *  4, or 1/2 or 1/4, runs through one or two half-band stages.  In a
+ *  half-band filter every other tap is zero and the middle one is 1/2,
+ *  so interpolating by 2 computes only every other output and
+ *  decimating by 2 only every other tap.  Any other ratio (44.1 <-> 48
+ *  kHz is 160/147) runs through a polyphase filter of SRC_TAPS taps per
+ *  phase.  Its up phases are precomputed by SRC_init() from a
+ *  Kaiser-windowed sinc cut off just below the lower Nyquist frequency,
+ *  and each output takes one contiguous dot product.  The input history
+ *  is a sliding window, as in fir.h.
+ *
+ *  The filters are linear phase.  A conversion delays the signal by
+ *  about SRC_TAPS / 2 samples of the lower rate, or SRC_HBTAPS / 2 per
+ *  half-band stage.
+ */
+#ifndef SRC_
+#define SRC_
+
+#include <std.h>
+
+#define SRC_MAXCHANNELS 8
+#define SRC_MAXUP       320             /* 44.1 kHz -> 96 kHz */
+#define SRC_TAPS        64              /* per phase of the polyphase filter */
+#define SRC_HBTAPS      48              /* non-zero taps of a half-band filter, besides the middle one */
+#define SRC_MAXSTAGES   2
+#define SRC_SLACK       4               /* blocks between two copies of the history */
+
+typedef struct SRC_Stage {
+    Int         up;                     /* interpolation factor L */
+    Int         down;                   /* decimation factor M */
+    Bool        halfBand;
+    Int         taps;                   /* per phase, or non-zero taps of the half-band */
+    Int         span;                   /* inputs one output depends on */
+    Float       *coefs;                 /* up phases of taps, reversed */
+    Int         phase;                  /* of the next output, 0..up-1 */
+    Int         next;                   /* newest input of the next output, from the next block */
+    Int         maxIn;
+    Int         length;                 /* samples of each window */
+    Int         pos;                    /* where the next block goes in the windows */
+    Float       *hist[SRC_MAXCHANNELS];
+} SRC_Stage;
+
+typedef struct SRC_Obj {
+    LgUns       inRate;
+    LgUns       outRate;
+    Int         numChannels;
+    Int         maxIn;                  /* samples per channel and call */
+    Int         maxOut;
+    Int         numStages;              /* 0 when the rates are equal */
+    SRC_Stage   stage[SRC_MAXSTAGES];
+    Float       *work[SRC_MAXCHANNELS]; /* output of the first of two stages */
+} SRC_Obj;
+
+extern Bool SRC_init(SRC_Obj *src, LgUns inRate, LgUns outRate, Int numChannels, Int maxIn, Int segid);
+extern Int SRC_apply(SRC_Obj *src, Float *in[], Int n, Float *out[]);
+
+#endif /* SRC_ */
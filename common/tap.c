@@ -0,0 +1,207 @@
+/*
+ *  ======== tap.c ========
+ *  Multi-tap echo on one delay line (see tap.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <math.h>
+#include <string.h>
+
+#include "dly.h"
+#include "tap.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#endif
+
+#ifndef M_PI
+#define M_PI        3.14159265358979323846
+#endif
+
+/*
+ *  ======== lowpass ========
+ *  One-pole low-pass y += coef * (x - y), in place on 'x'.
+ */
+static Void lowpass(Float *restrict x, Float coef, Float *restrict state, Int n)
+{
+    Float y = *state;
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        y += coef * (x[i] - y);
+        x[i] = y;
+    }
+    *state = y;
+}
+
+/*
+ *  ======== accumulate ========
+ *  l[i] += (gl + i * dl) * x[i] and r[i] += (gr + i * dr) * x[i].
+ */
+static Void accumulate(const Float *restrict x, Float gl, Float dl, Float gr, Float dr,
+    Float *restrict l, Float *restrict r, Int n)
+{
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        l[i] += (gl + (Float)i * dl) * x[i];
+        r[i] += (gr + (Float)i * dr) * x[i];
+    }
+}
+
+/*
+ *  ======== scale ========
+ *  l[i] *= g + i * d and r[i] *= g + i * d.
+ */
+static Void scale(Float g, Float d, Float *restrict l, Float *restrict r, Int n)
+{
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        l[i] *= g + (Float)i * d;
+        r[i] *= g + (Float)i * d;
+    }
+}
+
+/*
+ *  ======== TAP_init ========
+ *  Allocate an echo of up to 'maxTaps' taps of up to 'maxDelay' samples,
+ *  its line stored in 'format' (dly.h), in 'segid'.  All the taps are
+ *  in use, silent, and the dry gain is 1.
+ */
+Bool TAP_init(TAP_Obj *tap, Int maxTaps, Int maxDelay, Int format, Int segid)
+{
+    Int t;
+
+    if (maxTaps < 1 || maxTaps > TAP_MAXTAPS || maxDelay < 0 ||
+        !DLY_init(&tap->line, maxDelay + TAP_BLOCK, format, segid)) {
+        return (FALSE);
+    }
+    tap->maxTaps = maxTaps;
+    tap->numTaps = maxTaps;
+    tap->maxDelay = maxDelay;
+
+    tap->delay = MEM_calloc(segid, maxTaps * sizeof(Int), 8);
+    tap->target = MEM_calloc(segid, 2 * maxTaps * sizeof(Float), 8);
+    tap->gain = MEM_calloc(segid, 2 * maxTaps * sizeof(Float), 8);
+    tap->coef = MEM_alloc(segid, maxTaps * sizeof(Float), 8);
+    tap->state = MEM_calloc(segid, maxTaps * sizeof(Float), 8);
+    tap->mono = MEM_alloc(segid, TAP_BLOCK * sizeof(Float), 16);
+    tap->work = MEM_alloc(segid, TAP_BLOCK * sizeof(Float), 16);
+    if (tap->delay == MEM_ILLEGAL || tap->target == MEM_ILLEGAL || tap->gain == MEM_ILLEGAL ||
+        tap->coef == MEM_ILLEGAL || tap->state == MEM_ILLEGAL || tap->mono == MEM_ILLEGAL ||
+        tap->work == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (t = 0; t < maxTaps; t++) {
+        tap->coef[t] = 1.0f;
+    }
+    tap->dry = tap->dryTarget = 1.0f;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== TAP_setTap ========
+ *  Tap 't': 'delay' samples, linear 'gain', 'pan' from -1 (left) to 1
+ *  (right) and a low-pass at 'cutoff' (a fraction of the sampling
+ *  frequency; 0.5 or more for none).
+ */
+Bool TAP_setTap(TAP_Obj *tap, Int t, Int delay, Float gain, Float pan, Double cutoff)
+{
+    Double angle;
+
+    if (t < 0 || t >= tap->maxTaps || delay < 0 || delay > tap->maxDelay || pan < -1.0f || pan > 1.0f ||
+        cutoff <= 0.0) {
+        return (FALSE);
+    }
+    angle = (pan + 1.0) * M_PI / 4.0;
+    tap->delay[t] = delay;
+    tap->target[2 * t] = gain * (Float)cos(angle);
+    tap->target[2 * t + 1] = gain * (Float)sin(angle);
+    tap->coef[t] = cutoff >= 0.5 ? 1.0f : (Float)(1.0 - exp(-2.0 * M_PI * cutoff));
+
+    return (TRUE);
+}
+
+/*
+ *  ======== TAP_setNumTaps ========
+ *  Use taps 0 to 'numTaps' - 1 only.
+ */
+Bool TAP_setNumTaps(TAP_Obj *tap, Int numTaps)
+{
+    if (numTaps < 0 || numTaps > tap->maxTaps) {
+        return (FALSE);
+    }
+    tap->numTaps = numTaps;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== TAP_setDry ========
+ *  Linear gain of the input in the output.
+ */
+Void TAP_setDry(TAP_Obj *tap, Float gain)
+{
+    tap->dryTarget = gain;
+}
+
+/*
+ *  ======== TAP_reset ========
+ *  Clear the line and the filters.
+ */
+Void TAP_reset(TAP_Obj *tap)
+{
+    DLY_reset(&tap->line);
+    memset(tap->state, 0, tap->maxTaps * sizeof(Float));
+}
+
+/*
+ *  ======== TAP_apply ========
+ *  Add the taps to the 'n' samples of the stereo pair ch[0], ch[1], in
+ *  place.
+ */
+Void TAP_apply(TAP_Obj *tap, Float *ch[], Int n)
+{
+    Float target[2 * TAP_MAXTAPS], d[2 * TAP_MAXTAPS], dryDelta, *l, *r;
+    Int pos, m, t, i;
+
+    for (t = 0; t < 2 * tap->maxTaps; t++) {
+        target[t] = t < 2 * tap->numTaps ? tap->target[t] : 0.0f;
+        d[t] = (target[t] - tap->gain[t]) / n;
+    }
+    dryDelta = (tap->dryTarget - tap->dry) / n;
+
+    for (pos = 0; pos < n; pos += m) {
+        m = n - pos < TAP_BLOCK ? n - pos : TAP_BLOCK;
+        l = ch[0] + pos;
+        r = ch[1] + pos;
+        for (i = 0; i < m; i++) {
+            tap->mono[i] = 0.5f * (l[i] + r[i]);
+        }
+        DLY_write(&tap->line, tap->mono, m);
+
+        if (tap->dry != 1.0f || dryDelta != 0.0f) {
+            scale(tap->dry + pos * dryDelta, dryDelta, l, r, m);
+        }
+        for (t = 0; t < tap->maxTaps; t++) {
+            if (tap->gain[2 * t] == 0.0f && tap->gain[2 * t + 1] == 0.0f &&
+                target[2 * t] == 0.0f && target[2 * t + 1] == 0.0f) {
+                continue;
+            }
+            /* the chunk just written is at m: the tap's block is at m + delay */
+            DLY_read(&tap->line, m + tap->delay[t], tap->work, m);
+            if (tap->coef[t] < 1.0f) {
+                lowpass(tap->work, tap->coef[t], &tap->state[t], m);
+            }
+            accumulate(tap->work, tap->gain[2 * t] + pos * d[2 * t], d[2 * t],
+                tap->gain[2 * t + 1] + pos * d[2 * t + 1], d[2 * t + 1], l, r, m);
+        }
+    }
+
+    for (t = 0; t < 2 * tap->maxTaps; t++) {
+        tap->gain[t] = target[t];
+    }
+    tap->dry = tap->dryTarget;
+}
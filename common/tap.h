@@ -0,0 +1,57 @@
+/*
+ *  ======== tap.h ========
+ *  Multi-tap echo: up to TAP_MAXTAPS taps of one delay line, each with
+ *  its delay, gain, pan and low-pass, added to a stereo pair of planar
+ *  channels.
+ *
+ *  The line (dly.h) holds the mono sum of the input, whatever the
+ *  number of taps: its memory depends on the longest delay only.  The
+ *  input is processed in chunks of TAP_BLOCK samples: each chunk is
+ *  written to the line, then each tap's block of the line is read once,
+ *  a copy of at most two contiguous pieces, run through the tap's
+ *  one-pole low-pass if it has one, and added to both channels with its
+ *  left and right gains in one multiply-add loop, which the compilers
+ *  vectorise.  The cost per sample is then in proportion to the number
+ *  of taps, and does not depend on the delays or on the length of the
+ *  line.
+ *
+ *  The gains pan at constant power.  TAP_setTap() sets a tap between
+ *  two blocks: its delay and filter apply from the next block, and its
+ *  gains move there linearly over the next TAP_apply(), as do the dry
+ *  gain of TAP_setDry() and the gains of taps that TAP_setNumTaps()
+ *  turns off or on.  A delay is a whole number of samples, 0 to the
+ *  maximum given to TAP_init().
+ */
+#ifndef TAP_
+#define TAP_
+
+#include <std.h>
+
+#include "dly.h"
+
+#define TAP_MAXTAPS     32
+#define TAP_BLOCK       128     /* samples per chunk */
+
+typedef struct TAP_Obj {
+    Int         maxTaps;
+    Int         numTaps;                /* in use */
+    Int         maxDelay;
+    DLY_Obj     line;
+    Int         *delay;                 /* of each tap, samples */
+    Float       *target;                /* left, right gains of each tap at the end of the next block */
+    Float       *gain;                  /* left, right gains of each tap */
+    Float       *coef;                  /* of each tap's low-pass, 1 without */
+    Float       *state;                 /* of each tap's low-pass */
+    Float       dry, dryTarget;
+    Float       *mono;                  /* one chunk of the line's input */
+    Float       *work;                  /* one chunk of one tap */
+} TAP_Obj;
+
+extern Bool TAP_init(TAP_Obj *tap, Int maxTaps, Int maxDelay, Int format, Int segid);
+extern Bool TAP_setTap(TAP_Obj *tap, Int t, Int delay, Float gain, Float pan, Double cutoff);
+extern Bool TAP_setNumTaps(TAP_Obj *tap, Int numTaps);
+extern Void TAP_setDry(TAP_Obj *tap, Float gain);
+extern Void TAP_apply(TAP_Obj *tap, Float *ch[], Int n);
+extern Void TAP_reset(TAP_Obj *tap);
+
+#endif /* TAP_ */
@@ -0,0 +1,419 @@
+/*
+ *  ======== xov.c ========
+ *  Parallel Linkwitz-Riley filter bank on planar channels (see xov.h).
+ */
+#include <std.h>
+#include <mem.h>
+#include <string.h>
+
+#include "biq.h"
+#include "xov.h"
+
+#ifndef _TMS320C6X
+#define restrict    __restrict
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
+
+#define L           XOV_LANES
+#define BUTTERWORTH 0.70710678118654752     /* q of the sections of a Linkwitz-Riley filter */
+
+#define COEFS(xov, g, s)        (&(xov)->coefs[((g) * (xov)->maxSections + (s)) * 5 * L])
+#define STATE(xov, c, g, s)     (&(xov)->state[c][((g) * (xov)->maxSections + (s)) * 2 * L])
+
+/*
+ *  ======== setLane ========
+ *  Coefficients of lane 'l' of section 's' of chain 'g'.
+ */
+static Void setLane(XOV_Obj *xov, Int g, Int s, Int l, const BIQ_Coefs *k)
+{
+    Float *c = COEFS(xov, g, s);
+
+    c[l] = k->b0;
+    c[L + l] = k->b1;
+    c[2 * L + l] = k->b2;
+    c[3 * L + l] = k->a1;
+    c[4 * L + l] = k->a2;
+}
+
+/*
+ *  ======== XOV_init ========
+ *  Allocate a bank of up to 'maxBands' bands on 'numChannels' channels
+ *  in 'segid'.  It starts with one band at a gain of 1: it passes its
+ *  input through until XOV_setBands().
+ */
+Bool XOV_init(XOV_Obj *xov, Int maxBands, Int numChannels, Int segid)
+{
+    Int numGroups = (maxBands + L - 1) / L, c;
+
+    if (maxBands < 1 || maxBands > XOV_MAXBANDS || numChannels < 1 || numChannels > XOV_MAXCHANNELS) {
+        return (FALSE);
+    }
+    xov->maxBands = maxBands;
+    xov->numChannels = numChannels;
+    xov->maxSections = maxBands > 1 ? 2 * (maxBands - 1) : 1;
+
+    xov->coefs = MEM_alloc(segid, numGroups * xov->maxSections * 5 * L * sizeof(Float), 16);
+    xov->gain = MEM_alloc(segid, numGroups * L * sizeof(Float), 16);
+    xov->target = MEM_alloc(segid, maxBands * sizeof(Float), 8);
+    xov->work = MEM_alloc(segid, 2 * XOV_BLOCK * L * sizeof(Float), 16);
+    xov->sum = MEM_alloc(segid, 2 * XOV_BLOCK * sizeof(Float), 16);
+    if (xov->coefs == MEM_ILLEGAL || xov->gain == MEM_ILLEGAL || xov->target == MEM_ILLEGAL ||
+        xov->work == MEM_ILLEGAL || xov->sum == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (c = 0; c < numChannels; c++) {
+        xov->state[c] = MEM_alloc(segid, numGroups * xov->maxSections * 2 * L * sizeof(Float), 16);
+        if (xov->state[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+    for (c = 0; c < maxBands; c++) {
+        xov->target[c] = 1.0f;
+    }
+    XOV_setBands(xov, 1, NULL);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== XOV_setBands ========
+ *  Split into 'numBands' bands at the crossover frequencies 'freq'
+ *  (numBands - 1 of them, increasing, in fractions of the sampling
+ *  frequency).  The bands start at the gains last set, from a
+ *  cleared state.
+ */
+Bool XOV_setBands(XOV_Obj *xov, Int numBands, const Double freq[])
+{
+    static const BIQ_Coefs through = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    BIQ_Coefs lp, hp, ap;
+    Int b, g, j, l, s;
+
+    if (numBands < 1 || numBands > xov->maxBands) {
+        return (FALSE);
+    }
+    for (j = 1; j < numBands - 1; j++) {
+        if (freq[j] <= freq[j - 1]) {
+            return (FALSE);
+        }
+    }
+    for (j = 0; j < numBands - 1; j++) {
+        if (freq[j] <= 0.0 || freq[j] >= 0.5) {
+            return (FALSE);
+        }
+    }
+    xov->numBands = numBands;
+
+    for (g = 0; g * L < numBands; g++) {
+        xov->numSections[g] = 0;
+        for (s = 0; s < xov->maxSections; s++) {
+            for (l = 0; l < L; l++) {
+                setLane(xov, g, s, l, &through);
+            }
+        }
+    }
+    for (b = 0; b < numBands; b++) {
+        g = b / L;
+        l = b % L;
+        s = 0;
+        for (j = 0; j < numBands - 1; j++) {
+            BIQ_design(&lp, BIQ_LOWPASS, freq[j], 0.0, BUTTERWORTH);
+            BIQ_design(&hp, BIQ_HIGHPASS, freq[j], 0.0, BUTTERWORTH);
+            BIQ_design(&ap, BIQ_ALLPASS, freq[j], 0.0, BUTTERWORTH);
+            if (j < b) {
+                setLane(xov, g, s++, l, &hp);
+                setLane(xov, g, s++, l, &hp);
+            }
+            else if (j == b) {
+                setLane(xov, g, s++, l, &lp);
+                setLane(xov, g, s++, l, &lp);
+            }
+            else {
+                setLane(xov, g, s++, l, &ap);
+            }
+        }
+        if (s > xov->numSections[g]) {
+            xov->numSections[g] = s;
+        }
+    }
+    for (b = 0; b < (numBands + L - 1) / L * L; b++) {
+        xov->gain[b] = b < numBands ? xov->target[b] : 0.0f;
+    }
+    XOV_reset(xov);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== XOV_setGain ========
+ *  Linear gain of 'band', reached at the end of the next block.
+ */
+Bool XOV_setGain(XOV_Obj *xov, Int band, Float gain)
+{
+    if (band < 0 || band >= xov->maxBands) {
+        return (FALSE);
+    }
+    xov->target[band] = gain;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== XOV_reset ========
+ *  Clear the state of every band and channel.
+ */
+Void XOV_reset(XOV_Obj *xov)
+{
+    Int c;
+
+    for (c = 0; c < xov->numChannels; c++) {
+        memset(xov->state[c], 0, (xov->maxBands + L - 1) / L * xov->maxSections * 2 * L * sizeof(Float));
+    }
+}
+
+/*
+ *  ======== spread ========
+ *  Each of the 'm' samples of 'x' into the L lanes of 'w'.
+ */
+static Void spread(const Float *restrict x, Float *restrict w, Int m)
+{
+    Int i, l;
+
+    for (i = 0; i < m; i++) {
+        for (l = 0; l < L; l++) {
+            w[i * L + l] = x[i];
+        }
+    }
+}
+
+#ifdef __SSE2__
+/*
+ *  ======== section2 ========
+ *  One section of the L lanes of 'wa' and 'wb' in place, one step of
+ *  the recursion of a lane per operation.
+ */
+static Void section2(const Float *restrict k, Float *restrict sa, Float *restrict sb, Float *restrict wa,
+    Float *restrict wb, Int m)
+{
+    __m128 b0 = _mm_load_ps(k), b1 = _mm_load_ps(k + L), b2 = _mm_load_ps(k + 2 * L);
+    __m128 a1 = _mm_load_ps(k + 3 * L), a2 = _mm_load_ps(k + 4 * L);
+    __m128 a_1 = _mm_load_ps(sa), a_2 = _mm_load_ps(sa + L);
+    __m128 b_1 = _mm_load_ps(sb), b_2 = _mm_load_ps(sb + L);
+    __m128 x, y;
+    Int i;
+
+    for (i = 0; i < m; i++) {
+        x = _mm_load_ps(wa + i * L);
+        y = _mm_add_ps(_mm_mul_ps(b0, x), a_1);
+        a_1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), a_2);
+        a_2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_store_ps(wa + i * L, y);
+
+        x = _mm_load_ps(wb + i * L);
+        y = _mm_add_ps(_mm_mul_ps(b0, x), b_1);
+        b_1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), b_2);
+        b_2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_store_ps(wb + i * L, y);
+    }
+    _mm_store_ps(sa, a_1);
+    _mm_store_ps(sa + L, a_2);
+    _mm_store_ps(sb, b_1);
+    _mm_store_ps(sb + L, b_2);
+}
+
+/*
+ *  ======== section1 ========
+ *  section2() on one channel.
+ */
+static Void section1(const Float *restrict k, Float *restrict st, Float *restrict w, Int m)
+{
+    __m128 b0 = _mm_load_ps(k), b1 = _mm_load_ps(k + L), b2 = _mm_load_ps(k + 2 * L);
+    __m128 a1 = _mm_load_ps(k + 3 * L), a2 = _mm_load_ps(k + 4 * L);
+    __m128 s1 = _mm_load_ps(st), s2 = _mm_load_ps(st + L);
+    __m128 x, y;
+    Int i;
+
+    for (i = 0; i < m; i++) {
+        x = _mm_load_ps(w + i * L);
+        y = _mm_add_ps(_mm_mul_ps(b0, x), s1);
+        s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), s2);
+        s2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+        _mm_store_ps(w + i * L, y);
+    }
+    _mm_store_ps(st, s1);
+    _mm_store_ps(st + L, s2);
+}
+
+/*
+ *  ======== mix ========
+ *  Add the L lanes of each of the 'm' samples of 'w' into 'sum', with
+ *  gains moving from 'g0' by 'd' per sample.
+ */
+static Void mix(const Float *restrict w, Float *restrict sum, const Float *g0, const Float *d, Int m)
+{
+    __m128 g = _mm_loadu_ps(g0), dg = _mm_loadu_ps(d), v;
+    Int i;
+
+    for (i = 0; i < m; i++) {
+        g = _mm_add_ps(g, dg);
+        v = _mm_mul_ps(g, _mm_load_ps(w + i * L));
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+        sum[i] += _mm_cvtss_f32(v);
+    }
+}
+#else
+/*
+ *  ======== section2 ========
+ *  One section of the L lanes of 'wa' and 'wb' in place: 2 L
+ *  independent recursions in one loop.
+ */
+static Void section2(const Float *restrict k, Float *restrict sa, Float *restrict sb, Float *restrict wa,
+    Float *restrict wb, Int m)
+{
+    Float a_1[L], a_2[L], b_1[L], b_2[L];
+    Float x, y;
+    Int i, l;
+
+    for (l = 0; l < L; l++) {
+        a_1[l] = sa[l];
+        a_2[l] = sa[L + l];
+        b_1[l] = sb[l];
+        b_2[l] = sb[L + l];
+    }
+    for (i = 0; i < m; i++) {
+        for (l = 0; l < L; l++) {
+            x = wa[i * L + l];
+            y = k[l] * x + a_1[l];
+            a_1[l] = k[L + l] * x - k[3 * L + l] * y + a_2[l];
+            a_2[l] = k[2 * L + l] * x - k[4 * L + l] * y;
+            wa[i * L + l] = y;
+
+            x = wb[i * L + l];
+            y = k[l] * x + b_1[l];
+            b_1[l] = k[L + l] * x - k[3 * L + l] * y + b_2[l];
+            b_2[l] = k[2 * L + l] * x - k[4 * L + l] * y;
+            wb[i * L + l] = y;
+        }
+    }
+    for (l = 0; l < L; l++) {
+        sa[l] = a_1[l];
+        sa[L + l] = a_2[l];
+        sb[l] = b_1[l];
+        sb[L + l] = b_2[l];
+    }
+}
+
+/*
+ *  ======== section1 ========
+ *  section2() on one channel.
+ */
+static Void section1(const Float *restrict k, Float *restrict st, Float *restrict w, Int m)
+{
+    Float s1[L], s2[L];
+    Float x, y;
+    Int i, l;
+
+    for (l = 0; l < L; l++) {
+        s1[l] = st[l];
+        s2[l] = st[L + l];
+    }
+    for (i = 0; i < m; i++) {
+        for (l = 0; l < L; l++) {
+            x = w[i * L + l];
+            y = k[l] * x + s1[l];
+            s1[l] = k[L + l] * x - k[3 * L + l] * y + s2[l];
+            s2[l] = k[2 * L + l] * x - k[4 * L + l] * y;
+            w[i * L + l] = y;
+        }
+    }
+    for (l = 0; l < L; l++) {
+        st[l] = s1[l];
+        st[L + l] = s2[l];
+    }
+}
+
+/*
+ *  ======== mix ========
+ *  Add the L lanes of each of the 'm' samples of 'w' into 'sum', with
+ *  gains moving from 'g0' by 'd' per sample.
+ */
+static Void mix(const Float *restrict w, Float *restrict sum, const Float *g0, const Float *d, Int m)
+{
+    Float g[L], acc;
+    Int i, l;
+
+    for (l = 0; l < L; l++) {
+        g[l] = g0[l];
+    }
+    for (i = 0; i < m; i++) {
+        acc = 0.0f;
+        for (l = 0; l < L; l++) {
+            g[l] += d[l];
+            acc += g[l] * w[i * L + l];
+        }
+        sum[i] += acc;
+    }
+}
+#endif
+
+/*
+ *  ======== XOV_apply ========
+ *  Filter 'n' samples of each channel of 'ch' in place.  The gains move
+ *  to those last set over these samples.
+ */
+Void XOV_apply(XOV_Obj *xov, Float *ch[], Int n)
+{
+    Float target[XOV_MAXBANDS + L], d[XOV_MAXBANDS + L], g0[L];
+    Float *wa = xov->work, *wb = xov->work + XOV_BLOCK * L;
+    Float *suma = xov->sum, *sumb = xov->sum + XOV_BLOCK;
+    Int numGroups = (xov->numBands + L - 1) / L, b, c, g, l, m, pos, s;
+    Bool two;
+
+    if (n < 1) {
+        return;
+    }
+    for (b = 0; b < numGroups * L; b++) {
+        target[b] = b < xov->numBands ? xov->target[b] : 0.0f;
+        d[b] = (target[b] - xov->gain[b]) / n;
+    }
+
+    for (c = 0; c < xov->numChannels; c += 2) {
+        two = c + 1 < xov->numChannels;
+        for (pos = 0; pos < n; pos += m) {
+            m = n - pos < XOV_BLOCK ? n - pos : XOV_BLOCK;
+            memset(suma, 0, m * sizeof(Float));
+            memset(sumb, 0, m * sizeof(Float));
+            for (g = 0; g < numGroups; g++) {
+                spread(ch[c] + pos, wa, m);
+                if (two) {
+                    spread(ch[c + 1] + pos, wb, m);
+                }
+                for (s = 0; s < xov->numSections[g]; s++) {
+                    if (two) {
+                        section2(COEFS(xov, g, s), STATE(xov, c, g, s), STATE(xov, c + 1, g, s), wa, wb, m);
+                    }
+                    else {
+                        section1(COEFS(xov, g, s), STATE(xov, c, g, s), wa, m);
+                    }
+                }
+                for (l = 0; l < L; l++) {
+                    g0[l] = xov->gain[g * L + l] + pos * d[g * L + l];
+                }
+                mix(wa, suma, g0, &d[g * L], m);
+                if (two) {
+                    mix(wb, sumb, g0, &d[g * L], m);
+                }
+            }
+            memcpy(ch[c] + pos, suma, m * sizeof(Float));
+            if (two) {
+                memcpy(ch[c + 1] + pos, sumb, m * sizeof(Float));
+            }
+        }
+    }
+
+    for (b = 0; b < numGroups * L; b++) {
+        xov->gain[b] = target[b];
+    }
+}
@@ -0,0 +1,68 @@
+/*
+ *  ======== xov.h ========
+ *  Parallel filter bank: Linkwitz-Riley crossovers split planar
+ *  channels into bands, each with a gain, summed back.
+ *
+ *  A cascade of equaliser sections (biq.h) is one recursion after
+ *  another: each section waits for the output of the previous one.
+ *  Here every band is its own chain of sections fed by the same input,
+ *  so the bands are independent and run side by side.  With crossover
+ *  frequencies f0 < f1 < ... (N - 1 of them for N bands), band k is
+ *
+ *      HP(f0)^2 ... HP(fk-1)^2  LP(fk)^2  AP(fk+1) ... AP(fN-2)
+ *
+ *  where LP^2 and HP^2 are fourth-order Linkwitz-Riley low and high
+ *  passes (two Butterworth sections each) and AP the second-order
+ *  all-pass LP^2 + HP^2 at the same frequency.  It is the tree of
+ *  two-way crossovers unfolded, each band compensated for the phase of
+ *  the crossovers it does not go through, so that with all the gains at
+ *  1 the sum of the bands is an all-pass: a flat magnitude response.
+ *
+ *  The bands go XOV_LANES at a time into the lanes of one chain of
+ *  sections, padded with pass-through sections to the longest band of
+ *  the group: band k has N + k sections (2 (N - 1) for the last one).
+ *  Each step of the recursion then advances XOV_LANES bands at once:
+ *  one SSE instruction per operation on the host, independent
+ *  recursions the C6x compiler overlaps in its software pipeline.  As
+ *  in biq.h, two channels run in the same loop and the block is
+ *  processed section after section, in chunks of XOV_BLOCK samples
+ *  whose working buffers fit in internal memory.  Channels are
+ *  independent too: on a host, several objects over disjoint channels
+ *  can run in threads of their own (bench -e).
+ *
+ *  XOV_setGain() only writes the gain the band moves to, linearly over
+ *  the next XOV_apply(): it may be called from any thread.
+ *  XOV_setBands() changes the sections and clears the state, between
+ *  two blocks, from the thread that calls XOV_apply().
+ */
+#ifndef XOV_
+#define XOV_
+
+#include <std.h>
+
+#define XOV_MAXBANDS    8
+#define XOV_MAXCHANNELS 8
+#define XOV_LANES       4       /* bands per chain of sections */
+#define XOV_BLOCK       64      /* samples per chunk */
+
+typedef struct XOV_Obj {
+    Int         maxBands;
+    Int         numBands;               /* in use */
+    Int         numChannels;
+    Int         maxSections;            /* per chain */
+    Int         numSections[(XOV_MAXBANDS + XOV_LANES - 1) / XOV_LANES];
+    Float       *coefs;                 /* b0, b1, b2, a1, a2 of each lane, per chain and section */
+    Float       *gain;                  /* of each lane, per chain */
+    volatile Float *target;             /* gain of each band at the end of the next block */
+    Float       *state[XOV_MAXCHANNELS]; /* s1, s2 of each lane, per chain and section */
+    Float       *work;                  /* the lanes of one chunk of two channels */
+    Float       *sum;                   /* the sum of their bands */
+} XOV_Obj;
+
+extern Bool XOV_init(XOV_Obj *xov, Int maxBands, Int numChannels, Int segid);
+extern Bool XOV_setBands(XOV_Obj *xov, Int numBands, const Double freq[]);
+extern Bool XOV_setGain(XOV_Obj *xov, Int band, Float gain);
+extern Void XOV_apply(XOV_Obj *xov, Float *ch[], Int n);
+extern Void XOV_reset(XOV_Obj *xov);
+
+#endif /* XOV_ */
@@ -0,0 +1,1484 @@
+/*
+ *  ======== bench_main.c ========
+ *  Times echo() of one exercise on fixed test signals, for PIP frames of
+ *  32 to 1024 samples (interleaved 16-bit stereo, the unit of
+ *  BLK_config.size), and reports the share of the real-time deadline it
+ *  uses.
+ *
+ *  This program plays the part of the codec itself: for every block it
+ *  completes one playback and one capture frame, which posts swiEcho,
+ *  and only SWI_run() is timed.  Cycles are CLK_gethtime() counts, i.e.
+ *  time-stamp counter ticks on x86 hosts.
+ *
+ *  With -x it times the convolution engine (cnv.h) instead, direct and
+ *  by FFT, for each block size and tap count, and reports from how many
+ *  taps the FFT is faster next to the crossover of its cost model.
+ *
+ *  With -k it times Exercice2's three stereo sections in their fused
+ *  kernel (biq.h) against section by section, for each block size, and
+ *  Exercice1's low-pass designs from its table (fir.h) against
+ *  FIR_design(), for some of its lengths, and reports the largest
+ *  difference between the two.
+ *
+ *  With -c it times the 16-bit/float conversions of pln.h against the
+ *  per-sample loops the exercises used before, in cycles per sample.
+ *
+ *  With -r it times the sample-rate converters (src.h) to and from 44.1
+ *  kHz on stereo blocks of a default PIP frame, and reports the share of
+ *  real time they use.
+ *
+ *  With -e it times the Linkwitz-Riley filter banks of xov.h on
+ *  MIXCHANNELS channels, band after band with biq.h and then with the
+ *  bands in SIMD lanes, on 1 to 'threads' threads (-j, the number of
+ *  cores by default) that share out groups of XOV_MAXCHANNELS channels.
+ *
+ *  With -q it times the graphic equalisers of geq.h, 10 and 31 bands
+ *  with their sections in SIMD lanes, against the same sections in a
+ *  biq.h cascade, on stereo blocks of a default PIP frame.
+ *
+ *  With -i it times biquad sections run by blocks (BIQ_setBlocked())
+ *  against sample by sample, on one channel in blocks of BLK_MAXSIZE
+ *  samples, and reports the largest difference between the two.
+ *
+ *  With -d it runs a feedback comb like Exercice3's on a delay line
+ *  (dly.h) stored in each format, and reports the cycles per sample,
+ *  the bytes of the line and the error of the output against floats,
+ *  on noise and on a quiet sine.
+ *
+ *  With -t it times the multi-tap echo of tap.h with 8 to 32 taps on
+ *  lines of 1 and 10 seconds, on stereo blocks of a default PIP frame,
+ *  and reports the largest difference from the taps summed sample by
+ *  sample.
+ *
+ *  With -f it times the reverbs of fdn.h, 4 to 16 lines mixed by each
+ *  matrix, on stereo blocks of a default PIP frame, and reports the
+ *  reverb time measured on their impulse response.
+ *
+ *  With -l it runs a two-minute delay line spilled to a file (spl.h),
+ *  taps at half and all of its length, paced at 20 times real time for
+ *  its length and 'seconds' more, and reports the time per block of the
+ *  audio path, its page faults on the disk and the bytes of the line in
+ *  RAM, and checks that the taps read back what was written.
+ *
+ *  usage: benchN [-s seconds] [-x] [-k] [-c] [-r] [-e] [-j threads] [-q] [-i] [-d] [-t] [-f] [-l]
+ *                [-g symbol=value]...
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include <std.h>
+#include <clk.h>
+#include <log.h>
+#include <swi.h>
+#include <pip.h>
+#include <pio.h>
+
+#include "bios_host.h"
+#include "spl.h"
+#include "biq.h"
+#include "blk.h"
+#include "cnv.h"
+#include "dly.h"
+#include "fdn.h"
+#include "fir.h"
+#include "geq.h"
+#include "pln.h"
+#include "src.h"
+#include "tap.h"
+#include "xov.h"
+
+#define FE          44100
+#define MAXBLOCK    BLK_MAXSIZE
+#define NUMREPEAT   3
+#define MAXSLIDERS  16
+#define MIXCHANNELS 32              /* channels of the filter bank benchmark */
+#define MAXTHREADS  64
+#define COMBDELAY   8820            /* samples of the comb of "bench -d", 0.1 s of interleaved stereo */
+
+extern PIO_Obj pioRx, pioTx;
+
+static const Int blockSizes[] = { 32, 64, 128, 256, 512, 1024 };
+static const char *signalNames[] = { "noise", "sine", "impulse", "denormal" };
+static const Int tapCounts[] = { 16, 32, 64, 128, 256, 512, 1024 };
+static const LgUns rates[] = { 48000, 96000, 88200, 176400 };
+
+#define NUMBLOCKSIZES   (sizeof(blockSizes) / sizeof(blockSizes[0]))
+#define NUMSIGNALS      (sizeof(signalNames) / sizeof(signalNames[0]))
+#define SIG_DENORMAL    3           /* not in the worst case: denormals are flushed on the target */
+#define NUMTAPCOUNTS    (sizeof(tapCounts) / sizeof(tapCounts[0]))
+#define NUMRATES        (sizeof(rates) / sizeof(rates[0]))
+
+static char *sliders[MAXSLIDERS];
+static Int nsliders = 0;
+
+/*
+ *  ======== makeSignal ========
+ *  0: white noise at -6 dBFS, 1: 1 kHz sine at -6 dBFS, 2: a single
+ *  click followed by silence, which lets the recursive filters decay
+ *  into denormals, 3: the same click, run without flushing denormals
+ *  to zero (run()) to show what BIOS_init() saves.
+ */
+static Void makeSignal(Int type, Short *buf, LgUns n)
+{
+    unsigned seed = 12345;
+    LgUns i;
+
+    for (i = 0; i < n; i += 2) {
+        switch (type) {
+            case 0:
+                seed = seed * 1664525 + 1013904223;
+                buf[i] = (Short)((Int)(seed >> 16) - 32768) / 2;
+                seed = seed * 1664525 + 1013904223;
+                buf[i + 1] = (Short)((Int)(seed >> 16) - 32768) / 2;
+                break;
+            case 1:
+                buf[i] = buf[i + 1] = (Short)(16384.0 * sin(2.0 * M_PI * 1000.0 * (i / 2) / FE));
+                break;
+            default:
+                buf[i] = buf[i + 1] = i == 0 ? 16384 : 0;
+                break;
+        }
+    }
+}
+
+/*
+ *  ======== run ========
+ *  Process 'n' samples of 'sig' with PIP frames of 'size' samples, with
+ *  denormals or without, and return the CLK_gethtime() counts spent in
+ *  SWI_run().
+ */
+static LgUns run(Int size, const Short *sig, LgUns n, Bool denormals)
+{
+    LgUns pos, t0, total = 0;
+    Ptr frame;
+    Int i;
+
+    BLK_config.size = size;
+    BIOS_init();
+    BIOS_flushDenormals(!denormals);
+    host_appMain();
+    for (i = 0; i < nsliders; i++) {
+        GEL_set(sliders[i]);
+    }
+    swiEcho.runs = 0;
+
+    for (pos = 0; pos + size <= n; pos += size) {
+        if (PIO_devTake(&pioTx) != NULL) {
+            PIO_devDone(&pioTx);
+        }
+        if ((frame = PIO_devTake(&pioRx)) != NULL) {
+            memcpy(frame, sig + pos, size * sizeof(Short));
+            PIO_devDone(&pioRx);
+        }
+        t0 = CLK_gethtime();
+        SWI_run();
+        total += CLK_gethtime() - t0;
+    }
+    if (swiEcho.runs != n / size) {
+        fprintf(stderr, "warning: echo() ran %lu times for %lu frames\n", swiEcho.runs, n / size);
+    }
+
+    return (total);
+}
+
+/*
+ *  ======== convolve ========
+ *  Best of NUMREPEAT of the cycles per sample of 'cnv' in 'mode' on 'n'
+ *  samples per channel of the planar noise 'ch' (-1 if 'mode' cannot
+ *  filter with 'taps' taps).
+ */
+static Double convolve(CNV_Obj *cnv, Int mode, Int taps, Float *ch[], LgUns n)
+{
+    static Float h[FIR_MAXTAPS];
+    Float *blk[2];
+    LgUns pos, t0, t, best = ~0UL;
+    Int i, r;
+
+    for (i = 0; i < taps; i++) {
+        h[i] = 1.0f / (i + 1);
+    }
+    if (!CNV_setCoefs(cnv, h, taps, mode)) {
+        return (-1.0);
+    }
+    for (r = 0; r < NUMREPEAT; r++) {
+        t0 = CLK_gethtime();
+        for (pos = 0; pos + cnv->block <= n; pos += cnv->block) {
+            blk[0] = ch[0] + pos;
+            blk[1] = ch[1] + pos;
+            CNV_apply(cnv, blk, cnv->block);
+        }
+        if ((t = CLK_gethtime() - t0) < best) {
+            best = t;
+        }
+    }
+
+    return ((Double)best / (2 * (n / cnv->block * cnv->block)));
+}
+
+/*
+ *  ======== crossover ========
+ *  Cycles per sample of direct and FFT convolution for each block size
+ *  and tap count.
+ */
+static Int crossover(const char *prog, Double seconds)
+{
+    LgUns n = (LgUns)(seconds * FE), i;
+    Float *ch[2], *copy[2];
+    Double direct[NUMTAPCOUNTS], fft;
+    CNV_Obj cnv;
+    Int measured;
+    Uns b, t;
+
+    for (i = 0; i < 2; i++) {
+        ch[i] = malloc(n * sizeof(Float));
+        copy[i] = malloc(n * sizeof(Float));
+        if (ch[i] == NULL || copy[i] == NULL) {
+            return (1);
+        }
+    }
+    for (i = 0; i < n; i++) {
+        ch[0][i] = (Float)rand() / RAND_MAX - 0.5f;
+        ch[1][i] = (Float)rand() / RAND_MAX - 0.5f;
+    }
+
+    printf("%s: direct and FFT convolution on %.1f s of stereo audio, cycles/sample, best of %d\n",
+        prog, seconds, NUMREPEAT);
+    printf("%6s %-6s", "block", "mode");
+    for (t = 0; t < NUMTAPCOUNTS; t++) {
+        printf(" %7d", tapCounts[t]);
+    }
+    printf("   %s\n", "FFT faster from");
+    for (b = 0; b < NUMBLOCKSIZES; b++) {
+        if (!CNV_init(&cnv, FIR_MAXTAPS, 2, blockSizes[b] / 2, 0)) {
+            return (1);
+        }
+        measured = -1;
+        printf("%6d %-6s", blockSizes[b], "direct");
+        for (t = 0; t < NUMTAPCOUNTS; t++) {
+            memcpy(copy[0], ch[0], n * sizeof(Float));
+            memcpy(copy[1], ch[1], n * sizeof(Float));
+            direct[t] = convolve(&cnv, CNV_DIRECT, tapCounts[t], copy, n);
+            printf(" %7.1f", direct[t]);
+        }
+        printf("\n%6s %-6s", "", "fft");
+        for (t = 0; t < NUMTAPCOUNTS; t++) {
+            memcpy(copy[0], ch[0], n * sizeof(Float));
+            memcpy(copy[1], ch[1], n * sizeof(Float));
+            fft = convolve(&cnv, CNV_FFT, tapCounts[t], copy, n);
+            if (measured < 0 && fft < direct[t]) {
+                measured = tapCounts[t];
+            }
+            printf(" %7.1f", fft);
+        }
+        if (measured < 0) {
+            printf("   > %d taps", tapCounts[NUMTAPCOUNTS - 1]);
+        }
+        else {
+            printf("   %d taps", measured);
+        }
+        printf(" (model: %d)\n", cnv.crossover);
+        CNV_delete(&cnv, 0);
+    }
+
+    for (i = 0; i < 2; i++) {
+        free(ch[i]);
+        free(copy[i]);
+    }
+    return (0);
+}
+
+/*
+ *  ======== cascade ========
+ *  Cycles per sample of Exercice2's three sections (shelves at 400 and
+ *  2500 Hz, peak at 1 kHz) on two channels in the fused kernel
+ *  BIQ_setNumSections() picks and section by section, for each block
+ *  size, and the largest difference between the two outputs.
+ */
+static Int cascade(const char *prog, Double seconds)
+{
+    LgUns n = (LgUns)(seconds * FE) / MAXBLOCK * MAXBLOCK, pos, t0, t, best[2];
+    Float *ch[2], *out[2][2], *blk[2], d, err;
+    Int block, k, r;
+    BIQ_Coefs coefs;
+    BIQ_Obj biq;
+    Uns b;
+
+    for (k = 0; k < 2; k++) {
+        ch[k] = malloc(n * sizeof(Float));
+        out[k][0] = malloc(n * sizeof(Float));
+        out[k][1] = malloc(n * sizeof(Float));
+        if (ch[k] == NULL || out[k][0] == NULL || out[k][1] == NULL) {
+            return (1);
+        }
+    }
+    for (pos = 0; pos < n; pos++) {
+        ch[0][pos] = (Float)rand() / RAND_MAX - 0.5f;
+        ch[1][pos] = (Float)rand() / RAND_MAX - 0.5f;
+    }
+    if (!BIQ_init(&biq, 3, 2, 0)) {
+        return (1);
+    }
+    BIQ_design(&coefs, BIQ_LOWSHELF, 400.0 / FE, 8.0, M_SQRT1_2);
+    BIQ_setCoefs(&biq, 0, &coefs);
+    BIQ_design(&coefs, BIQ_HIGHSHELF, 2500.0 / FE, 3.0, M_SQRT1_2);
+    BIQ_setCoefs(&biq, 1, &coefs);
+    BIQ_design(&coefs, BIQ_PEAK, 1000.0 / FE, 7.0, 1.0);
+    BIQ_setCoefs(&biq, 2, &coefs);
+
+    printf("%s: 3 biquad sections on %.1f s of stereo audio, cycles/sample, best of %d\n", prog, seconds,
+        NUMREPEAT);
+    printf("%6s %12s %10s %9s %12s\n", "block", "fused", "sections", "speed-up", "difference");
+    for (b = 0; b < NUMBLOCKSIZES; b++) {
+        block = blockSizes[b] / 2;
+        for (k = 0; k < 2; k++) {
+            BIQ_setNumSections(&biq, 3);
+            if (k == 1) {
+                biq.cascade = NULL;
+            }
+            for (best[k] = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                memcpy(out[0][k], ch[0], n * sizeof(Float));
+                memcpy(out[1][k], ch[1], n * sizeof(Float));
+                BIQ_reset(&biq);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos + block <= n; pos += block) {
+                    blk[0] = out[0][k] + pos;
+                    blk[1] = out[1][k] + pos;
+                    BIQ_apply(&biq, blk, block);
+                }
+                if ((t = CLK_gethtime() - t0) < best[k]) {
+                    best[k] = t;
+                }
+            }
+        }
+        for (err = 0.0f, pos = 0; pos < n; pos++) {
+            if ((d = fabsf(out[0][0][pos] - out[0][1][pos])) > err) {
+                err = d;
+            }
+            if ((d = fabsf(out[1][0][pos] - out[1][1][pos])) > err) {
+                err = d;
+            }
+        }
+        printf("%6d %12.2f %10.2f %8.2fx %12g\n", blockSizes[b], (Double)best[0] / (2 * n),
+            (Double)best[1] / (2 * n), (Double)best[1] / best[0], err);
+    }
+
+    for (k = 0; k < 2; k++) {
+        free(ch[k]);
+        free(out[k][0]);
+        free(out[k][1]);
+    }
+    return (0);
+}
+
+/*
+ *  ======== designs ========
+ *  Microseconds per low-pass of Exercice1's sliders (64 * n - 1 taps, 1
+ *  to 20 kHz) made by FIR_design() and by FIR_designFrom() from the
+ *  table of its main(), for some of its lengths, and the largest
+ *  difference between the two sets of coefficients.
+ */
+static Int designs(const char *prog)
+{
+    static Float h[2][FIR_MAXTAPS];
+    Int lengths[16], l, c, k, r, i;
+    Float cutoffs[20], d, err;
+    LgUns t0, t, best[2];
+    FIR_Table tab;
+
+    for (l = 0; l < 16; l++) {
+        lengths[l] = 64 * (l + 1) - 1;
+    }
+    for (c = 0; c < 20; c++) {
+        cutoffs[c] = (c + 1) * 1000.0 / FE;
+    }
+    t0 = CLK_gethtime();
+    if (!FIR_initTable(&tab, 16, lengths, 20, cutoffs, 0)) {
+        return (1);
+    }
+    t = CLK_gethtime() - t0;
+
+    printf("%s: low-pass designs of 1 to 20 kHz, us/design, best of %d (table: %d floats in %.0f us)\n",
+        prog, NUMREPEAT, tab.size, t / (CLK_countspms() * 1e-3));
+    printf("%6s %12s %10s %9s %12s\n", "taps", "design", "table", "speed-up", "difference");
+    for (l = 0; l < 16; l = 2 * l + 1) {
+        for (k = 0; k < 2; k++) {
+            for (best[k] = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                t0 = CLK_gethtime();
+                for (i = 0; i < 10; i++) {
+                    for (c = 0; c < 20; c++) {
+                        if (k == 0) {
+                            FIR_design(h[0], lengths[l], cutoffs[c], FIR_LOWPASS);
+                        } else {
+                            FIR_designFrom(&tab, h[1], l, c, FIR_LOWPASS);
+                        }
+                    }
+                }
+                if ((t = CLK_gethtime() - t0) < best[k]) {
+                    best[k] = t;
+                }
+            }
+        }
+        for (err = 0.0f, c = 0; c < 20; c++) {
+            FIR_design(h[0], lengths[l], cutoffs[c], FIR_LOWPASS);
+            FIR_designFrom(&tab, h[1], l, c, FIR_LOWPASS);
+            for (k = 0; k < lengths[l]; k++) {
+                if ((d = fabsf(h[0][k] - h[1][k])) > err) {
+                    err = d;
+                }
+            }
+        }
+        printf("%6d %12.2f %10.2f %8.2fx %12g\n", lengths[l], best[0] / (CLK_countspms() * 200e-3),
+            best[1] / (CLK_countspms() * 200e-3), (Double)best[0] / best[1], err);
+    }
+
+    FIR_deleteTable(&tab, 0);
+    return (0);
+}
+
+/*
+ *  ======== oldToFloat ======== oldToShort ========
+ *  The conversions of the exercises before pln.h: a division in double
+ *  precision, and a saturation with branches (Exercice3/4).
+ */
+static Void oldToFloat(const Short *src, Float *dst, Int n)
+{
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        dst[i] = (float)src[i] / 32768.0;
+    }
+}
+
+static Void oldToShort(const Float *src, Short *dst, Int n)
+{
+    Int i;
+
+    for (i = 0; i < n; i++) {
+        if (src[i] > 1.0)
+            dst[i] = 32767.0;
+        else if (src[i] < -1.0)
+            dst[i] = -32768.0;
+        else
+            dst[i] = src[i] * 32768.0;
+    }
+}
+
+/*
+ *  ======== conversions ========
+ *  Cycles per sample of each conversion on frames of the default size.
+ */
+static Int conversions(const char *prog, Double seconds)
+{
+    Int size = BLK_config.size, r, k;
+    LgUns n = (LgUns)(seconds * FE * 2) / size * size, pos, t0, t, best[6];
+    Short *pcm = malloc(n * sizeof(Short));
+    Float *f = malloc(n * sizeof(Float));
+    static const char *names[] = {
+        "(float)x / 32768.0", "PLN_toFloat", "PLN_split", "if/else saturation", "PLN_toShort", "PLN_merge"
+    };
+
+    if (n == 0 || pcm == NULL || f == NULL) {
+        return (1);
+    }
+    makeSignal(0, pcm, n);
+
+    printf("%s: 16-bit/float conversion of %.1f s of stereo audio in frames of %d samples, best of %d\n",
+        prog, seconds, size, NUMREPEAT);
+    for (k = 0; k < 6; k++) {
+        if (k == 3) {
+            /* output conversions: from noise of which a third saturates */
+            for (pos = 0; pos < n; pos++) {
+                f[pos] = pcm[pos] * (2.5f / 32768.0f);
+            }
+        }
+        for (best[k] = ~0UL, r = 0; r < NUMREPEAT; r++) {
+            t0 = CLK_gethtime();
+            for (pos = 0; pos < n; pos += size) {
+                switch (k) {
+                    case 0:
+                        oldToFloat(pcm + pos, f + pos, size);
+                        break;
+                    case 1:
+                        PLN_toFloat(pcm + pos, f + pos, size);
+                        break;
+                    case 2:
+                        PLN_split(pcm + pos, f + pos, f + pos + size / 2, size / 2);
+                        break;
+                    case 3:
+                        oldToShort(f + pos, pcm + pos, size);
+                        break;
+                    case 4:
+                        PLN_toShort(f + pos, pcm + pos, size);
+                        break;
+                    default:
+                        PLN_merge(f + pos, f + pos + size / 2, pcm + pos, size / 2);
+                        break;
+                }
+            }
+            if ((t = CLK_gethtime() - t0) < best[k]) {
+                best[k] = t;
+            }
+        }
+        printf("%-20s %8.2f cycles/sample\n", names[k], (Double)best[k] / n);
+    }
+
+    free(pcm);
+    free(f);
+    return (0);
+}
+
+/*
+ *  ======== convert ========
+ *  Best of NUMREPEAT of the CLK_gethtime() counts to convert 'seconds'
+ *  of stereo noise from 'inRate' to 'outRate', in blocks of 'block'
+ *  samples per channel.
+ */
+static LgUns convert(LgUns inRate, LgUns outRate, Int block, Double seconds)
+{
+    LgUns n = (LgUns)(seconds * inRate), pos, t0, t, best = ~0UL;
+    Float *ch[2], *out[2], *blk[2];
+    SRC_Obj src;
+    Int i, r;
+
+    for (i = 0; i < 2; i++) {
+        ch[i] = malloc(n * sizeof(Float));
+        out[i] = malloc((n / block + 1) * (block * outRate / inRate + 2) * sizeof(Float));
+        if (ch[i] == NULL || out[i] == NULL) {
+            return (0);
+        }
+    }
+    for (pos = 0; pos < n; pos++) {
+        ch[0][pos] = (Float)rand() / RAND_MAX - 0.5f;
+        ch[1][pos] = (Float)rand() / RAND_MAX - 0.5f;
+    }
+
+    for (r = 0; r < NUMREPEAT; r++) {
+        if (!SRC_init(&src, inRate, outRate, 2, block, 0)) {
+            return (0);
+        }
+        t0 = CLK_gethtime();
+        for (pos = 0; pos + block <= n; pos += block) {
+            blk[0] = ch[0] + pos;
+            blk[1] = ch[1] + pos;
+            SRC_apply(&src, blk, block, out);
+        }
+        if ((t = CLK_gethtime() - t0) < best) {
+            best = t;
+        }
+    }
+
+    for (i = 0; i < 2; i++) {
+        free(ch[i]);
+        free(out[i]);
+    }
+    return (best);
+}
+
+/*
+ *  ======== resample ========
+ *  Share of real time of each conversion to and from 44.1 kHz.
+ */
+static Int resample(const char *prog, Double seconds)
+{
+    Int block = BLK_config.size / 2;
+    LgUns from, to, t;
+    Double sec;
+    Uns r, d;
+
+    printf("%s: sample-rate conversion of %.1f s of stereo audio in blocks of %d samples, best of %d\n",
+        prog, seconds, block, NUMREPEAT);
+    printf("%8s %8s %12s %9s\n", "from", "to", "ns/sample", "realtime");
+    for (r = 0; r < NUMRATES; r++) {
+        for (d = 0; d < 2; d++) {
+            from = d == 0 ? rates[r] : FE;
+            to = d == 0 ? FE : rates[r];
+
+            /* a block of 'block' samples at the higher rate */
+            t = convert(from, to, from > to ? block : block * from / to, seconds);
+            if (t == 0) {
+                return (1);
+            }
+            sec = t / (CLK_countspms() * 1e3);
+            printf("%8lu %8lu %12.2f %8.3f%%\n", from, to, sec * 1e9 / (seconds * from),
+                sec / seconds * 100.0);
+        }
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== Mix ========
+ *  XOV_MAXCHANNELS channels of the filter bank benchmark: the same bank
+ *  as one BIQ_Obj per band, whose outputs are added, and as an XOV_Obj.
+ */
+typedef struct Mix {
+    BIQ_Obj     band[XOV_MAXBANDS];
+    XOV_Obj     xov;
+    Float       *in[XOV_MAXCHANNELS];
+    Float       *out[XOV_MAXCHANNELS];
+    Float       *tmp[XOV_MAXCHANNELS];
+} Mix;
+
+typedef struct Worker {
+    pthread_t   thread;
+    Mix         *mix;
+    Int         first, step;            /* mixes first, first + step, ... */
+    Bool        lanes;                  /* XOV_apply() rather than band after band */
+    LgUns       n;
+} Worker;
+
+static Mix mixes[MIXCHANNELS / XOV_MAXCHANNELS];
+
+#define NUMMIXES    (sizeof(mixes) / sizeof(mixes[0]))
+
+/*
+ *  ======== mixInit ========
+ *  Set up 'mix' with 'numBands' bands at the frequencies 'freq'.
+ */
+static Bool mixInit(Mix *mix, Int numBands, const Double freq[], LgUns n)
+{
+    BIQ_Coefs k;
+    Int b, j, s, c;
+
+    if (!XOV_init(&mix->xov, numBands, XOV_MAXCHANNELS, 0) || !XOV_setBands(&mix->xov, numBands, freq)) {
+        return (FALSE);
+    }
+    for (b = 0; b < numBands; b++) {
+        if (!BIQ_init(&mix->band[b], 2 * XOV_MAXBANDS, XOV_MAXCHANNELS, 0)) {
+            return (FALSE);
+        }
+        for (s = 0, j = 0; j < numBands - 1; j++) {
+            BIQ_design(&k, j < b ? BIQ_HIGHPASS : j == b ? BIQ_LOWPASS : BIQ_ALLPASS, freq[j], 0.0,
+                M_SQRT1_2);
+            BIQ_setCoefs(&mix->band[b], s++, &k);
+            if (j <= b) {
+                BIQ_setCoefs(&mix->band[b], s++, &k);
+            }
+        }
+        BIQ_setNumSections(&mix->band[b], s);
+    }
+    for (c = 0; c < XOV_MAXCHANNELS; c++) {
+        if (mix->in[c] == NULL) {
+            mix->in[c] = malloc(n * sizeof(Float));
+            mix->out[c] = malloc(n * sizeof(Float));
+            mix->tmp[c] = malloc(BLK_MAXSIZE * sizeof(Float));
+            if (mix->in[c] == NULL || mix->out[c] == NULL || mix->tmp[c] == NULL) {
+                return (FALSE);
+            }
+            for (j = 0; (LgUns)j < n; j++) {
+                mix->in[c][j] = (Float)rand() / RAND_MAX - 0.5f;
+            }
+        }
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== mixRun ========
+ *  Filter the mixes of a Worker, in blocks of a default PIP frame.
+ */
+static Void *mixRun(Void *arg)
+{
+    Worker *w = arg;
+    Int block = BLK_config.size / 2, m, b, c, i;
+    Float *blk[XOV_MAXCHANNELS];
+    LgUns pos;
+    Uns j;
+    Mix *mix;
+
+    for (j = w->first; j < NUMMIXES; j += w->step) {
+        mix = &w->mix[j];
+        for (pos = 0; pos < w->n; pos += m) {
+            m = w->n - pos < (LgUns)block ? w->n - pos : block;
+            for (c = 0; c < XOV_MAXCHANNELS; c++) {
+                blk[c] = mix->out[c] + pos;
+                memcpy(blk[c], mix->in[c] + pos, m * sizeof(Float));
+            }
+            if (w->lanes) {
+                XOV_apply(&mix->xov, blk, m);
+                continue;
+            }
+            for (b = 0; b < mix->xov.numBands; b++) {
+                for (c = 0; c < XOV_MAXCHANNELS; c++) {
+                    memcpy(mix->tmp[c], mix->in[c] + pos, m * sizeof(Float));
+                }
+                BIQ_apply(&mix->band[b], mix->tmp, m);
+                for (c = 0; c < XOV_MAXCHANNELS; c++) {
+                    for (i = 0; i < m; i++) {
+                        blk[c][i] = b == 0 ? mix->tmp[c][i] : blk[c][i] + mix->tmp[c][i];
+                    }
+                }
+            }
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== mixTime ========
+ *  Best of NUMREPEAT of the CLK_gethtime() counts to filter every mix
+ *  on 'threads' threads.
+ */
+static LgUns mixTime(Int threads, Bool lanes, LgUns n)
+{
+    Worker w[MAXTHREADS];
+    LgUns t0, t, best = ~0UL;
+    Uns m;
+    Int i, r;
+
+    for (r = 0; r < NUMREPEAT; r++) {
+        for (m = 0; m < NUMMIXES; m++) {
+            XOV_reset(&mixes[m].xov);
+            for (i = 0; i < mixes[m].xov.numBands; i++) {
+                BIQ_reset(&mixes[m].band[i]);
+            }
+        }
+        t0 = CLK_gethtime();
+        for (i = 0; i < threads; i++) {
+            w[i].mix = mixes;
+            w[i].first = i;
+            w[i].step = threads;
+            w[i].lanes = lanes;
+            w[i].n = n;
+            if (pthread_create(&w[i].thread, NULL, mixRun, &w[i]) != 0) {
+                return (0);
+            }
+        }
+        for (i = 0; i < threads; i++) {
+            pthread_join(w[i].thread, NULL);
+        }
+        if ((t = CLK_gethtime() - t0) < best) {
+            best = t;
+        }
+    }
+
+    return (best);
+}
+
+/*
+ *  ======== filterBanks ========
+ *  Share of real time of 3 and 8-band filter banks on MIXCHANNELS
+ *  channels, band after band and in lanes, on 1 to 'threads' threads.
+ */
+static Int filterBanks(const char *prog, Double seconds, Int threads)
+{
+    static const Double three[] = { 400.0 / FE, 2500.0 / FE };
+    static const Double eight[] = { 100.0 / FE, 250.0 / FE, 600.0 / FE, 1500.0 / FE, 3500.0 / FE,
+        7000.0 / FE, 12000.0 / FE };
+    LgUns n = (LgUns)(seconds * FE), t, i;
+    Float *serial[XOV_MAXCHANNELS], d, err;
+    Double sec;
+    Int numBands, k, c;
+    Uns m;
+
+    if (threads < 1 || threads > MAXTHREADS) {
+        return (2);
+    }
+    printf("%s: filter banks on %d channels of %.1f s in blocks of %d samples, best of %d\n",
+        prog, MIXCHANNELS, seconds, BLK_config.size / 2, NUMREPEAT);
+    printf("%5s %-8s %7s %12s %9s\n", "bands", "mode", "threads", "ns/sample", "realtime");
+    for (numBands = 3; numBands <= XOV_MAXBANDS; numBands += XOV_MAXBANDS - 3) {
+        for (m = 0; m < NUMMIXES; m++) {
+            if (!mixInit(&mixes[m], numBands, numBands == 3 ? three : eight, n)) {
+                return (1);
+            }
+        }
+        for (k = 0; k < 2; k++) {
+            for (c = 1; c <= threads; c *= 2) {
+                if ((t = mixTime(c, k == 1, n)) == 0) {
+                    return (1);
+                }
+                sec = t / (CLK_countspms() * 1e3);
+                printf("%5d %-8s %7d %12.2f %8.3f%%\n", numBands, k == 0 ? "serial" : "lanes", c,
+                    sec * 1e9 / (seconds * FE * MIXCHANNELS), sec / seconds * 100.0);
+            }
+            /* keep the output of the last run band after band to compare the lanes with */
+            for (c = 0; k == 0 && c < XOV_MAXCHANNELS; c++) {
+                if ((serial[c] = malloc(n * sizeof(Float))) == NULL) {
+                    return (1);
+                }
+                memcpy(serial[c], mixes[0].out[c], n * sizeof(Float));
+            }
+        }
+        for (err = 0.0f, c = 0; c < XOV_MAXCHANNELS; c++) {
+            for (i = 0; i < n; i++) {
+                if ((d = fabsf(serial[c][i] - mixes[0].out[c][i])) > err) {
+                    err = d;
+                }
+            }
+            free(serial[c]);
+        }
+        printf("%5d largest difference between the two: %.1e\n", numBands, err);
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== graphicEq ========
+ *  Share of real time of each graphic equaliser, as a biq.h cascade and
+ *  with geq.h, and the largest difference between their outputs.
+ */
+static Int graphicEq(const char *prog, Double seconds)
+{
+    static const char *names[] = { "octave", "third" };
+    Int block = BLK_config.size / 2, type, b, k, r, c, gain;
+    LgUns n = (LgUns)(seconds * FE) / block * block, pos, t0, t, best[2];
+    Float *ch[2][2], *blk[2], d, err;
+    GEQ_Obj geq;
+    BIQ_Obj biq;
+
+    for (k = 0; k < 2; k++) {
+        for (c = 0; c < 2; c++) {
+            if ((ch[k][c] = malloc(n * sizeof(Float))) == NULL) {
+                return (1);
+            }
+        }
+    }
+
+    printf("%s: graphic equalisers on %.1f s of stereo audio in blocks of %d samples, best of %d\n",
+        prog, seconds, block, NUMREPEAT);
+    printf("%-7s %5s %12s %12s %9s %9s\n", "type", "bands", "cascade ns", "lanes ns", "speed-up", "error");
+    for (type = GEQ_OCTAVE; type <= GEQ_THIRD; type++) {
+        if (!GEQ_init(&geq, type, 2, FE, 0) || !BIQ_init(&biq, geq.numBands, 2, 0)) {
+            return (1);
+        }
+        /* a zigzag of gains, the same sections in both */
+        for (b = 0; b < geq.numBands; b++) {
+            gain = (b * 7) % (2 * GEQ_MAXGAIN + 1) - GEQ_MAXGAIN;
+            GEQ_setGain(&geq, b, gain);
+            BIQ_setCoefs(&biq, b, (const BIQ_Coefs *)&geq.table[(b * (2 * GEQ_MAXGAIN + 1) + gain + GEQ_MAXGAIN) * 5]);
+        }
+        BIQ_setNumSections(&biq, geq.numBands);
+
+        for (k = 0; k < 2; k++) {
+            for (best[k] = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                srand(1);
+                for (pos = 0; pos < n; pos++) {
+                    ch[k][0][pos] = (Float)rand() / RAND_MAX - 0.5f;
+                    ch[k][1][pos] = (Float)rand() / RAND_MAX - 0.5f;
+                }
+                BIQ_reset(&biq);
+                GEQ_reset(&geq);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos < n; pos += block) {
+                    blk[0] = ch[k][0] + pos;
+                    blk[1] = ch[k][1] + pos;
+                    if (k == 0) {
+                        BIQ_apply(&biq, blk, block);
+                    }
+                    else {
+                        GEQ_apply(&geq, blk, block);
+                    }
+                }
+                if ((t = CLK_gethtime() - t0) < best[k]) {
+                    best[k] = t;
+                }
+            }
+        }
+        for (err = 0.0f, c = 0; c < 2; c++) {
+            for (pos = 0; pos < n; pos++) {
+                if ((d = fabsf(ch[0][c][pos] - ch[1][c][pos])) > err) {
+                    err = d;
+                }
+            }
+        }
+        printf("%-7s %5d %12.2f %12.2f %8.2fx %9.1e\n", names[type], geq.numBands,
+            best[0] / (CLK_countspms() * 1e-6) / (2.0 * n), best[1] / (CLK_countspms() * 1e-6) / (2.0 * n),
+            (Double)best[0] / best[1], err);
+    }
+
+    for (k = 0; k < 2; k++) {
+        for (c = 0; c < 2; c++) {
+            free(ch[k][c]);
+        }
+    }
+    return (0);
+}
+
+/*
+ *  ======== blockIir ========
+ *  Cycles per sample of sections of each type, sample by sample and by
+ *  blocks, and the largest difference between the two relative to the
+ *  peak output.
+ */
+static Int blockIir(const char *prog, Double seconds)
+{
+    static const struct {
+        const char *name;
+        Int type;
+        Double freq, gainDb, q;
+    } sections[] = {
+        { "peak 1 kHz +6 dB", BIQ_PEAK, 1000.0, 6.0, 1.0 },
+        { "low shelf 400 Hz -8 dB", BIQ_LOWSHELF, 400.0, -8.0, M_SQRT1_2 },
+        { "peak 20 Hz +12 dB q 4.3", BIQ_PEAK, 20.0, 12.0, 4.32 },
+        { "high-pass 20 Hz", BIQ_HIGHPASS, 20.0, 0.0, M_SQRT1_2 },
+        { "low-pass 15 kHz", BIQ_LOWPASS, 15000.0, 0.0, M_SQRT1_2 },
+    };
+    Int block = BLK_MAXSIZE, k, r, sec, numSections = sizeof(sections) / sizeof(sections[0]);
+    LgUns n = (LgUns)(seconds * FE) / block * block, pos, t0, t, best[2];
+    Float *ch[2], *blk, d, err, peak;
+    BIQ_Coefs coefs;
+    BIQ_Obj biq;
+
+    for (k = 0; k < 2; k++) {
+        if ((ch[k] = malloc(n * sizeof(Float))) == NULL) {
+            return (1);
+        }
+    }
+    if (!BIQ_init(&biq, numSections, 1, 0)) {
+        return (1);
+    }
+
+    printf("%s: biquad sections on %.1f s of one channel in blocks of %d samples, best of %d\n",
+        prog, seconds, block, NUMREPEAT);
+    printf("%-26s %10s %10s %9s %12s\n", "section", "serial", "blocked", "speed-up", "error");
+    for (sec = 0; sec <= numSections; sec++) {
+        /* each section alone, then all of them in cascade */
+        for (k = 0; k < numSections; k++) {
+            BIQ_design(&coefs, sections[k].type, sections[k].freq / FE, sections[k].gainDb, sections[k].q);
+            BIQ_setCoefs(&biq, sec < numSections ? 0 : k, &coefs);
+        }
+        if (sec < numSections) {
+            BIQ_design(&coefs, sections[sec].type, sections[sec].freq / FE, sections[sec].gainDb,
+                sections[sec].q);
+            BIQ_setCoefs(&biq, 0, &coefs);
+        }
+        BIQ_setNumSections(&biq, sec < numSections ? 1 : numSections);
+
+        for (k = 0; k < 2; k++) {
+            for (r = 0; r < numSections; r++) {
+                BIQ_setBlocked(&biq, r, k == 1);
+            }
+            for (best[k] = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                srand(1);
+                for (pos = 0; pos < n; pos++) {
+                    ch[k][pos] = (Float)rand() / RAND_MAX - 0.5f;
+                }
+                BIQ_reset(&biq);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos < n; pos += block) {
+                    blk = ch[k] + pos;
+                    BIQ_apply(&biq, &blk, block);
+                }
+                if ((t = CLK_gethtime() - t0) < best[k]) {
+                    best[k] = t;
+                }
+            }
+        }
+        for (err = peak = 0.0f, pos = 0; pos < n; pos++) {
+            if ((d = fabsf(ch[0][pos] - ch[1][pos])) > err) {
+                err = d;
+            }
+            if (fabsf(ch[0][pos]) > peak) {
+                peak = fabsf(ch[0][pos]);
+            }
+        }
+        printf("%-26s %10.2f %10.2f %8.2fx %8.1f dB\n", sec < numSections ? sections[sec].name : "all in cascade",
+            (Double)best[0] / n, (Double)best[1] / n, (Double)best[0] / best[1],
+            err > 0.0f ? 20.0 * log10(err / peak) : -INFINITY);
+    }
+
+    for (k = 0; k < 2; k++) {
+        free(ch[k]);
+    }
+    return (0);
+}
+
+/*
+ *  ======== comb ========
+ *  One block of a feedback comb on 'dly': the line holds the input plus
+ *  half the tap, the output is half the input plus half the tap.
+ */
+static Void comb(DLY_Obj *dly, Float *x, Float *tap, Int n)
+{
+    Float t;
+    Int i;
+
+    DLY_read(dly, COMBDELAY, tap, n);
+    for (i = 0; i < n; i++) {
+        t = tap[i];
+        tap[i] = 0.5f * t + x[i];
+        x[i] = 0.5f * (x[i] + t);
+    }
+    DLY_write(dly, tap, n);
+}
+
+/*
+ *  ======== delayLines ========
+ *  Cycles per sample of a comb on a line of each format, its size, and
+ *  the error of its output relative to the float line's (noise over
+ *  signal), on noise at -6 dBFS and on a 1 kHz sine at -60 dBFS.
+ */
+static Int delayLines(const char *prog, Double seconds)
+{
+    static const char *formats[] = { "float", "q15", "bfp" };
+    static const char *signals[] = { "noise -6 dB", "sine -60 dB" };
+    Int block = BLK_config.size, format, sig, r;
+    LgUns n = (LgUns)(seconds * FE * 2) / block * block, pos, t0, t, best, bytes;
+    Float *ref[2], *x, *tap;
+    Double noise, power, db[2];
+    unsigned seed;
+    DLY_Obj dly;
+
+    if ((ref[0] = malloc(n * sizeof(Float))) == NULL || (ref[1] = malloc(n * sizeof(Float))) == NULL ||
+        (x = malloc(n * sizeof(Float))) == NULL || (tap = malloc(block * sizeof(Float))) == NULL) {
+        return (1);
+    }
+
+    printf("%s: feedback comb of %d samples on %.1f s of stereo audio in blocks of %d samples, best of %d\n",
+        prog, COMBDELAY, seconds, block, NUMREPEAT);
+    printf("%-6s %8s %14s %14s %14s\n", "format", "bytes", "cycles/sample", signals[0], signals[1]);
+    for (format = DLY_FLOAT; format <= DLY_BFP; format++) {
+        if (!DLY_init(&dly, FE + block, format, 0)) {
+            return (1);
+        }
+        for (best = ~0UL, sig = 0; sig < 2; sig++) {
+            for (r = 0; r < NUMREPEAT; r++) {
+                for (seed = 12345, pos = 0; pos < n; pos++) {
+                    seed = seed * 1664525 + 1013904223;
+                    x[pos] = sig == 0 ? ((Float)(seed >> 16) / 65536.0f - 0.5f) :
+                        0.001f * (Float)sin(2.0 * M_PI * 1000.0 * (pos / 2) / FE);
+                }
+                DLY_reset(&dly);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos < n; pos += block) {
+                    comb(&dly, x + pos, tap, block);
+                }
+                if ((t = CLK_gethtime() - t0) < best) {
+                    best = t;
+                }
+            }
+            if (format == DLY_FLOAT) {
+                memcpy(ref[sig], x, n * sizeof(Float));
+            }
+            for (noise = power = 0.0, pos = 0; pos < n; pos++) {
+                noise += (Double)(x[pos] - ref[sig][pos]) * (x[pos] - ref[sig][pos]);
+                power += (Double)ref[sig][pos] * ref[sig][pos];
+            }
+            db[sig] = noise > 0.0 ? 10.0 * log10(noise / power) : -INFINITY;
+        }
+        bytes = dly.length * (format == DLY_FLOAT ? sizeof(Float) : sizeof(Short)) +
+            (format == DLY_BFP ? dly.length / DLY_BFPBLOCK : 0);
+        printf("%-6s %8lu %14.2f %11.1f dB %11.1f dB\n", formats[format], bytes, (Double)best / n, db[0], db[1]);
+    }
+
+    free(ref[0]);
+    free(ref[1]);
+    free(x);
+    free(tap);
+    return (0);
+}
+
+/*
+ *  ======== multiTap ========
+ *  Share of real time of TAP_apply() for each number of taps and length
+ *  of line, and its largest difference from a direct sum of the taps.
+ */
+static Int multiTap(const char *prog, Double seconds)
+{
+    static const Int numTaps[] = { 8, 16, 32 };
+    static const Int lineSeconds[] = { 1, 10 };
+    Int block = BLK_config.size / 2, k, j, t, r, c, delay[TAP_MAXTAPS];
+    LgUns n = (LgUns)(seconds * FE) / block * block, pos, t0, tm, best;
+    Float *in[2], *ch[2], *blk[2], gain[TAP_MAXTAPS], pan[TAP_MAXTAPS], d, err, mono, angle;
+    TAP_Obj tap;
+
+    for (c = 0; c < 2; c++) {
+        if ((in[c] = malloc(n * sizeof(Float))) == NULL || (ch[c] = malloc(n * sizeof(Float))) == NULL) {
+            return (1);
+        }
+    }
+    srand(1);
+    for (pos = 0; pos < n; pos++) {
+        in[0][pos] = (Float)rand() / RAND_MAX - 0.5f;
+        in[1][pos] = (Float)rand() / RAND_MAX - 0.5f;
+    }
+
+    printf("%s: multi-tap echo on %.1f s of stereo audio in blocks of %d samples, best of %d\n",
+        prog, seconds, block, NUMREPEAT);
+    printf("%5s %6s %10s %9s %9s\n", "taps", "line", "ns/sample", "deadline", "error");
+    for (k = 0; k < sizeof(numTaps) / sizeof(numTaps[0]); k++) {
+        for (j = 0; j < sizeof(lineSeconds) / sizeof(lineSeconds[0]); j++) {
+            if (!TAP_init(&tap, numTaps[k], lineSeconds[j] * FE, DLY_FLOAT, 0)) {
+                return (1);
+            }
+            /* taps spread over the line, on a rhythm, panned left and right in turn */
+            for (t = 0; t < numTaps[k]; t++) {
+                delay[t] = (Int)((LgUns)lineSeconds[j] * FE * (t + 1) / numTaps[k]) - 1;
+                gain[t] = 0.8f / (t + 1);
+                pan[t] = t % 2 ? 0.5f : -0.5f;
+                TAP_setTap(&tap, t, delay[t], gain[t], pan[t], 0.5);
+            }
+            for (best = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                for (c = 0; c < 2; c++) {
+                    memcpy(ch[c], in[c], n * sizeof(Float));
+                }
+                TAP_reset(&tap);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos < n; pos += block) {
+                    blk[0] = ch[0] + pos;
+                    blk[1] = ch[1] + pos;
+                    TAP_apply(&tap, blk, block);
+                }
+                if ((tm = CLK_gethtime() - t0) < best) {
+                    best = tm;
+                }
+            }
+            /* after the first block, whose gains ramp up from 0 */
+            for (err = 0.0f, pos = block; pos < n; pos++) {
+                for (c = 0; c < 2; c++) {
+                    for (d = in[c][pos], t = 0; t < numTaps[k]; t++) {
+                        if (pos >= delay[t]) {
+                            mono = 0.5f * (in[0][pos - delay[t]] + in[1][pos - delay[t]]);
+                            angle = (pan[t] + 1.0f) * (Float)M_PI / 4.0f;
+                            d += gain[t] * (c == 0 ? cosf(angle) : sinf(angle)) * mono;
+                        }
+                    }
+                    if (fabsf(d - ch[c][pos]) > err) {
+                        err = fabsf(d - ch[c][pos]);
+                    }
+                }
+            }
+            printf("%5d %5ds %10.2f %8.2f%% %9.1e\n", numTaps[k], lineSeconds[j],
+                best / (CLK_countspms() * 1e-6) / (2.0 * n), best / (CLK_countspms() * 1e-6) / (2.0 * n) /
+                (1e9 / (2.0 * FE)) * 100.0, err);
+        }
+    }
+
+    for (c = 0; c < 2; c++) {
+        free(in[c]);
+        free(ch[c]);
+    }
+    return (0);
+}
+
+/*
+ *  ======== reverbs ========
+ *  Share of real time of FDN_apply() for each number of lines and
+ *  matrix, and the time its impulse response takes to fall by 60 dB
+ *  (for a reverb time of 1 s without damping), from the energy of
+ *  successive windows of 10 ms.
+ */
+static Int reverbs(const char *prog, Double seconds)
+{
+    static const char *matrices[] = { "householder", "hadamard" };
+    static const Int numLines[] = { 4, 8, 16 };
+    Int block = BLK_config.size / 2, window = FE / 100, k, matrix, r, c;
+    LgUns n = (LgUns)(seconds * FE) / block * block, pos, t0, t, best, last, i;
+    Float *ch[2], *blk[2];
+    Double energy, first;
+    FDN_Obj fdn;
+
+    if (n < 2 * FE) {
+        n = 2 * FE / block * block;
+    }
+    for (c = 0; c < 2; c++) {
+        if ((ch[c] = malloc(n * sizeof(Float))) == NULL) {
+            return (1);
+        }
+    }
+
+    printf("%s: reverbs on %.1f s of stereo audio in blocks of %d samples, best of %d\n",
+        prog, (Double)n / FE, block, NUMREPEAT);
+    printf("%-12s %5s %10s %9s %12s\n", "matrix", "lines", "ns/sample", "deadline", "T60 (1 s)");
+    for (matrix = FDN_HOUSEHOLDER; matrix <= FDN_HADAMARD; matrix++) {
+        for (k = 0; k < sizeof(numLines) / sizeof(numLines[0]); k++) {
+            if (!FDN_init(&fdn, numLines[k], matrix, FE, 0)) {
+                return (1);
+            }
+            FDN_setMix(&fdn, 0.5f, 0.5f);
+            for (best = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                srand(1);
+                for (pos = 0; pos < n; pos++) {
+                    ch[0][pos] = (Float)rand() / RAND_MAX - 0.5f;
+                    ch[1][pos] = (Float)rand() / RAND_MAX - 0.5f;
+                }
+                FDN_reset(&fdn);
+                t0 = CLK_gethtime();
+                for (pos = 0; pos < n; pos += block) {
+                    blk[0] = ch[0] + pos;
+                    blk[1] = ch[1] + pos;
+                    FDN_apply(&fdn, blk, block);
+                }
+                if ((t = CLK_gethtime() - t0) < best) {
+                    best = t;
+                }
+            }
+
+            /* impulse response, the reverb alone */
+            FDN_setDecay(&fdn, 1.0, 0.0);
+            FDN_setMix(&fdn, 0.0f, 1.0f);
+            FDN_reset(&fdn);
+            memset(ch[0], 0, n * sizeof(Float));
+            memset(ch[1], 0, n * sizeof(Float));
+            ch[0][0] = ch[1][0] = 1.0f;
+            for (pos = 0; pos < n; pos += block) {
+                blk[0] = ch[0] + pos;
+                blk[1] = ch[1] + pos;
+                FDN_apply(&fdn, blk, block);
+            }
+            /* from the window after the longest line, which holds the first echoes of every line */
+            for (first = 0.0, last = 0, pos = (fdn.delay[numLines[k] - 1] / window + 1) * window;
+                pos + window <= n; pos += window) {
+                for (energy = 0.0, i = pos; i < pos + window; i++) {
+                    energy += (Double)ch[0][i] * ch[0][i] + (Double)ch[1][i] * ch[1][i];
+                }
+                if (first == 0.0) {
+                    first = energy;
+                    last = pos;
+                }
+                else if (energy >= first * 1e-6) {
+                    last = pos;
+                }
+            }
+            printf("%-12s %5d %10.2f %8.2f%% %10.2f s\n", matrices[matrix], numLines[k],
+                best / (CLK_countspms() * 1e-6) / (2.0 * n),
+                best / (CLK_countspms() * 1e-6) / (2.0 * n) / (1e9 / (2.0 * FE)) * 100.0,
+                (Double)(last + window - (fdn.delay[numLines[k] - 1] / window + 1) * window) / FE);
+        }
+    }
+
+    for (c = 0; c < 2; c++) {
+        free(ch[c]);
+    }
+    return (0);
+}
+
+/*
+ *  ======== spill ========
+ *  Write a ramp through a line of SPILLSECONDS on disk and read it back
+ *  at half and all of the line, block after block at SPILLSPEED times
+ *  real time, as the audio path of spl.h: its time per block, its major
+ *  page faults (the reads it waited for) and the bytes of the file
+ *  mapped in RAM at the end.  Like an audio thread, the loop runs
+ *  SCHED_FIFO when it may, so that the worker only runs between blocks,
+ *  even on one core.
+ */
+#define SPILLSECONDS    120
+#define SPILLSPEED      20
+
+static Int spill(const char *prog, Double seconds)
+{
+    Int block = BLK_config.size / 2, tap, errors = 0;
+    LgUns maxDelay = SPILLSECONDS * FE, n, pos, i, t0, t, worst = 0, total = 0, pages, resident, p;
+    Float *x, *y;
+    unsigned char *in;
+    struct timespec next;
+    struct rusage before, after;
+    struct sched_param param;
+    SPL_Obj spl;
+
+    n = (maxDelay + (LgUns)(seconds * FE)) / block * block;
+    x = malloc(block * sizeof(Float));
+    y = malloc(block * sizeof(Float));
+    if (x == NULL || y == NULL || !SPL_open(&spl, NULL, maxDelay) ||
+        !SPL_setTap(&spl, 0, maxDelay / 2) || !SPL_setTap(&spl, 1, maxDelay)) {
+        return (1);
+    }
+    while (!SPL_tapReady(&spl, 0) || !SPL_tapReady(&spl, 1)) {
+        usleep(1000);
+    }
+
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    printf("%s: %d s line spilled to a file, taps at %d and %d s, %.1f s of mono audio in blocks of %d samples "
+        "at %d times real time, %s\n", prog, SPILLSECONDS, SPILLSECONDS / 2, SPILLSECONDS, (Double)n / FE, block,
+        SPILLSPEED, pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 ? "SCHED_FIFO" : "SCHED_OTHER");
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    getrusage(RUSAGE_THREAD, &before);
+    for (pos = 0; pos < n; pos += block) {
+        /* the ramp is exact in floats, so the taps must read it back exactly */
+        for (i = 0; i < block; i++) {
+            x[i] = (Float)((pos + i) % 65521);
+        }
+        t0 = CLK_gethtime();
+        for (tap = 0; tap < 2; tap++) {
+            SPL_read(&spl, tap, y, block);
+            for (i = 0; i < block; i++) {
+                if (y[i] != (pos + i < spl.delay[tap] ? 0.0f : (Float)((pos + i - spl.delay[tap]) % 65521))) {
+                    errors++;
+                }
+            }
+        }
+        SPL_write(&spl, x, block);
+        t = CLK_gethtime() - t0;
+        total += t;
+        if (t > worst) {
+            worst = t;
+        }
+
+        next.tv_nsec += 1000000000L / FE * block / SPILLSPEED;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    getrusage(RUSAGE_THREAD, &after);
+    param.sched_priority = 0;
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    pages = (spl.length * sizeof(Float) + getpagesize() - 1) / getpagesize();
+    if ((in = malloc(pages)) == NULL || mincore(spl.base, spl.length * sizeof(Float), in) != 0) {
+        return (1);
+    }
+    for (resident = 0, p = 0; p < pages; p++) {
+        resident += in[p] & 1;
+    }
+    printf("%-22s %10.2f us\n", "mean per block", (Double)total / (n / block) / (CLK_countspms() * 1e-3));
+    printf("%-22s %10.2f us (deadline %.0f us)\n", "worst block", (Double)worst / (CLK_countspms() * 1e-3),
+        (Double)block / FE * 1e6);
+    printf("%-22s %10ld\n", "major faults", after.ru_majflt - before.ru_majflt);
+    printf("%-22s %10.1f MB of %.1f MB\n", "line in RAM", (Double)resident * getpagesize() / (1 << 20),
+        (Double)spl.length * sizeof(Float) / (1 << 20));
+    printf("%s: %d samples read back wrong\n", prog, errors);
+
+    SPL_close(&spl);
+    free(in);
+    free(x);
+    free(y);
+    return (errors != 0);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *prog = strrchr(argv[0], '/') != NULL ? strrchr(argv[0], '/') + 1 : argv[0];
+    Double seconds = 10.0, nsPerSample, cyclesPerSample, deadline, worst128 = 0.0;
+    LgUns n, best, t;
+    Short *sig;
+    Bool conv = FALSE, kernel = FALSE, src = FALSE, pcm = FALSE, bank = FALSE, eq = FALSE, iir = FALSE, delay = FALSE, taps = FALSE, reverb = FALSE,
+        spilled = FALSE;
+    Uns b, s;
+    Int threads = sysconf(_SC_NPROCESSORS_ONLN), r, c;
+
+    while ((c = getopt(argc, argv, "s:xkcrej:qidtflg:")) != -1) {
+        switch (c) {
+            case 's':
+                seconds = atof(optarg);
+                break;
+            case 'x':
+                conv = TRUE;
+                break;
+            case 'k':
+                kernel = TRUE;
+                break;
+            case 'c':
+                pcm = TRUE;
+                break;
+            case 'r':
+                src = TRUE;
+                break;
+            case 'e':
+                bank = TRUE;
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'q':
+                eq = TRUE;
+                break;
+            case 'i':
+                iir = TRUE;
+                break;
+            case 'd':
+                delay = TRUE;
+                break;
+            case 't':
+                taps = TRUE;
+                break;
+            case 'f':
+                reverb = TRUE;
+                break;
+            case 'l':
+                spilled = TRUE;
+                break;
+            case 'g':
+                if (nsliders == MAXSLIDERS) {
+                    return (2);
+                }
+                sliders[nsliders++] = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s seconds] [-x] [-k] [-c] [-r] [-e] [-j threads] [-q] [-i] [-d] [-t] [-f] [-l]\n"
+                    "       %*s [-g symbol=value]...\n", prog, (int)strlen(prog), "");
+                return (2);
+        }
+    }
+    if (conv) {
+        return (crossover(prog, seconds));
+    }
+    if (kernel) {
+        return (cascade(prog, seconds) || designs(prog));
+    }
+    if (src) {
+        return (resample(prog, seconds));
+    }
+    if (pcm) {
+        return (conversions(prog, seconds));
+    }
+    if (bank) {
+        return (filterBanks(prog, seconds, threads));
+    }
+    if (eq) {
+        return (graphicEq(prog, seconds));
+    }
+    if (iir) {
+        return (blockIir(prog, seconds));
+    }
+    if (delay) {
+        return (delayLines(prog, seconds));
+    }
+    if (taps) {
+        return (multiTap(prog, seconds));
+    }
+    if (reverb) {
+        return (reverbs(prog, seconds));
+    }
+    if (spilled) {
+        return (spill(prog, seconds));
+    }
+
+    n = (LgUns)(seconds * FE * 2) / MAXBLOCK * MAXBLOCK;
+    if (n == 0 || (sig = malloc(n * sizeof(Short))) == NULL) {
+        return (1);
+    }
+    LOG_quiet = TRUE;
+
+    printf("%s: echo() on %.1f s of stereo audio, best of %d\n", prog, seconds, NUMREPEAT);
+    printf("%-8s %6s %10s %14s %9s\n", "signal", "block", "ns/sample", "cycles/sample", "deadline");
+    for (s = 0; s < NUMSIGNALS; s++) {
+        makeSignal(s, sig, n);
+        for (b = 0; b < NUMBLOCKSIZES; b++) {
+            for (best = ~0UL, r = 0; r < NUMREPEAT; r++) {
+                if ((t = run(blockSizes[b], sig, n, s == SIG_DENORMAL)) < best) {
+                    best = t;
+                }
+            }
+            cyclesPerSample = (Double)best / n;
+            nsPerSample = cyclesPerSample / CLK_countspms() * 1e6;
+
+            /* one interleaved sample lasts 1/(2*FE) s, whatever the block */
+            deadline = nsPerSample / (1e9 / (2.0 * FE)) * 100.0;
+            if (blockSizes[b] == 128 && s != SIG_DENORMAL && deadline > worst128) {
+                worst128 = deadline;
+            }
+            printf("%-8s %6d %10.2f %14.2f %8.3f%%\n", signalNames[s], blockSizes[b],
+                nsPerSample, cyclesPerSample, deadline);
+        }
+    }
+    printf("%s: worst case uses %.3f%% of the %.0f us deadline of a 128-sample frame\n",
+        prog, worst128, 128 / 2.0 / FE * 1e6);
+
+    free(sig);
+    return (0);
+}
@@ -0,0 +1,579 @@
+/*
+ *  ======== bios_host.c ========
+ *  Host (Linux) implementation of the subset of DSP/BIOS used by the
+ *  Exercice* applications: CLK, LOG, MEM, STS, SYS, SWI, PIP and the
+ *  PIO adapter.
+ *
+ *  Everything runs in a single thread.  HWI context is the simulated
+ *  codec (codec_host.c) and SWIs are run by SWI_run() once the codec
+ *  "interrupt" has returned, so the ordering of notify functions, mailbox
+ *  updates and SWI execution is the same as on the DSK.
+ */
+#include <dlfcn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#include <std.h>
+#include <clk.h>
+#include <log.h>
+#include <mem.h>
+#include <sts.h>
+#include <sys.h>
+#include <swi.h>
+#include <pip.h>
+#include <iom.h>
+#include <pio.h>
+
+#include "bios_host.h"
+
+#define SWI_MAXREADY    8
+
+LOG_Obj LOG_system = LOG_OBJ("LOG_system");
+Bool LOG_quiet = FALSE;
+
+static SWI_Obj *swiReady[SWI_MAXREADY];
+static Int swiNumReady = 0;
+static SWI_Obj *swiCurrent = NULL;
+static Float clkCountsPerMs = 0.0;
+
+/*
+ *  ======== BIOS_now ========
+ *  Monotonic time in seconds.
+ */
+Double BIOS_now(Void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+/*
+ *  ======== BIOS_flushDenormals ========
+ *  Flush denormal results to zero and read denormal operands as zero
+ *  (FTZ and DAZ of MXCSR), or not, in the calling thread.  The C67x FPU
+ *  always does: without it, a recursive filter decaying in silence runs
+ *  into denormals, which cost x86 a microcode assist of about 100
+ *  cycles per operation.
+ */
+Void BIOS_flushDenormals(Bool flush)
+{
+#if defined(__SSE__)
+    if (flush) {
+        _mm_setcsr(_mm_getcsr() | 0x8040);
+    }
+    else {
+        _mm_setcsr(_mm_getcsr() & ~0x8040);
+    }
+#endif
+}
+
+/*
+ *  ======== CLK_gethtime ========
+ */
+LgUns CLK_gethtime(Void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (__builtin_ia32_rdtsc());
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((LgUns)ts.tv_sec * 1000000000UL + ts.tv_nsec);
+#endif
+}
+
+/*
+ *  ======== CLK_getltime ========
+ *  Low-resolution time, in milliseconds.
+ */
+LgUns CLK_getltime(Void)
+{
+    return ((LgUns)(BIOS_now() * 1000.0));
+}
+
+/*
+ *  ======== CLK_countspms ========
+ *  CLK_gethtime() counts per millisecond, measured over 20 ms against
+ *  the monotonic clock the first time it is called.
+ */
+Float CLK_countspms(Void)
+{
+    Double t0, t1;
+    LgUns c0, c1;
+
+    if (clkCountsPerMs == 0.0) {
+        t0 = BIOS_now();
+        c0 = CLK_gethtime();
+        while ((t1 = BIOS_now()) - t0 < 0.020) {
+        }
+        c1 = CLK_gethtime();
+        clkCountsPerMs = (c1 - c0) / ((t1 - t0) * 1000.0);
+    }
+
+    return (clkCountsPerMs);
+}
+
+/*
+ *  ======== GEL_set ========
+ *  Apply "symbol=value" to an Int global of the application, the way a
+ *  slider of Volume.gel writes into the target memory.  The executable
+ *  must be linked with -rdynamic.
+ */
+Bool GEL_set(char *assignment)
+{
+    char *eq = strchr(assignment, '=');
+    char name[64];
+    Int *var;
+
+    if (eq == NULL || eq - assignment >= (long)sizeof(name)) {
+        return (FALSE);
+    }
+    memcpy(name, assignment, eq - assignment);
+    name[eq - assignment] = '\0';
+    if ((var = (Int *)dlsym(RTLD_DEFAULT, name)) == NULL) {
+        return (FALSE);
+    }
+    *var = atoi(eq + 1);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== LOG_printf ========
+ */
+Void LOG_printf(LOG_Obj *log, String format, ...)
+{
+    va_list ap;
+
+    log->seqnum++;
+    if (LOG_quiet) {
+        return;
+    }
+    fprintf(stderr, "%s: ", log->name);
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+}
+
+/*
+ *  ======== MEM_alloc ========
+ */
+Ptr MEM_alloc(Int segid, Uns size, Uns align)
+{
+    void *buf;
+
+    if (align < sizeof(void *)) {
+        align = sizeof(void *);
+    }
+    if (posix_memalign(&buf, align, size) != 0) {
+        return (MEM_ILLEGAL);
+    }
+
+    return (buf);
+}
+
+/*
+ *  ======== MEM_calloc ========
+ */
+Ptr MEM_calloc(Int segid, Uns size, Uns align)
+{
+    Ptr buf = MEM_alloc(segid, size, align);
+
+    if (buf != MEM_ILLEGAL) {
+        memset(buf, 0, size);
+    }
+
+    return (buf);
+}
+
+/*
+ *  ======== MEM_free ========
+ */
+Bool MEM_free(Int segid, Ptr buf, Uns size)
+{
+    free(buf);
+    return (TRUE);
+}
+
+/*
+ *  ======== STS_add ========
+ */
+Void STS_add(STS_Obj *sts, LgInt value)
+{
+    sts->num++;
+    sts->acc += value;
+    if (value > sts->max) {
+        sts->max = value;
+    }
+}
+
+/*
+ *  ======== STS_delta ========
+ */
+Void STS_delta(STS_Obj *sts, LgInt value)
+{
+    STS_add(sts, value - sts->prev);
+}
+
+/*
+ *  ======== STS_reset ========
+ */
+Void STS_reset(STS_Obj *sts)
+{
+    sts->num = 0;
+    sts->acc = 0;
+    sts->max = -0x7fffffffL;
+}
+
+/*
+ *  ======== STS_set ========
+ */
+Void STS_set(STS_Obj *sts, LgInt value)
+{
+    sts->prev = value;
+}
+
+/*
+ *  ======== SYS_printf ========
+ */
+Void SYS_printf(String fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+}
+
+/*
+ *  ======== SYS_abort ========
+ */
+Void SYS_abort(String fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    fputc('\n', stderr);
+    exit(1);
+}
+
+/*
+ *  ======== SWI_post ========
+ */
+Void SWI_post(SWI_Obj *swi)
+{
+    if (swi->posted) {
+        return;
+    }
+    if (swiNumReady == SWI_MAXREADY) {
+        SYS_abort("SWI_post: too many ready SWIs");
+    }
+    swi->posted = TRUE;
+    swiReady[swiNumReady++] = swi;
+}
+
+/*
+ *  ======== SWI_andn ========
+ */
+Void SWI_andn(SWI_Obj *swi, Uns mask)
+{
+    if (swi->mailbox == 0) {
+        return;
+    }
+    swi->mailbox &= ~mask;
+    if (swi->mailbox == 0) {
+        SWI_post(swi);
+    }
+}
+
+/*
+ *  ======== SWI_andnHook ========
+ *  Form of SWI_andn() usable as a PIP notify function.
+ */
+Void SWI_andnHook(Arg swi, Arg mask)
+{
+    SWI_andn((SWI_Obj *)swi, (Uns)mask);
+}
+
+/*
+ *  ======== SWI_or ========
+ */
+Void SWI_or(SWI_Obj *swi, Uns mask)
+{
+    swi->mailbox |= mask;
+    SWI_post(swi);
+}
+
+/*
+ *  ======== SWI_getmbox ========
+ *  Mailbox value of the running SWI, as it was when the SWI started.
+ */
+Uns SWI_getmbox(Void)
+{
+    return (swiCurrent != NULL ? swiCurrent->initkey : 0);
+}
+
+/*
+ *  ======== SWI_run ========
+ *  Run the posted SWIs, highest priority first, until none is ready.
+ *  Returns the number of SWI functions run.
+ */
+Int SWI_run(Void)
+{
+    SWI_Obj *swi;
+    LgUns t0, dt;
+    Int i, best, n = 0;
+
+    while (swiNumReady > 0) {
+        for (best = 0, i = 1; i < swiNumReady; i++) {
+            if (swiReady[i]->pri > swiReady[best]->pri) {
+                best = i;
+            }
+        }
+        swi = swiReady[best];
+        swiReady[best] = swiReady[--swiNumReady];
+
+        swi->posted = FALSE;
+        swi->mailbox = swi->initkey;
+        swiCurrent = swi;
+
+        t0 = CLK_gethtime();
+        (*swi->fxn)(swi->arg0, swi->arg1);
+        dt = CLK_gethtime() - t0;
+
+        swiCurrent = NULL;
+        swi->runs++;
+        swi->busy += dt;
+        if (dt > swi->maxTime) {
+            swi->maxTime = dt;
+        }
+        n++;
+    }
+
+    return (n);
+}
+
+/*
+ *  ======== PIP_init ========
+ *  Allocate the frames of a statically configured pipe.  The frames are
+ *  aligned on 128 bytes like bufFrameAlign in exercice3cfg.s62.
+ */
+Bool PIP_init(PIP_Obj *pipe)
+{
+    Uns i;
+    void *buf;
+
+    free(pipe->buf);
+    pipe->buf = NULL;
+    if (pipe->numframes == 0 || pipe->numframes > PIP_MAXFRAMES || pipe->framesize == 0) {
+        return (FALSE);
+    }
+    if (posix_memalign(&buf, 128, pipe->framesize * pipe->numframes * sizeof(Uns)) != 0) {
+        return (FALSE);
+    }
+    memset(buf, 0, pipe->framesize * pipe->numframes * sizeof(Uns));
+
+    pipe->buf = buf;
+    for (i = 0; i < pipe->numframes; i++) {
+        pipe->frameAddr[i] = pipe->buf + i * pipe->framesize;
+        pipe->frameSize[i] = 0;
+    }
+    pipe->allocIdx = pipe->putIdx = pipe->getIdx = pipe->freeIdx = 0;
+    pipe->writerNumFrames = pipe->numframes;
+    pipe->readerNumFrames = 0;
+    pipe->writerAddr = pipe->readerAddr = NULL;
+    pipe->writerSize = pipe->readerSize = 0;
+
+    return (TRUE);
+}
+
+/*
+ *  ======== PIP_alloc ========
+ */
+Void PIP_alloc(PIP_Obj *pipe)
+{
+    pipe->writerAddr = pipe->frameAddr[pipe->allocIdx];
+    pipe->writerSize = pipe->framesize;
+    pipe->allocIdx = (pipe->allocIdx + 1) % pipe->numframes;
+    pipe->writerNumFrames--;
+}
+
+/*
+ *  ======== PIP_put ========
+ */
+Void PIP_put(PIP_Obj *pipe)
+{
+    pipe->frameSize[pipe->putIdx] = pipe->writerSize;
+    pipe->putIdx = (pipe->putIdx + 1) % pipe->numframes;
+    pipe->readerNumFrames++;
+
+    if (pipe->notifyReader != NULL) {
+        (*pipe->notifyReader)(pipe->nrarg0, pipe->nrarg1);
+    }
+}
+
+/*
+ *  ======== PIP_get ========
+ */
+Void PIP_get(PIP_Obj *pipe)
+{
+    pipe->readerAddr = pipe->frameAddr[pipe->getIdx];
+    pipe->readerSize = pipe->frameSize[pipe->getIdx];
+    pipe->getIdx = (pipe->getIdx + 1) % pipe->numframes;
+    pipe->readerNumFrames--;
+}
+
+/*
+ *  ======== PIP_free ========
+ */
+Void PIP_free(PIP_Obj *pipe)
+{
+    pipe->freeIdx = (pipe->freeIdx + 1) % pipe->numframes;
+    pipe->writerNumFrames++;
+
+    if (pipe->notifyWriter != NULL) {
+        (*pipe->notifyWriter)(pipe->nwarg0, pipe->nwarg1);
+    }
+}
+
+/*
+ *  ======== PIO_init ========
+ */
+Void PIO_init(Void)
+{
+}
+
+/*
+ *  ======== PIO_new ========
+ */
+Void PIO_new(PIO_Obj *pio, PIP_Obj *pip, String name, Int mode, Ptr optArgs)
+{
+    if (strcmp(name, "/udevCodec") != 0) {
+        SYS_abort("PIO_new: unknown device %s", name);
+    }
+    memset(pio, 0, sizeof(*pio));
+    pio->pip = pip;
+    pio->mode = mode;
+    CODEC_bind(pio, mode);
+}
+
+static Void devQueue(PIO_Obj *pio, Ptr frame)
+{
+    pio->queue[(pio->head + pio->count) % PIP_MAXFRAMES] = frame;
+    pio->count++;
+}
+
+/*
+ *  ======== PIO_rxPrime ========
+ *  notifyWriter of the receive pipe: hand every empty frame to the
+ *  device.
+ */
+Void PIO_rxPrime(PIO_Obj *pio)
+{
+    if (!pio->started || pio->inPrime) {
+        return;
+    }
+    pio->inPrime = TRUE;
+    while (PIP_getWriterNumFrames(pio->pip) > 0) {
+        PIP_alloc(pio->pip);
+        devQueue(pio, PIP_getWriterAddr(pio->pip));
+    }
+    pio->inPrime = FALSE;
+}
+
+/*
+ *  ======== PIO_txPrime ========
+ *  notifyReader of the transmit pipe: hand every full frame to the
+ *  device.
+ */
+Void PIO_txPrime(PIO_Obj *pio)
+{
+    if (!pio->started || pio->inPrime) {
+        return;
+    }
+    pio->inPrime = TRUE;
+    while (PIP_getReaderNumFrames(pio->pip) > 0) {
+        PIP_get(pio->pip);
+        devQueue(pio, PIP_getReaderAddr(pio->pip));
+    }
+    pio->inPrime = FALSE;
+}
+
+/*
+ *  ======== PIO_rxStart ========
+ */
+Void PIO_rxStart(PIO_Obj *pio, Int frameCount)
+{
+    Int i;
+
+    pio->inPrime = TRUE;
+    for (i = 0; i < frameCount && PIP_getWriterNumFrames(pio->pip) > 0; i++) {
+        PIP_alloc(pio->pip);
+        devQueue(pio, PIP_getWriterAddr(pio->pip));
+    }
+    pio->inPrime = FALSE;
+    pio->started = TRUE;
+}
+
+/*
+ *  ======== PIO_txStart ========
+ *  Prime the device with frameCount frames filled with initialValue.
+ */
+Void PIO_txStart(PIO_Obj *pio, Int frameCount, Int initialValue)
+{
+    Uns *frame;
+    Uns j;
+    Int i;
+
+    pio->started = TRUE;
+    for (i = 0; i < frameCount && PIP_getWriterNumFrames(pio->pip) > 0; i++) {
+        PIP_alloc(pio->pip);
+        frame = PIP_getWriterAddr(pio->pip);
+        for (j = 0; j < pio->pip->framesize; j++) {
+            frame[j] = (Uns)initialValue;
+        }
+        PIP_setWriterSize(pio->pip, pio->pip->framesize);
+        PIP_put(pio->pip);
+        pio->primed++;
+    }
+}
+
+/*
+ *  ======== PIO_devTake ========
+ *  Frame at the head of the device queue, NULL if the application did
+ *  not keep up.
+ */
+Ptr PIO_devTake(PIO_Obj *pio)
+{
+    return (pio->count > 0 ? pio->queue[pio->head] : NULL);
+}
+
+/*
+ *  ======== PIO_devDone ========
+ *  The device completed the frame returned by PIO_devTake(): give it
+ *  back to the pipe, full for a receive channel, empty for a transmit
+ *  channel.
+ */
+Void PIO_devDone(PIO_Obj *pio)
+{
+    pio->head = (pio->head + 1) % PIP_MAXFRAMES;
+    pio->count--;
+
+    if (pio->mode == IOM_INPUT) {
+        PIP_setWriterSize(pio->pip, pio->pip->framesize);
+        PIP_put(pio->pip);
+    }
+    else {
+        PIP_free(pio->pip);
+    }
+}
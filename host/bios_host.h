@@ -0,0 +1,59 @@
+/*
+ *  ======== bios_host.h ========
+ *  Entry points of the host DSP/BIOS stand-in which have no target
+ *  counterpart in the application sources: start-up of the statically
+ *  configured objects and the simulated codec scheduler.
+ */
+#ifndef BIOS_HOST_
+#define BIOS_HOST_
+
+#include <std.h>
+#include <log.h>
+#include <pip.h>
+#include <swi.h>
+#include <pio.h>
+
+#include "map.h"
+#include "wav.h"
+
+/* objects of the host configuration (hostcfg.c), as in exercice3cfg.s62 */
+extern LOG_Obj trace;
+extern PIP_Obj pipRx;
+extern PIP_Obj pipTx;
+extern SWI_Obj swiEcho;
+
+/* the application's main(), renamed when echo.c is built for the host */
+extern Int host_appMain();
+
+extern Void BIOS_init(Void);
+extern Double BIOS_now(Void);
+extern Void BIOS_flushDenormals(Bool flush);
+extern Bool GEL_set(char *assignment);
+
+/*
+ *  Simulated AIC23 codec behind "/udevCodec".  One CODEC_tick() is one
+ *  frame period: the playback side plays the transmit frame it latched
+ *  at the previous period and the capture side fills its receive frame
+ *  from the input file, or from what was just played in loopback.  The
+ *  files may have another rate than CODEC_RATE, see codec_host.c.
+ */
+#define CODEC_RATE  44100           /* Hz, as the exercises configure the AIC23 */
+
+typedef struct CODEC_Stats {
+    LgUns       captured;       /* frames read from the input file */
+    LgUns       played;         /* frames written to the output file */
+    LgUns       skipped;        /* leading frames not written (-a) */
+    LgUns       underruns;      /* playback frame period with no frame */
+    LgUns       overruns;       /* capture frame period with no frame */
+} CODEC_Stats;
+
+extern Bool CODEC_setSource(WAV_Obj *wav, Int loops);
+extern Bool CODEC_setSink(WAV_Obj *wav, Bool align);
+extern Void CODEC_setLoopback(Void);
+extern Void CODEC_setMapped(MAP_Obj *in, MAP_Obj *out);
+extern Void CODEC_setRange(LgUns first, LgUns count, LgUns warm);
+extern Bool CODEC_tick(Void);
+extern Void CODEC_bind(PIO_Obj *pio, Int mode);
+extern CODEC_Stats CODEC_stats;
+
+#endif /* BIOS_HOST_ */
@@ -0,0 +1,426 @@
+/*
+ *  ======== codec_host.c ========
+ *  Simulated AIC23 codec behind the "/udevCodec" device.
+ *
+ *  Each CODEC_tick() is one frame period.  Like the EDMA on the DSK,
+ *  each side works on the frame it latched at the previous tick: the
+ *  playback side completes its frame first, then the capture side,
+ *  which is the order the interrupts come in once PIO_txStart() has been
+ *  called before PIO_rxStart(), and both then latch the next frame of
+ *  their queue.  A frame queued by echo() after a tick is therefore only
+ *  played one period later, and a side that had nothing to latch loses
+ *  the frame period (underrun/overrun) exactly as the hardware would.
+ *  With p frames primed by PIO_txStart() the input reaches the output
+ *  p frame periods later; p must be at least 2 (BLK_MINPRIME).
+ *
+ *  The codec runs at CODEC_RATE.  A WAV file at another rate goes
+ *  through a sample-rate converter (src.h) on its way in or out, so the
+ *  output file has the rate of the input file.  The converters delay the
+ *  signal by a fraction of a millisecond, which -a does not take off.
+ *  Mapped files are used at their own rate, unconverted.
+ */
+#include <string.h>
+
+#include <std.h>
+#include <iom.h>
+#include <mem.h>
+#include <pio.h>
+
+#include "bios_host.h"
+#include "pln.h"
+#include "src.h"
+
+#define CODEC_MAXFRAMESIZE  4096    /* words, i.e. stereo sample frames */
+#define CODEC_BLOCK         256     /* sample frames of the input file converted at a time */
+
+/*
+ *  Conversion between the rate of a file and CODEC_RATE: 'pcm' holds
+ *  interleaved samples at the rate of the file, 'in' and 'out' the
+ *  planar input and output of the converter, and on the capture side
+ *  'out' queues the 'len' converted samples not yet captured.
+ */
+typedef struct Conv {
+    Bool        on;
+    SRC_Obj     src;
+    Short       *pcm;
+    Float       *in[2];
+    Float       *out[2];
+    Int         len;
+} Conv;
+
+CODEC_Stats CODEC_stats;
+
+static PIO_Obj *codecRx = NULL;
+static PIO_Obj *codecTx = NULL;
+static WAV_Obj *codecSource = NULL;
+static WAV_Obj *codecSink = NULL;
+static Int codecLoops = 1;
+static Bool codecAlign = FALSE;
+static Bool codecEof = FALSE;
+static Bool codecLoopback = FALSE;
+static Short codecLine[2 * CODEC_MAXFRAMESIZE];    /* last frame played, for the loopback */
+static Bool codecRunning = FALSE;
+static Ptr codecRxFrame = NULL;     /* frames latched at the last tick */
+static Ptr codecTxFrame = NULL;
+static Conv codecConvIn;            /* input file to codec */
+static Conv codecConvOut;           /* codec to output file */
+static MAP_Obj *codecMapIn = NULL;  /* mapped files, see CODEC_setMapped() */
+static MAP_Obj *codecMapOut = NULL;
+static LgUns codecMapPos;           /* next input frame handed to echo() */
+static LgUns codecMapEnd;           /* input frame where the run ends */
+static LgUns codecMapBase;          /* frame echo() started on */
+static LgUns codecMapFirst;         /* first output frame written */
+static LgUns codecMapNext;          /* output frames written by echo() */
+static Uns codecMapArmed;           /* pipTx allocIdx of the frame set on the output */
+
+/*
+ *  ======== CODEC_bind ========
+ *  Called by PIO_new() for each channel opened on the codec.
+ */
+Void CODEC_bind(PIO_Obj *pio, Int mode)
+{
+    if (mode == IOM_INPUT) {
+        codecRx = pio;
+        codecRxFrame = NULL;
+    }
+    else {
+        codecTx = pio;
+        codecTxFrame = NULL;
+    }
+    codecRunning = FALSE;
+}
+
+/*
+ *  ======== convInit ========
+ *  Set up 'cv' to convert blocks of up to 'maxIn' samples from 'inRate'
+ *  to 'outRate', with room for 'extra' more samples in 'out'.
+ */
+static Bool convInit(Conv *cv, LgUns inRate, LgUns outRate, Int maxIn, Int extra)
+{
+    Int c, pcm;
+
+    cv->len = 0;
+    cv->on = inRate != outRate;
+    if (!cv->on) {
+        return (TRUE);
+    }
+    if (!SRC_init(&cv->src, inRate, outRate, 2, maxIn, 0)) {
+        return (FALSE);
+    }
+    pcm = maxIn > cv->src.maxOut ? maxIn : cv->src.maxOut;
+    if ((cv->pcm = MEM_alloc(0, 2 * pcm * sizeof(Short), 8)) == MEM_ILLEGAL) {
+        return (FALSE);
+    }
+    for (c = 0; c < 2; c++) {
+        cv->in[c] = MEM_alloc(0, maxIn * sizeof(Float), 8);
+        cv->out[c] = MEM_alloc(0, (cv->src.maxOut + extra) * sizeof(Float), 8);
+        if (cv->in[c] == MEM_ILLEGAL || cv->out[c] == MEM_ILLEGAL) {
+            return (FALSE);
+        }
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== CODEC_setSource ========
+ *  Capture from 'wav', played 'loops' times back to back.  FALSE if its
+ *  rate cannot be converted to CODEC_RATE.
+ */
+Bool CODEC_setSource(WAV_Obj *wav, Int loops)
+{
+    codecSource = wav;
+    codecLoops = loops > 0 ? loops : 1;
+    codecEof = FALSE;
+
+    return (convInit(&codecConvIn, wav->rate, CODEC_RATE, CODEC_BLOCK, CODEC_MAXFRAMESIZE));
+}
+
+/*
+ *  ======== CODEC_setSink ========
+ *  Play into 'wav' (or nowhere if NULL).  With 'align' the frames of
+ *  silence primed by PIO_txStart() are not written, so that the output
+ *  file lines up with the input file.  FALSE if CODEC_RATE cannot be
+ *  converted to its rate.
+ */
+Bool CODEC_setSink(WAV_Obj *wav, Bool align)
+{
+    codecSink = wav;
+    codecAlign = align;
+
+    return (wav == NULL || convInit(&codecConvOut, CODEC_RATE, wav->rate, CODEC_MAXFRAMESIZE, 0));
+}
+
+/*
+ *  ======== CODEC_setLoopback ========
+ *  Capture what was played during the same period, as with the line
+ *  output wired to the line input, instead of a file.  The codec then
+ *  runs until the caller stops calling CODEC_tick().
+ */
+Void CODEC_setLoopback(Void)
+{
+    codecLoopback = TRUE;
+}
+
+/*
+ *  ======== CODEC_setMapped ========
+ *  Offline run on mapped files: instead of copying samples, the codec
+ *  points each receive frame it completes at the next samples of 'in'
+ *  and the next transmit frame echo() will allocate at the next frame
+ *  of 'out', so that echo() reads and writes the files in place.  The
+ *  output is aligned with the input (the primed frames are skipped).
+ */
+Void CODEC_setMapped(MAP_Obj *in, MAP_Obj *out)
+{
+    codecMapIn = in;
+    codecMapOut = out;
+    codecAlign = TRUE;
+    CODEC_setRange(0, in->frames, 0);
+}
+
+/*
+ *  ======== CODEC_setRange ========
+ *  Restrict a mapped run to the 'count' sample frames from 'first'.
+ *  echo() starts 'warm' frames earlier, to rebuild its state, and what
+ *  it produces for them is not written.
+ */
+Void CODEC_setRange(LgUns first, LgUns count, LgUns warm)
+{
+    codecMapBase = codecMapPos = first - warm;
+    codecMapEnd = first + count <= codecMapIn->frames ? first + count : codecMapIn->frames;
+    codecMapFirst = first;
+    codecMapNext = 0;
+    codecMapArmed = PIP_MAXFRAMES;
+    codecEof = FALSE;
+    MAP_skip(codecMapIn, codecMapPos);
+    MAP_skip(codecMapOut, first);
+}
+
+/*
+ *  ======== captureMapped ========
+ *  Complete the receive frame at the head of the queue with the next
+ *  samples of the input mapping.  A last partial frame is copied into
+ *  the frame of the pipe and padded with silence.
+ */
+static Void captureMapped(Uns nframes)
+{
+    PIP_Obj *pip = codecRx->pip;
+    Short *own = (Short *)(pip->buf + pip->putIdx * pip->framesize);
+    LgUns n = codecMapEnd - codecMapPos;
+
+    if (n >= nframes) {
+        pip->frameAddr[pip->putIdx] = MAP_frame(codecMapIn, codecMapPos, nframes);
+        n = nframes;
+    }
+    else {
+        memcpy(own, MAP_frame(codecMapIn, codecMapPos, n), n * 2 * sizeof(Short));
+        memset(own + 2 * n, 0, (nframes - n) * 2 * sizeof(Short));
+        pip->frameAddr[pip->putIdx] = own;
+        codecEof = TRUE;
+    }
+    if (n > 0) {
+        CODEC_stats.captured++;
+    }
+    codecMapPos += n;
+
+    /* echo() may still hold the frames of the pipe */
+    if (codecMapPos > codecMapBase + pip->numframes * nframes) {
+        MAP_done(codecMapIn, codecMapPos - pip->numframes * nframes);
+    }
+}
+
+/*
+ *  ======== armMapped ========
+ *  Point the next transmit frame echo() will allocate at the next frame
+ *  of the output mapping, or back at its own memory during the warm-up
+ *  and past the end of the range.
+ */
+static Void armMapped(Uns nframes)
+{
+    PIP_Obj *pip = codecTx->pip;
+    LgUns next;
+    Short *frame;
+
+    if (codecMapArmed != PIP_MAXFRAMES && pip->allocIdx != codecMapArmed) {
+        codecMapNext++;
+    }
+    next = codecMapBase + codecMapNext * nframes;
+    if (next >= codecMapFirst) {
+        MAP_done(codecMapOut, next);
+    }
+    if (next >= codecMapFirst && next < codecMapEnd &&
+        (frame = MAP_frame(codecMapOut, next, nframes)) != NULL) {
+        pip->frameAddr[pip->allocIdx] = frame;
+    }
+    else {
+        pip->frameAddr[pip->allocIdx] = pip->buf + pip->allocIdx * pip->framesize;
+    }
+    codecMapArmed = pip->allocIdx;
+}
+
+/*
+ *  ======== readSource ========
+ *  Read up to 'frames' sample frames of the input file, looping over it
+ *  as requested; sets codecEof at its end.
+ */
+static LgUns readSource(Short *buf, LgUns frames)
+{
+    LgUns n = 0;
+
+    while (!codecEof && n < frames) {
+        n += WAV_read(codecSource, buf + 2 * n, frames - n);
+        if (n < frames && codecSource->pos >= codecSource->frames) {
+            if (--codecLoops > 0 && WAV_rewind(codecSource)) {
+                continue;
+            }
+            codecEof = TRUE;
+        }
+    }
+
+    return (n);
+}
+
+/*
+ *  ======== readConverted ========
+ *  Same as readSource() at CODEC_RATE: blocks of the file are converted
+ *  until 'frames' samples are queued, or the file ends.
+ */
+static LgUns readConverted(Short *buf, LgUns frames)
+{
+    Conv *cv = &codecConvIn;
+    Float *out[2];
+    LgUns n;
+    Int c;
+
+    while ((LgUns)cv->len < frames && !codecEof) {
+        if ((n = readSource(cv->pcm, CODEC_BLOCK)) > 0) {
+            PLN_split(cv->pcm, cv->in[0], cv->in[1], n);
+            out[0] = cv->out[0] + cv->len;
+            out[1] = cv->out[1] + cv->len;
+            cv->len += SRC_apply(&cv->src, cv->in, n, out);
+        }
+    }
+    n = (LgUns)cv->len < frames ? (LgUns)cv->len : frames;
+    PLN_merge(cv->out[0], cv->out[1], buf, n);
+    cv->len -= n;
+    for (c = 0; c < 2; c++) {
+        memmove(cv->out[c], cv->out[c] + n, cv->len * sizeof(Float));
+    }
+
+    return (n);
+}
+
+static Void capture(Short *frame, Uns nframes)
+{
+    LgUns n;
+
+    if (codecLoopback) {
+        memcpy(frame, codecLine, nframes * 2 * sizeof(Short));
+        CODEC_stats.captured++;
+        return;
+    }
+    n = codecConvIn.on ? readConverted(frame, nframes) : readSource(frame, nframes);
+    if (n > 0) {
+        CODEC_stats.captured++;
+    }
+    memset(frame + 2 * n, 0, (nframes - n) * 2 * sizeof(Short));
+}
+
+static Void play(const Short *frame, Uns nframes)
+{
+    static const Short silence[2 * CODEC_MAXFRAMESIZE];
+    Conv *cv = &codecConvOut;
+    Int n;
+
+    if (frame == NULL) {
+        frame = silence;
+    }
+    if (codecLoopback) {
+        memcpy(codecLine, frame, nframes * 2 * sizeof(Short));
+    }
+    if (codecAlign && CODEC_stats.skipped < (LgUns)codecTx->primed) {
+        CODEC_stats.skipped++;
+        return;
+    }
+    if (codecSink != NULL && cv->on) {
+        PLN_split(frame, cv->in[0], cv->in[1], nframes);
+        n = SRC_apply(&cv->src, cv->in, nframes, cv->out);
+        PLN_merge(cv->out[0], cv->out[1], cv->pcm, n);
+        WAV_write(codecSink, cv->pcm, n);
+    }
+    else if (codecSink != NULL) {
+        WAV_write(codecSink, frame, nframes);
+    }
+    CODEC_stats.played++;
+}
+
+/*
+ *  ======== CODEC_tick ========
+ *  Run one frame period.  Returns FALSE once the whole input, delayed
+ *  by the primed transmit frames, has been played.
+ */
+Bool CODEC_tick(Void)
+{
+    Uns nframes;
+
+    if (codecRx == NULL || codecTx == NULL ||
+        (codecSource == NULL && codecMapIn == NULL && !codecLoopback) ||
+        codecRx->pip->framesize > CODEC_MAXFRAMESIZE ||
+        codecTx->pip->framesize > CODEC_MAXFRAMESIZE) {
+        return (FALSE);
+    }
+    if (codecEof && CODEC_stats.played + CODEC_stats.skipped >=
+        CODEC_stats.captured + codecTx->primed) {
+        return (FALSE);
+    }
+
+    /* the DMA starts on the frames queued before the first period */
+    if (!codecRunning) {
+        codecTxFrame = PIO_devTake(codecTx);
+        codecRxFrame = PIO_devTake(codecRx);
+        codecRunning = TRUE;
+    }
+
+    /* playback: one frame of interleaved 16-bit stereo per 32-bit word */
+    nframes = codecTx->pip->framesize;
+    if (codecTxFrame != NULL) {
+        play(codecTxFrame, nframes);
+        PIO_devDone(codecTx);
+    }
+    else {
+        CODEC_stats.underruns++;
+        play(NULL, nframes);
+    }
+    codecTxFrame = PIO_devTake(codecTx);
+
+    /* capture */
+    nframes = codecRx->pip->framesize;
+    if (codecRxFrame != NULL) {
+        if (codecMapIn != NULL) {
+            captureMapped(nframes);
+        }
+        else {
+            capture(codecRxFrame, nframes);
+        }
+        PIO_devDone(codecRx);
+    }
+    else {
+        /* the samples of this period are lost */
+        static Short lost[2 * CODEC_MAXFRAMESIZE];
+
+        CODEC_stats.overruns++;
+        if (codecMapIn != NULL) {
+            codecMapPos += codecMapPos + nframes <= codecMapEnd ? nframes : codecMapEnd - codecMapPos;
+        }
+        else {
+            capture(lost, nframes);
+        }
+    }
+    codecRxFrame = PIO_devTake(codecRx);
+
+    if (codecMapOut != NULL) {
+        armMapped(codecTx->pip->framesize);
+    }
+
+    return (TRUE);
+}
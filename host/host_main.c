@@ -0,0 +1,266 @@
+/*
+ *  ======== host_main.c ========
+ *  Runs one ExerciceN/echo.c on the host: the application's main() binds
+ *  its PIPs to the simulated codec, which then captures from a WAV file
+ *  and plays into another one as fast as echo() keeps up.  A file at
+ *  another rate than the 44.1 kHz of the codec is converted (src.h).
+ *
+ *  usage: exerciceN [-q] [-a] [-L] [-b samples] [-f frames] [-l loops]
+ *                   [-g symbol=value]... in.wav [out.wav]
+ *         exerciceN -M|-D [-q] [-b samples] [-f frames] [-g symbol=value]... in out
+ *         exerciceN -m [-q] [-L] [-b samples] [-f frames] [-g symbol=value]...
+ *
+ *      -q  do not print the LOG messages
+ *      -a  do not write the frames primed by PIO_txStart(), so that the
+ *          output lines up with the input
+ *      -b  samples per PIP frame (interleaved, BLK_MINSIZE..BLK_MAXSIZE,
+ *          128 by default)
+ *      -f  frames per PIP (2 by default)
+ *      -L  low latency: prime only BLK_MINPRIME transmit frames
+ *      -l  play the input 'loops' times (to run hours of audio)
+ *      -M  offline run on memory-mapped files (map.h), WAV or .raw, as
+ *          fast as echo() and the disk go; the output is aligned
+ *      -D  same as -M, the output written with O_DIRECT instead
+ *      -m  measure the latency instead: the codec output is looped back
+ *          to its input and echo() runs a LAT measurement (lat.h)
+ *      -g  set an Int global of the application before starting, like
+ *          a slider of Volume.gel does, e.g. -g curseur_retard=3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <std.h>
+#include <clk.h>
+#include <log.h>
+#include <swi.h>
+#include <pip.h>
+#include <pio.h>
+
+#include "bios_host.h"
+#include "blk.h"
+#include "lat.h"
+#include "prf.h"
+
+#define MAXSLIDERS  16
+#define MAXMEASURE  (10 * 44100)    /* samples per channel before giving up */
+
+extern PRF_Obj prfEcho;
+extern LAT_Obj latEcho;
+extern PIO_Obj pioTx;
+
+/*
+ *  ======== printStages ========
+ *  Per-stage timing of echo(), with the non-empty histogram bins.
+ */
+static Void printStages(const char *prog)
+{
+    PRF_Obj prf;
+    PRF_Stage *s;
+    Double us = 1e3 / CLK_countspms();
+    Int i, b;
+
+    PRF_read(&prfEcho, &prf);
+    for (i = 0; i < prf.numStages; i++) {
+        s = &prf.stage[i];
+        if (s->num == 0) {
+            continue;
+        }
+        fprintf(stderr, "%s:   %-9s mean %.3f us, min %.3f us, max %.3f us\n", prog, s->name,
+            (Double)s->total / s->num * us, s->min * us, s->max * us);
+        fprintf(stderr, "%s:   %-9s", prog, "");
+        for (b = 0; b < PRF_NUMBINS; b++) {
+            if (s->hist[b] != 0) {
+                fprintf(stderr, " <%.3gus:%u", (Double)(2UL << b) * us, s->hist[b]);
+            }
+        }
+        fputc('\n', stderr);
+    }
+    if (prf.missed > 0) {
+        fprintf(stderr, "%s:   %lu missed frames\n", prog, prf.missed);
+    }
+}
+
+/*
+ *  ======== measure ========
+ *  Run the codec in loopback until echo() has measured the latency and
+ *  compare it with the primed transmit frames.
+ */
+static Int measure(const char *prog)
+{
+    static char request[] = "mesure_latence=1";
+    LgUns ticks, maxTicks = MAXMEASURE / pipRx.framesize + 1;
+    Int expected = pioTx.primed * pipTx.framesize;
+
+    if (!GEL_set(request)) {
+        fprintf(stderr, "%s: no latency measurement in this application\n", prog);
+        return (1);
+    }
+    for (ticks = 0; latEcho.state != LAT_DONE && ticks < maxTicks; ticks++) {
+        CODEC_tick();
+        SWI_run();
+    }
+
+    fprintf(stderr, "%s: %d frames of %d samples, %d primed: latency %d samples (%.2f ms), expected %d\n",
+        prog, pipTx.numframes, BLK_config.size, pioTx.primed, latEcho.latency,
+        latEcho.latency * 1e3 / CODEC_RATE, expected);
+
+    return (latEcho.latency == expected ? 0 : 1);
+}
+
+static Void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q] [-a] [-L] [-b samples] [-f frames] [-l loops]\n"
+        "       %*s [-g symbol=value]... in.wav [out.wav]\n"
+        "       %s -M|-D [-q] [-b samples] [-f frames] [-g symbol=value]... in out\n"
+        "       %s -m [-q] [-L] [-b samples] [-f frames] [-g symbol=value]...\n",
+        prog, (int)strlen(prog), "", prog, prog);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    char *sliders[MAXSLIDERS];
+    const char *prog = strrchr(argv[0], '/') != NULL ? strrchr(argv[0], '/') + 1 : argv[0];
+    WAV_Obj in, out;
+    MAP_Obj mapIn, mapOut;
+    Bool align = FALSE, haveOut = FALSE, loopback = FALSE, mapped = FALSE, direct = FALSE;
+    Int loops = 1, nsliders = 0, i, c;
+    Double t0, elapsed, audio, period, mean, max;
+    LgUns samples, n, rate = CODEC_RATE;
+
+    while ((c = getopt(argc, argv, "qaMDmLb:f:l:g:")) != -1) {
+        switch (c) {
+            case 'q':
+                LOG_quiet = TRUE;
+                break;
+            case 'a':
+                align = TRUE;
+                break;
+            case 'D':
+                direct = TRUE;
+                /* FALLTHROUGH */
+            case 'M':
+                mapped = TRUE;
+                break;
+            case 'm':
+                loopback = TRUE;
+                break;
+            case 'L':
+                BLK_config.lowLatency = TRUE;
+                break;
+            case 'b':
+                BLK_config.size = atoi(optarg);
+                break;
+            case 'f':
+                BLK_config.numFrames = atoi(optarg);
+                break;
+            case 'l':
+                loops = atoi(optarg);
+                break;
+            case 'g':
+                if (nsliders == MAXSLIDERS) {
+                    usage(prog);
+                }
+                sliders[nsliders++] = optarg;
+                break;
+            default:
+                usage(prog);
+        }
+    }
+    if (loopback ? optind != argc : mapped ? argc - optind != 2 : optind >= argc || argc - optind > 2) {
+        usage(prog);
+    }
+    if (!BLK_check(&BLK_config) || BLK_config.numFrames > PIP_MAXFRAMES) {
+        fprintf(stderr, "%s: frames of %d to %d samples (even) and 2 to %d frames per pipe\n",
+            prog, BLK_MINSIZE, BLK_MAXSIZE, PIP_MAXFRAMES);
+        return (2);
+    }
+    if (loopback) {
+        CODEC_setLoopback();
+    }
+    else if (mapped) {
+        if (!MAP_openRead(&mapIn, argv[optind])) {
+            fprintf(stderr, "%s: cannot map %s (16-bit stereo WAV or .raw expected)\n", prog, argv[optind]);
+            return (1);
+        }
+        /* room for the last frame, padded */
+        n = BLK_config.size / 2;
+        if (!MAP_openWrite(&mapOut, argv[optind + 1], mapIn.rate, (mapIn.frames + n - 1) / n * n, direct)) {
+            fprintf(stderr, "%s: cannot create %s\n", prog, argv[optind + 1]);
+            return (1);
+        }
+        CODEC_setMapped(&mapIn, &mapOut);
+        rate = mapIn.rate;
+    }
+    else {
+        if (!WAV_openRead(&in, argv[optind])) {
+            fprintf(stderr, "%s: cannot read %s (16-bit PCM WAV expected)\n", prog, argv[optind]);
+            return (1);
+        }
+        haveOut = argc - optind == 2;
+        if (haveOut && !WAV_openWrite(&out, argv[optind + 1], in.rate)) {
+            fprintf(stderr, "%s: cannot create %s\n", prog, argv[optind + 1]);
+            return (1);
+        }
+        if (!CODEC_setSource(&in, loops) || !CODEC_setSink(haveOut ? &out : NULL, align)) {
+            fprintf(stderr, "%s: cannot convert %lu Hz to %d Hz\n", prog, in.rate, CODEC_RATE);
+            return (1);
+        }
+    }
+
+    /* start-up sequence of DSP/BIOS: configured objects, then main() */
+    BIOS_init();
+    host_appMain();
+    for (i = 0; i < nsliders; i++) {
+        if (!GEL_set(sliders[i])) {
+            fprintf(stderr, "%s: cannot set %s\n", prog, sliders[i]);
+            return (1);
+        }
+    }
+    if (loopback) {
+        return (measure(prog));
+    }
+
+    t0 = BIOS_now();
+    while (CODEC_tick()) {
+        SWI_run();
+    }
+    elapsed = BIOS_now() - t0;
+
+    if (mapped) {
+        MAP_close(&mapIn, 0);
+        if (!MAP_close(&mapOut, mapIn.frames)) {
+            fprintf(stderr, "%s: cannot write %s\n", prog, argv[optind + 1]);
+            return (1);
+        }
+    }
+    else {
+        WAV_close(&in);
+        if (haveOut) {
+            WAV_close(&out);
+        }
+    }
+
+    samples = CODEC_stats.captured * pipRx.framesize;
+    audio = (Double)samples / rate;
+    period = (Double)pipRx.framesize / rate;
+    fprintf(stderr, "%s: %lu samples (%.1f s) in %.3f s: %.3g samples/s, %.0fx real time\n",
+        prog, samples, audio, elapsed, samples / elapsed, audio / elapsed);
+    fprintf(stderr, "%s: %d frames of %d samples, %d primed: %.2f ms from input to output\n",
+        prog, pipTx.numframes, BLK_config.size, pioTx.primed, pioTx.primed * period * 1e3);
+    if (swiEcho.runs > 0) {
+        mean = (Double)swiEcho.busy / swiEcho.runs / CLK_countspms() * 1e-3;
+        max = (Double)swiEcho.maxTime / CLK_countspms() * 1e-3;
+        fprintf(stderr, "%s: echo() %lu runs, mean %.2f us, max %.2f us, %.2f%% of the %.0f us frame period\n",
+            prog, swiEcho.runs, mean * 1e6, max * 1e6, mean / period * 100.0, period * 1e6);
+        printStages(prog);
+    }
+    if (CODEC_stats.underruns > 0 || CODEC_stats.overruns > 0 || LOG_system.seqnum > 0) {
+        fprintf(stderr, "%s: %lu underruns, %lu overruns, %u errors logged\n",
+            prog, CODEC_stats.underruns, CODEC_stats.overruns, LOG_system.seqnum);
+    }
+
+    return (0);
+}
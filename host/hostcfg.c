@@ -0,0 +1,57 @@
+/*
+ *  ======== hostcfg.c ========
+ *  Host counterpart of the objects generated from exercice3.cdb into
+ *  exercice3cfg.s62.  The pipes start with the framesize (0x40 words,
+ *  i.e. 64 stereo samples) and numframes (2) of the target
+ *  configuration, and BIOS_init() resizes them to BLK_config.  The
+ *  notify functions are wired the same way: pipRx posts swiEcho through
+ *  mailbox bit 1 when a frame has been captured, pipTx through bit 2
+ *  when a frame has been played.
+ */
+#include <std.h>
+#include <log.h>
+#include <pip.h>
+#include <swi.h>
+#include <sys.h>
+#include <pio.h>
+
+#include "bios_host.h"
+#include "blk.h"
+
+extern Void echo(Void);
+extern PIO_Obj pioRx, pioTx;
+
+LOG_Obj trace = LOG_OBJ("trace");
+
+/* memory segments of the configuration, only names on the host */
+Int IRAM = 0;
+Int SDRAM = 1;
+
+SWI_Obj swiEcho = SWI_OBJ(echo, 1, 3);
+
+PIP_Obj pipRx = PIP_OBJ("pipRx", 0x40, 2,
+    PIO_rxPrime, &pioRx, 0,
+    SWI_andnHook, &swiEcho, 1);
+
+PIP_Obj pipTx = PIP_OBJ("pipTx", 0x40, 2,
+    SWI_andnHook, &swiEcho, 2,
+    PIO_txPrime, &pioTx, 0);
+
+/*
+ *  ======== BIOS_init ========
+ *  Allocate the frames of the statically configured pipes, with the
+ *  frame size and count of BLK_config, and treat denormals as the C67x
+ *  does.
+ */
+Void BIOS_init(Void)
+{
+    if (!BLK_check(&BLK_config) || BLK_config.numFrames > PIP_MAXFRAMES) {
+        SYS_abort("BIOS_init: unsupported block configuration");
+    }
+    pipRx.framesize = pipTx.framesize = BLK_config.size / 2;
+    pipRx.numframes = pipTx.numframes = BLK_config.numFrames;
+    if (!PIP_init(&pipRx) || !PIP_init(&pipTx)) {
+        SYS_abort("BIOS_init: cannot allocate the pipes");
+    }
+    BIOS_flushDenormals(TRUE);
+}
@@ -0,0 +1,16 @@
+/*
+ *  ======== clk.h ========
+ *  Host stand-in for the DSP/BIOS CLK module.  The high-resolution time
+ *  is the time-stamp counter on x86 hosts and a nanosecond count
+ *  elsewhere; CLK_countspms() gives its rate, calibrated on first use.
+ */
+#ifndef CLK_
+#define CLK_
+
+#include <std.h>
+
+extern LgUns CLK_gethtime(Void);
+extern LgUns CLK_getltime(Void);
+extern Float CLK_countspms(Void);
+
+#endif /* CLK_ */
@@ -0,0 +1,12 @@
+/*
+ *  ======== iom.h ========
+ *  Host stand-in for the DSP/BIOS IOM mini-driver interface.
+ */
+#ifndef IOM_
+#define IOM_
+
+#define IOM_INPUT       0x0001
+#define IOM_OUTPUT      0x0002
+#define IOM_INOUT       (IOM_INPUT | IOM_OUTPUT)
+
+#endif /* IOM_ */
@@ -0,0 +1,26 @@
+/*
+ *  ======== log.h ========
+ *  Host stand-in for the DSP/BIOS LOG module.  Messages are written
+ *  to stderr prefixed by the name of the log object.
+ */
+#ifndef LOG_
+#define LOG_
+
+#include <std.h>
+
+typedef struct LOG_Obj {
+    String      name;           /* name shown in front of each message */
+    Uns         seqnum;         /* number of messages logged so far */
+} LOG_Obj;
+
+#define LOG_OBJ(name)   { name, 0 }
+
+extern LOG_Obj LOG_system;
+extern Bool LOG_quiet;          /* TRUE to only count messages */
+
+extern Void LOG_printf(LOG_Obj *log, String format, ...);
+
+#define LOG_error(format, arg0)     LOG_printf(&LOG_system, (format), (arg0))
+#define LOG_message(format, arg0)   LOG_printf(&LOG_system, (format), (arg0))
+
+#endif /* LOG_ */
@@ -0,0 +1,20 @@
+/*
+ *  ======== mem.h ========
+ *  Host stand-in for the DSP/BIOS MEM module.  Segment ids are accepted
+ *  for compatibility and all allocations come from the C heap.
+ */
+#ifndef MEM_
+#define MEM_
+
+#include <std.h>
+
+#define MEM_ILLEGAL     ((Ptr)NULL)
+
+extern Int IRAM;
+extern Int SDRAM;
+
+extern Ptr MEM_alloc(Int segid, Uns size, Uns align);
+extern Ptr MEM_calloc(Int segid, Uns size, Uns align);
+extern Bool MEM_free(Int segid, Ptr buf, Uns size);
+
+#endif /* MEM_ */
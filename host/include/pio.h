@@ -0,0 +1,36 @@
+/*
+ *  ======== pio.h ========
+ *  Host stand-in for the PIO adapter which binds a PIP to an IOM
+ *  channel.  The only device is "/udevCodec", a simulated AIC23 codec
+ *  whose capture side reads a WAV file and whose playback side writes
+ *  one (see codec_host.c).
+ */
+#ifndef PIO_
+#define PIO_
+
+#include <std.h>
+#include <pip.h>
+
+typedef struct PIO_Obj {
+    PIP_Obj     *pip;
+    Int         mode;           /* IOM_INPUT or IOM_OUTPUT */
+    Bool        started;
+    Bool        inPrime;        /* guards against re-entry from notify */
+    Int         primed;         /* frames handed over by PIO_txStart */
+    Ptr         queue[PIP_MAXFRAMES];   /* frames owned by the device */
+    Uns         head;
+    Uns         count;
+} PIO_Obj;
+
+extern Void PIO_init(Void);
+extern Void PIO_new(PIO_Obj *pio, PIP_Obj *pip, String name, Int mode, Ptr optArgs);
+extern Void PIO_rxStart(PIO_Obj *pio, Int frameCount);
+extern Void PIO_txStart(PIO_Obj *pio, Int frameCount, Int initialValue);
+extern Void PIO_rxPrime(PIO_Obj *pio);
+extern Void PIO_txPrime(PIO_Obj *pio);
+
+/* device side, used by the simulated codec */
+extern Ptr PIO_devTake(PIO_Obj *pio);
+extern Void PIO_devDone(PIO_Obj *pio);
+
+#endif /* PIO_ */
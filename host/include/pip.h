@@ -0,0 +1,62 @@
+/*
+ *  ======== pip.h ========
+ *  Host stand-in for the DSP/BIOS PIP module.
+ *
+ *  A pipe is a ring of numframes frames of framesize words.  The writer
+ *  side allocates empty frames and puts them full, the reader side gets
+ *  full frames and frees them.  As on the target, notifyReader is called
+ *  by PIP_put and notifyWriter by PIP_free.
+ */
+#ifndef PIP_
+#define PIP_
+
+#include <std.h>
+
+#define PIP_MAXFRAMES   16
+
+typedef struct PIP_Obj {
+    String      name;
+    Uns         framesize;      /* frame size in words */
+    Uns         numframes;
+    Fxn         notifyWriter;
+    Arg         nwarg0;
+    Arg         nwarg1;
+    Fxn         notifyReader;
+    Arg         nrarg0;
+    Arg         nrarg1;
+
+    /* run-time state, set up by PIP_init() */
+    Uns         *buf;
+    Ptr         frameAddr[PIP_MAXFRAMES];
+    Uns         frameSize[PIP_MAXFRAMES];
+    Uns         allocIdx;       /* next empty frame handed to the writer */
+    Uns         putIdx;         /* next frame the writer will put */
+    Uns         getIdx;         /* next full frame handed to the reader */
+    Uns         freeIdx;        /* next frame the reader will free */
+    Uns         writerNumFrames;
+    Uns         readerNumFrames;
+    Ptr         writerAddr;
+    Uns         writerSize;
+    Ptr         readerAddr;
+    Uns         readerSize;
+} PIP_Obj;
+
+#define PIP_OBJ(name, framesize, numframes, nw, nwarg0, nwarg1, nr, nrarg0, nrarg1) \
+    { (name), (framesize), (numframes), (Fxn)(nw), (Arg)(nwarg0), (Arg)(nwarg1), \
+      (Fxn)(nr), (Arg)(nrarg0), (Arg)(nrarg1) }
+
+#define PIP_getReaderAddr(pipe)         ((pipe)->readerAddr)
+#define PIP_getReaderSize(pipe)         ((pipe)->readerSize)
+#define PIP_getReaderNumFrames(pipe)    ((Int)(pipe)->readerNumFrames)
+#define PIP_getWriterAddr(pipe)         ((pipe)->writerAddr)
+#define PIP_getWriterSize(pipe)         ((pipe)->writerSize)
+#define PIP_getWriterNumFrames(pipe)    ((Int)(pipe)->writerNumFrames)
+#define PIP_setWriterSize(pipe, size)   ((pipe)->writerSize = (size))
+
+extern Bool PIP_init(PIP_Obj *pipe);
+extern Void PIP_alloc(PIP_Obj *pipe);
+extern Void PIP_put(PIP_Obj *pipe);
+extern Void PIP_get(PIP_Obj *pipe);
+extern Void PIP_free(PIP_Obj *pipe);
+
+#endif /* PIP_ */
@@ -0,0 +1,41 @@
+/*
+ *  ======== std.h ========
+ *  Host (Linux) stand-in for the DSP/BIOS standard types header.
+ *  Only the types and qualifiers used by the Exercice* sources are
+ *  provided.
+ */
+#ifndef STD_
+#define STD_
+
+typedef void            Void;
+typedef char            Char;
+typedef short           Short;
+typedef int             Int;
+typedef unsigned int    Uns;
+typedef long            LgInt;
+typedef unsigned long   LgUns;
+typedef float           Float;
+typedef double          Double;
+typedef int             Bool;
+typedef void            *Ptr;
+typedef char            *String;
+typedef long            Arg;    /* must be able to hold a pointer */
+typedef Int             (*Fxn)();
+
+#ifndef TRUE
+#define TRUE            1
+#define FALSE           0
+#endif
+
+#ifndef NULL
+#define NULL            0
+#endif
+
+/* memory space qualifiers of the TI compiler have no meaning on the host */
+#define far
+#define near
+
+#define ArgToPtr(A)     ((Ptr)(A))
+#define ArgToInt(A)     ((Int)(A))
+
+#endif /* STD_ */
@@ -0,0 +1,24 @@
+/*
+ *  ======== sts.h ========
+ *  Host stand-in for the DSP/BIOS STS module.
+ */
+#ifndef STS_
+#define STS_
+
+#include <std.h>
+
+typedef struct STS_Obj {
+    LgInt       prev;           /* value saved by STS_set() */
+    LgInt       num;            /* number of values accumulated */
+    LgInt       acc;            /* sum of the values */
+    LgInt       max;            /* largest value */
+} STS_Obj;
+
+#define STS_OBJ         { 0, 0, 0, -0x7fffffffL }
+
+extern Void STS_add(STS_Obj *sts, LgInt value);
+extern Void STS_delta(STS_Obj *sts, LgInt value);
+extern Void STS_reset(STS_Obj *sts);
+extern Void STS_set(STS_Obj *sts, LgInt value);
+
+#endif /* STS_ */
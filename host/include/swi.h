@@ -0,0 +1,36 @@
+/*
+ *  ======== swi.h ========
+ *  Host stand-in for the DSP/BIOS SWI module.  A posted SWI does not
+ *  run immediately: it is run by SWI_run(), which the host scheduler
+ *  calls after each simulated codec interrupt, the way a real SWI runs
+ *  once the HWI that posted it returns.
+ */
+#ifndef SWI_
+#define SWI_
+
+#include <std.h>
+
+typedef struct SWI_Obj {
+    Fxn         fxn;            /* SWI function */
+    Arg         arg0;
+    Arg         arg1;
+    Int         pri;
+    Uns         initkey;        /* mailbox value restored before each run */
+    Uns         mailbox;
+    Bool        posted;
+    LgUns       runs;           /* number of times fxn has been run */
+    LgUns       busy;           /* CLK_gethtime() counts spent in fxn */
+    LgUns       maxTime;        /* longest single run of fxn */
+} SWI_Obj;
+
+#define SWI_OBJ(fxn, pri, mailbox) \
+    { (Fxn)(fxn), 0, 0, (pri), (mailbox), (mailbox), FALSE, 0, 0, 0 }
+
+extern Void SWI_andn(SWI_Obj *swi, Uns mask);
+extern Void SWI_andnHook(Arg swi, Arg mask);
+extern Void SWI_or(SWI_Obj *swi, Uns mask);
+extern Void SWI_post(SWI_Obj *swi);
+extern Uns SWI_getmbox(Void);
+extern Int SWI_run(Void);
+
+#endif /* SWI_ */
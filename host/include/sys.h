@@ -0,0 +1,17 @@
+/*
+ *  ======== sys.h ========
+ *  Host stand-in for the DSP/BIOS SYS module.
+ */
+#ifndef SYS_
+#define SYS_
+
+#include <std.h>
+
+#define SYS_OK          0
+#define SYS_EALLOC      1
+#define SYS_EINVAL      5
+
+extern Void SYS_abort(String fmt, ...);
+extern Void SYS_printf(String fmt, ...);
+
+#endif /* SYS_ */
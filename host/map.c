@@ -0,0 +1,288 @@
+/*
+ *  ======== map.c ========
+ *  Memory-mapped 16-bit interleaved stereo files (see map.h).
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "map.h"
+#include "wav.h"
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ  MADV_WILLNEED
+#define MADV_POPULATE_WRITE MADV_WILLNEED
+#endif
+
+/*
+ *  ======== prefault ========
+ *  Map the pages of the chunk starting at 'offset' in one call rather
+ *  than on one page fault each.
+ */
+static Void prefault(MAP_Obj *map, LgUns offset)
+{
+    LgUns n = map->length - offset < MAP_CHUNK ? map->length - offset : MAP_CHUNK;
+
+    if (offset < map->length) {
+        madvise(map->base + offset, n, map->writing ? MADV_POPULATE_WRITE : MADV_POPULATE_READ);
+    }
+}
+
+/*
+ *  ======== flush ========
+ *  Write the whole blocks of the staging buffer that precede file
+ *  offset 'end' and move the rest to its start.
+ */
+static Bool flush(MAP_Obj *map, LgUns end)
+{
+    LgUns n = (end - map->done) & ~(LgUns)(MAP_BLOCK - 1);
+
+    if (n > 0) {
+        if (pwrite(map->fd, map->base, n, map->done) != (ssize_t)n) {
+            return (FALSE);
+        }
+        memmove(map->base, map->base + n, end - map->done - n);
+        map->done += n;
+    }
+
+    return (TRUE);
+}
+
+static Bool isRaw(const char *path)
+{
+    size_t n = strlen(path);
+
+    return (n > 4 && strcmp(path + n - 4, ".raw") == 0);
+}
+
+/*
+ *  ======== MAP_openRead ========
+ *  Map a stereo file.  Mono WAV files are refused: their samples cannot
+ *  be handed to echo() without converting them.
+ */
+Bool MAP_openRead(MAP_Obj *map, const char *path)
+{
+    struct stat st;
+    WAV_Obj wav;
+
+    memset(map, 0, sizeof(*map));
+    if (isRaw(path)) {
+        map->rate = MAP_RAWRATE;
+    }
+    else {
+        /* wav.c walks the chunks, the data is then used in place */
+        if (!WAV_openRead(&wav, path)) {
+            return (FALSE);
+        }
+        WAV_close(&wav);
+        if (wav.channels != 2 || (wav.dataOffset & 1) != 0) {
+            return (FALSE);
+        }
+        map->rate = wav.rate;
+        map->dataOffset = wav.dataOffset;
+        map->frames = wav.frames;
+    }
+
+    if ((map->fd = open(path, O_RDONLY)) < 0) {
+        return (FALSE);
+    }
+    if (fstat(map->fd, &st) != 0 || (LgUns)st.st_size <= map->dataOffset) {
+        goto fail;
+    }
+    if (isRaw(path) || map->frames > (st.st_size - map->dataOffset) / 4) {
+        map->frames = (st.st_size - map->dataOffset) / 4;
+    }
+    map->length = st.st_size;
+    map->base = mmap(NULL, map->length, PROT_READ, MAP_PRIVATE, map->fd, 0);
+    if (map->base == MAP_FAILED) {
+        goto fail;
+    }
+    madvise(map->base, map->length, MADV_SEQUENTIAL);
+    prefault(map, 0);
+    prefault(map, MAP_CHUNK);
+
+    return (TRUE);
+
+fail:
+    close(map->fd);
+    return (FALSE);
+}
+
+/*
+ *  ======== MAP_openWrite ========
+ *  Create a stereo file with room for 'frames' sample frames, mapped or
+ *  as an O_DIRECT sink.  MAP_close() gives it its final length.
+ */
+Bool MAP_openWrite(MAP_Obj *map, const char *path, LgUns rate, LgUns frames, Bool direct)
+{
+    void *buf;
+
+    memset(map, 0, sizeof(*map));
+    map->writing = TRUE;
+    map->direct = direct;
+    map->rate = rate;
+    map->frames = frames;
+    map->dataOffset = isRaw(path) ? 0 : WAV_HEADERSIZE;
+    map->length = map->dataOffset + frames * 4;
+
+    if ((map->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | (direct ? O_DIRECT : 0), 0666)) < 0) {
+        return (FALSE);
+    }
+    /* allocate the blocks now rather than on each page fault or write */
+    if (posix_fallocate(map->fd, 0, map->length) != 0 && ftruncate(map->fd, map->length) != 0) {
+        goto fail;
+    }
+    if (direct) {
+        if (posix_memalign(&buf, MAP_BLOCK, MAP_SINKSIZE) != 0) {
+            goto fail;
+        }
+        memset(buf, 0, MAP_SINKSIZE);
+        map->base = buf;
+        return (TRUE);
+    }
+    map->base = mmap(NULL, map->length, PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+    if (map->base == MAP_FAILED) {
+        goto fail;
+    }
+    madvise(map->base, map->length, MADV_SEQUENTIAL);
+    prefault(map, 0);
+    prefault(map, MAP_CHUNK);
+
+    return (TRUE);
+
+fail:
+    close(map->fd);
+    unlink(path);
+    map->base = NULL;
+    return (FALSE);
+}
+
+/*
+ *  ======== MAP_openMemory ========
+ *  Use 'frames' sample frames at 'buf' like a mapped file, for input or
+ *  output.
+ */
+Void MAP_openMemory(MAP_Obj *map, Short *buf, LgUns frames, LgUns rate)
+{
+    memset(map, 0, sizeof(*map));
+    map->fd = -1;
+    map->base = (unsigned char *)buf;
+    map->length = frames * 4;
+    map->frames = frames;
+    map->rate = rate;
+}
+
+/*
+ *  ======== MAP_frame ========
+ *  Address of 'frames' sample frames starting at frame 'first', NULL
+ *  past the end.  For the O_DIRECT sink the frames before 'first' must
+ *  have been written: they may be sent to the disk to make room.
+ */
+Short *MAP_frame(MAP_Obj *map, LgUns first, LgUns frames)
+{
+    LgUns start = map->dataOffset + first * 4;
+
+    if (first + frames > map->frames) {
+        return (NULL);
+    }
+    if (!map->direct) {
+        return ((Short *)(map->base + start));
+    }
+    if (start + frames * 4 > map->done + MAP_SINKSIZE && !flush(map, start)) {
+        return (NULL);
+    }
+
+    return ((Short *)(map->base + start - map->done));
+}
+
+/*
+ *  ======== MAP_skip ========
+ *  A run on part of a mapped file begins at sample frame 'frames': map
+ *  the chunks from there rather than from the start.
+ */
+Void MAP_skip(MAP_Obj *map, LgUns frames)
+{
+    LgUns start = (map->dataOffset + frames * 4) & ~(MAP_CHUNK - 1);
+
+    if (map->fd < 0 || map->direct || start <= map->done) {
+        return;
+    }
+    map->done = start;
+    prefault(map, start);
+    prefault(map, start + MAP_CHUNK);
+}
+
+/*
+ *  ======== MAP_done ========
+ *  The first 'frames' sample frames of a mapped file will not be
+ *  accessed again.  Acts once per MAP_CHUNK: written pages are sent to
+ *  the disk, read pages are dropped, and the pages of the chunk after
+ *  next are mapped.
+ */
+Void MAP_done(MAP_Obj *map, LgUns frames)
+{
+    LgUns end = (map->dataOffset + frames * 4) & ~(MAP_CHUNK - 1);
+
+    if (map->fd < 0 || map->direct || end <= map->done) {
+        return;
+    }
+    if (map->writing) {
+        sync_file_range(map->fd, map->done, end - map->done, SYNC_FILE_RANGE_WRITE);
+    }
+    else {
+        madvise(map->base + map->done, end - map->done, MADV_DONTNEED);
+    }
+    map->done = end;
+    prefault(map, end + MAP_CHUNK);
+}
+
+/*
+ *  ======== MAP_close ========
+ *  Unmap the file.  An output file is cut to 'frames' sample frames and
+ *  gets its WAV header.
+ */
+Bool MAP_close(MAP_Obj *map, LgUns frames)
+{
+    unsigned char hdr[WAV_HEADERSIZE];
+    LgUns end;
+    Bool ok = TRUE;
+
+    if (map->base == NULL) {
+        return (FALSE);
+    }
+    if (map->fd < 0) {
+        map->base = NULL;
+        return (TRUE);
+    }
+    if (frames > map->frames) {
+        frames = map->frames;
+    }
+    end = map->dataOffset + frames * 4;
+    if (map->direct) {
+        /* whole blocks, then the tail and the header through the page cache */
+        ok = flush(map, end) &&
+            fcntl(map->fd, F_SETFL, fcntl(map->fd, F_GETFL) & ~O_DIRECT) == 0 &&
+            pwrite(map->fd, map->base, end - map->done, map->done) == (ssize_t)(end - map->done);
+        if (ok && map->dataOffset > 0) {
+            WAV_header(hdr, map->rate, frames);
+            ok = pwrite(map->fd, hdr, WAV_HEADERSIZE, 0) == WAV_HEADERSIZE;
+        }
+        free(map->base);
+    }
+    else {
+        if (map->writing && map->dataOffset > 0) {
+            WAV_header(map->base, map->rate, frames);
+        }
+        munmap(map->base, map->length);
+    }
+    if (map->writing) {
+        ok = ftruncate(map->fd, end) == 0 && ok;
+    }
+    close(map->fd);
+    map->base = NULL;
+
+    return (ok);
+}
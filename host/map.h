@@ -0,0 +1,51 @@
+/*
+ *  ======== map.h ========
+ *  Memory-mapped 16-bit interleaved stereo files, for offline runs on
+ *  recordings of any size.  A file is either a WAV file or, when its
+ *  name ends in ".raw", bare samples at MAP_RAWRATE.
+ *
+ *  The input is mapped read-only and MAP_frame() returns pointers
+ *  straight into the mapping, which the codec hands to echo() as its
+ *  receive frames.  The output is either mapped shared at its final
+ *  size, so that echo() writes its frames in place, or, with 'direct',
+ *  a sink opened with O_DIRECT: echo() then writes into a staging
+ *  buffer of MAP_SINKSIZE bytes that stays in cache, and the complete
+ *  part of it goes to the disk without a copy into the page cache.
+ *
+ *  MAP_done() tells the kernel which part of a mapped file is finished,
+ *  so that written pages go to disk and read pages leave the page cache
+ *  while the run goes on, and maps the next chunk ahead.  A run on part
+ *  of a file starts with MAP_skip().  MAP_openMemory() wraps a buffer
+ *  in memory, on which these calls do nothing.
+ */
+#ifndef MAP_
+#define MAP_
+
+#include <std.h>
+
+#define MAP_RAWRATE     44100
+#define MAP_CHUNK       (64L << 20)     /* bytes between two MAP_done() calls that act */
+#define MAP_SINKSIZE    (1L << 20)      /* staging buffer of the O_DIRECT sink */
+#define MAP_BLOCK       4096            /* O_DIRECT alignment */
+
+typedef struct MAP_Obj {
+    Int         fd;             /* -1 for a buffer in memory */
+    Bool        writing;
+    Bool        direct;         /* O_DIRECT sink rather than a mapping */
+    unsigned char *base;        /* mapping of the whole file, or staging buffer */
+    LgUns       length;         /* bytes of the file */
+    LgUns       dataOffset;     /* file offset of the first sample */
+    LgUns       frames;         /* stereo sample frames */
+    LgUns       rate;           /* sampling frequency in Hz */
+    LgUns       done;           /* bytes already handed to the kernel */
+} MAP_Obj;
+
+extern Bool MAP_openRead(MAP_Obj *map, const char *path);
+extern Bool MAP_openWrite(MAP_Obj *map, const char *path, LgUns rate, LgUns frames, Bool direct);
+extern Void MAP_openMemory(MAP_Obj *map, Short *buf, LgUns frames, LgUns rate);
+extern Short *MAP_frame(MAP_Obj *map, LgUns first, LgUns frames);
+extern Void MAP_skip(MAP_Obj *map, LgUns frames);
+extern Void MAP_done(MAP_Obj *map, LgUns frames);
+extern Bool MAP_close(MAP_Obj *map, LgUns frames);
+
+#endif /* MAP_ */
@@ -0,0 +1,349 @@
+/*
+ *  ======== render_main.c ========
+ *  Offline render of one long file on all the cores.  The file is cut
+ *  into one chunk per job and each job runs the application on its
+ *  chunk through the mapped codec (CODEC_setRange), in a process of its
+ *  own so that it gets its own copy of the globals of echo.c.  A job
+ *  starts a warm-up before its chunk, whose output is dropped, to
+ *  rebuild the state serial processing would have there.
+ *
+ *  The warm-up comes from the impulse response of the application with
+ *  the given sliders, measured first in a separate process: it is the
+ *  shortest whole number of frames after which the remaining sum of |h|
+ *  (in LSB, for a full-scale input) is below the tolerance.  For an
+ *  effect that is linear up to its final rounding, the chunked output
+ *  then differs from the serial one by at most the tolerance plus one
+ *  LSB.
+ *
+ *  The impulse is IMPULSE, 20 dB below full scale, so that an effect
+ *  with gain does not clip it, and the response is scaled back to full
+ *  scale.  The 16-bit output only resolves the response down to half an
+ *  LSB of the measurement, and a slowly decaying tail that rounds to 0
+ *  still adds up to several LSB: that part is extrapolated from the
+ *  decay of the envelope over its last resolved stretch, from 16 LSB to
+ *  half an LSB, geometric as the tail of any recursive filter is.  An
+ *  FIR effect (Exercice1) gets about its length, a recursive one
+ *  (Exercice2 biquads, Exercice3/4 feedback delay) the time its tail
+ *  takes to decay.  An effect whose response depends on when the
+ *  impulse comes (the LFO of Exercice5 with a non-zero sweep) or that
+ *  does not decay within MAXRESPONSE cannot be warmed up and is
+ *  rendered in one chunk.
+ *
+ *  usage: renderN [-q] [-v] [-j jobs] [-e lsb] [-b samples] [-g symbol=value]... in out
+ *
+ *      -j  number of jobs (the number of cores by default)
+ *      -e  tolerance in LSB (1 by default, at least 1)
+ *      -v  also render serially and report the largest difference
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <std.h>
+#include <log.h>
+#include <swi.h>
+
+#include "bios_host.h"
+#include "blk.h"
+
+#define MAXSLIDERS  16
+#define MAXJOBS     256
+#define MAXRESPONSE (30 * 44100)    /* sample frames of impulse response measured */
+#define IMPULSE     3277            /* -20 dBFS */
+#define SHIFT       1009            /* frames between the two impulses compared */
+
+static char *sliders[MAXSLIDERS];
+static Int nsliders = 0;
+
+/*
+ *  ======== render ========
+ *  Start the application like DSP/BIOS does and run it on 'count'
+ *  frames of 'in' from 'first', after 'warm' frames of warm-up.
+ */
+static Bool render(MAP_Obj *in, MAP_Obj *out, LgUns first, LgUns count, LgUns warm)
+{
+    Int i;
+
+    CODEC_setMapped(in, out);
+    CODEC_setRange(first, count, warm);
+    BIOS_init();
+    host_appMain();
+    for (i = 0; i < nsliders; i++) {
+        if (!GEL_set(sliders[i])) {
+            return (FALSE);
+        }
+    }
+    while (CODEC_tick()) {
+        SWI_run();
+    }
+
+    return (TRUE);
+}
+
+/*
+ *  ======== job ========
+ *  Run render() in a child process, returns its pid.
+ */
+static pid_t job(MAP_Obj *in, MAP_Obj *out, LgUns first, LgUns count, LgUns warm)
+{
+    pid_t pid = fork();
+
+    if (pid == 0) {
+        _exit(render(in, out, first, count, warm) ? 0 : 1);
+    }
+
+    return (pid);
+}
+
+static Bool finish(pid_t pid)
+{
+    Int status;
+
+    return (pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+        WEXITSTATUS(status) == 0);
+}
+
+/*
+ *  ======== shared ========
+ *  Memory the child processes write into and the parent reads.
+ */
+static Short *shared(LgUns frames)
+{
+    Short *buf = mmap(NULL, frames * 4, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    return (buf != MAP_FAILED ? buf : NULL);
+}
+
+/*
+ *  ======== response ========
+ *  Response of the application to an impulse of IMPULSE at frame
+ *  'delay', into 'resp' (MAXRESPONSE frames).
+ */
+static Bool response(LgUns delay, Short *resp, LgUns rate)
+{
+    MAP_Obj in, out;
+    Short *impulse;
+    Bool ok;
+
+    if (delay >= MAXRESPONSE || (impulse = calloc(MAXRESPONSE, 4)) == NULL) {
+        return (FALSE);
+    }
+    impulse[2 * delay] = impulse[2 * delay + 1] = IMPULSE;
+    MAP_openMemory(&in, impulse, MAXRESPONSE, rate);
+    MAP_openMemory(&out, resp, MAXRESPONSE, rate);
+    ok = finish(job(&in, &out, 0, MAXRESPONSE, 0));
+    free(impulse);
+
+    return (ok);
+}
+
+/*
+ *  ======== warmUp ========
+ *  Frames of warm-up that bring the error below 'tol' LSB, -1 if the
+ *  application cannot be warmed up.
+ */
+static LgInt warmUp(Int tol, Uns nframes, LgUns rate)
+{
+    Short *r0 = shared(MAXRESPONSE), *r1 = shared(MAXRESPONSE);
+    LgUns t, last = 0, resolved = 0, w, d = SHIFT * nframes;
+    LgInt warm = -1;
+    Int m, peak = 0;
+    Double scale = 32767.0 / IMPULSE, decay, tail;
+
+    if (r0 == NULL || r1 == NULL || !response(0, r0, rate) || !response(d, r1, rate)) {
+        goto done;
+    }
+
+    /*
+     *  an impulse d samples later must give the same response d samples
+     *  later; d is a prime number of frames, so that it is unlikely to be
+     *  a multiple of the period of an LFO
+     */
+    for (t = 0; t + d < MAXRESPONSE; t++) {
+        if ((abs(r0[2 * t] - r1[2 * (t + d)]) > tol / scale) ||
+            (abs(r0[2 * t + 1] - r1[2 * (t + d) + 1]) > tol / scale)) {
+            goto done;
+        }
+    }
+
+    /*
+     *  last sample of the worse channel that is not 0, and last one from
+     *  where its envelope falls from 16 LSB (or its peak, if lower) to
+     *  below half an LSB after 'last'
+     */
+    for (t = 0; t < MAXRESPONSE; t++) {
+        m = abs(r0[2 * t]) > abs(r0[2 * t + 1]) ? abs(r0[2 * t]) : abs(r0[2 * t + 1]);
+        if (m != 0) {
+            last = t + 1;
+        }
+        if (m >= 16 || m > peak) {
+            resolved = t;
+            peak = m > peak ? m : peak;
+        }
+    }
+    if (last == 0) {
+        warm = 0;
+        goto done;
+    }
+
+    /* below resolution from 'last' on: sum(0.5 decay^k, k >= 0) */
+    decay = pow(0.5 / (peak < 16 ? peak : 16), 1.0 / (last - resolved));
+    tail = 0.5 * scale / (1.0 - decay);
+    if (tail > tol) {
+        w = last + (LgUns)ceil(log(tol / tail) / log(decay));
+    }
+    else {
+        /* shortest w with sum(|h[t]|, t >= w) <= tol */
+        for (w = last; w > 0; w--) {
+            m = abs(r0[2 * (w - 1)]) > abs(r0[2 * (w - 1) + 1]) ? abs(r0[2 * (w - 1)]) : abs(r0[2 * (w - 1) + 1]);
+            if ((tail += m * scale) > tol) {
+                break;
+            }
+        }
+    }
+    if (w <= MAXRESPONSE / 2) {
+        warm = (w + nframes - 1) / nframes * nframes;
+    }
+
+done:
+    if (r0 != NULL) {
+        munmap(r0, MAXRESPONSE * 4);
+    }
+    if (r1 != NULL) {
+        munmap(r1, MAXRESPONSE * 4);
+    }
+    return (warm);
+}
+
+/*
+ *  ======== verify ========
+ *  Largest difference in LSB between 'out' and a serial render of
+ *  'in', -1 if the serial render failed.
+ */
+static Int verify(MAP_Obj *in, MAP_Obj *out)
+{
+    Short *serial = shared(out->frames);
+    const Short *chunked = MAP_frame(out, 0, in->frames);
+    MAP_Obj ref;
+    LgUns i;
+    Int d, max = -1;
+
+    if (serial == NULL) {
+        return (-1);
+    }
+    MAP_openMemory(&ref, serial, out->frames, in->rate);
+    if (finish(job(in, &ref, 0, in->frames, 0))) {
+        for (max = 0, i = 0; i < 2 * in->frames; i++) {
+            if ((d = abs(serial[i] - chunked[i])) > max) {
+                max = d;
+            }
+        }
+    }
+    munmap(serial, out->frames * 4);
+
+    return (max);
+}
+
+static Void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-q] [-v] [-j jobs] [-e lsb] [-b samples] [-g symbol=value]... in out\n",
+        prog);
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *prog = strrchr(argv[0], '/') != NULL ? strrchr(argv[0], '/') + 1 : argv[0];
+    pid_t pids[MAXJOBS];
+    MAP_Obj in, out;
+    Bool check = FALSE, ok = TRUE;
+    Int jobs = sysconf(_SC_NPROCESSORS_ONLN), tol = 1, j, c;
+    LgUns n, chunk, first, processed = 0;
+    LgInt warm;
+    Double t0, elapsed;
+
+    while ((c = getopt(argc, argv, "qvj:e:b:g:")) != -1) {
+        switch (c) {
+            case 'q':
+                LOG_quiet = TRUE;
+                break;
+            case 'v':
+                check = TRUE;
+                break;
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+            case 'e':
+                tol = atoi(optarg);
+                break;
+            case 'b':
+                BLK_config.size = atoi(optarg);
+                break;
+            case 'g':
+                if (nsliders == MAXSLIDERS) {
+                    usage(prog);
+                }
+                sliders[nsliders++] = optarg;
+                break;
+            default:
+                usage(prog);
+        }
+    }
+    if (argc - optind != 2 || jobs < 1 || jobs > MAXJOBS || tol < 1 || !BLK_check(&BLK_config)) {
+        usage(prog);
+    }
+    n = BLK_config.size / 2;
+    if (!MAP_openRead(&in, argv[optind])) {
+        fprintf(stderr, "%s: cannot map %s (16-bit stereo WAV or .raw expected)\n", prog, argv[optind]);
+        return (1);
+    }
+    if (!MAP_openWrite(&out, argv[optind + 1], in.rate, (in.frames + n - 1) / n * n, FALSE)) {
+        fprintf(stderr, "%s: cannot create %s\n", prog, argv[optind + 1]);
+        return (1);
+    }
+
+    if ((warm = warmUp(tol, n, in.rate)) < 0) {
+        fprintf(stderr, "%s: the response depends on time or does not decay, rendering in one chunk\n", prog);
+        jobs = 1;
+        warm = 0;
+    }
+    chunk = ((in.frames + jobs - 1) / jobs + n - 1) / n * n;
+
+    t0 = BIOS_now();
+    for (j = 0, first = 0; first < in.frames; j++, first += chunk) {
+        pids[j] = job(&in, &out, first, chunk, first < (LgUns)warm ? first : (LgUns)warm);
+        processed += (first + chunk < in.frames ? chunk : in.frames - first) +
+            (first < (LgUns)warm ? first : (LgUns)warm);
+    }
+    jobs = j;
+    for (j = 0; j < jobs; j++) {
+        ok = finish(pids[j]) && ok;
+    }
+    elapsed = BIOS_now() - t0;
+    if (!ok) {
+        fprintf(stderr, "%s: a job failed\n", prog);
+        return (1);
+    }
+
+    fprintf(stderr, "%s: %lu samples (%.1f s) in %.3f s with %d jobs: %.3g samples/s, %.0fx real time\n",
+        prog, in.frames, (Double)in.frames / in.rate, elapsed, jobs, in.frames / elapsed,
+        in.frames / (Double)in.rate / elapsed);
+    fprintf(stderr, "%s: warm-up of %ld samples (%.3f s) per chunk, %.1f%% more processing, "
+        "error bound %d LSB\n", prog, warm, (Double)warm / in.rate,
+        (processed - in.frames) * 100.0 / in.frames, jobs > 1 ? tol + 1 : 0);
+    if (check) {
+        fprintf(stderr, "%s: largest difference with the serial render: %d LSB\n", prog, verify(&in, &out));
+    }
+
+    MAP_close(&in, 0);
+    if (!MAP_close(&out, in.frames)) {
+        fprintf(stderr, "%s: cannot write %s\n", prog, argv[optind + 1]);
+        return (1);
+    }
+
+    return (0);
+}
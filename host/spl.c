@@ -0,0 +1,304 @@
+/*
+ *  ======== spl.c ========
+ *  Delay line in a memory-mapped file, paged by a worker thread (see
+ *  spl.h).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "spl.h"
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ  MADV_WILLNEED
+#define MADV_POPULATE_WRITE MADV_WILLNEED
+#endif
+
+#define CHUNKSAMPLES    (SPL_CHUNK / (LgUns)sizeof(Float))
+#define HOTCHUNKS       (SPL_HOT / SPL_CHUNK)
+
+/*
+ *  ======== chunkOf ========
+ *  Chunk of the file that holds the sample 'delay' samples before the
+ *  write head 'written'.
+ */
+static inline LgUns chunkOf(SPL_Obj *spl, LgUns written, LgUns delay)
+{
+    return (((written - delay) & (spl->length - 1)) / CHUNKSAMPLES);
+}
+
+/*
+ *  ======== populate ========
+ *  Map in the pages of chunk 'c', reading them from the file if they
+ *  are not in the page cache.
+ */
+static Void populate(SPL_Obj *spl, LgUns c, Int advice)
+{
+    madvise(spl->base + c * CHUNKSAMPLES, SPL_CHUNK, advice);
+}
+
+/*
+ *  ======== needed ========
+ *  Chunk 'c' is in the hot window behind 'written', or is the one after
+ *  it, or a tap reads it or the next one.
+ */
+static Bool needed(SPL_Obj *spl, LgUns c, LgUns written)
+{
+    LgUns numChunks = spl->length / CHUNKSAMPLES, head = chunkOf(spl, written, 0), tc;
+    Int t;
+
+    if ((head + numChunks - c) % numChunks <= HOTCHUNKS || c == (head + 1) % numChunks) {
+        return (TRUE);
+    }
+    for (t = 0; t < spl->numTaps; t++) {
+        tc = chunkOf(spl, written, spl->delay[t]);
+        if (c == tc || c == (tc + 1) % numChunks) {
+            return (TRUE);
+        }
+    }
+
+    return (FALSE);
+}
+
+/*
+ *  ======== release ========
+ *  Write chunk 'c' back to the file and drop it from memory, unless it
+ *  is still needed.
+ */
+static Void release(SPL_Obj *spl, LgUns c, LgUns written)
+{
+    if (needed(spl, c, written)) {
+        return;
+    }
+    sync_file_range(spl->fd, c * SPL_CHUNK, SPL_CHUNK,
+        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    madvise(spl->base + c * CHUNKSAMPLES, SPL_CHUNK, MADV_DONTNEED);
+    posix_fadvise(spl->fd, c * SPL_CHUNK, SPL_CHUNK, POSIX_FADV_DONTNEED);
+}
+
+/*
+ *  ======== work ========
+ *  The worker thread: after each block written, page in what the write
+ *  head and the taps reach next, and page out every chunk they have
+ *  left since it last ran, however many blocks that was.
+ */
+static Void *work(Void *arg)
+{
+    SPL_Obj *spl = arg;
+    LgUns numChunks = spl->length / CHUNKSAMPLES, written, head, lastHead = 0, tc;
+    LgUns lastTap[SPL_MAXTAPS];
+    Int t;
+
+    for (t = 0; t < SPL_MAXTAPS; t++) {
+        lastTap[t] = numChunks;
+    }
+    for (;;) {
+        while (sem_wait(&spl->wake) != 0 && errno == EINTR) {
+        }
+        if (spl->quit) {
+            break;
+        }
+        written = spl->written;
+
+        /* SPL_open() paged in the first two chunks */
+        head = chunkOf(spl, written, 0);
+        if (head != lastHead) {
+            populate(spl, (head + 1) % numChunks, MADV_POPULATE_WRITE);
+            while (lastHead != head) {
+                lastHead = (lastHead + 1) % numChunks;
+                release(spl, (lastHead + numChunks - HOTCHUNKS - 1) % numChunks, written);
+            }
+        }
+        for (t = 0; t < spl->numTaps; t++) {
+            /* a tap moves once the chunks of its new delay are in */
+            if (spl->pending[t] != spl->delay[t]) {
+                tc = chunkOf(spl, written, spl->pending[t]);
+                populate(spl, tc, MADV_POPULATE_READ);
+                populate(spl, (tc + 1) % numChunks, MADV_POPULATE_READ);
+                __sync_synchronize();
+                spl->delay[t] = spl->pending[t];
+                if (lastTap[t] < numChunks) {
+                    release(spl, lastTap[t], written);
+                    release(spl, (lastTap[t] + 1) % numChunks, written);
+                }
+                lastTap[t] = tc;
+            }
+            if (spl->delay[t] == 0) {
+                continue;
+            }
+            tc = chunkOf(spl, written, spl->delay[t]);
+            if (tc != lastTap[t]) {
+                populate(spl, tc, MADV_POPULATE_READ);
+                populate(spl, (tc + 1) % numChunks, MADV_POPULATE_READ);
+                while (lastTap[t] != tc) {
+                    release(spl, lastTap[t], written);
+                    lastTap[t] = (lastTap[t] + 1) % numChunks;
+                }
+            }
+        }
+    }
+
+    return (NULL);
+}
+
+/*
+ *  ======== SPL_open ========
+ *  Create a line for delays up to 'maxDelay' samples in the file 'path'
+ *  (NULL for a temporary file), filled with silence, and start its
+ *  worker.  A temporary file goes to $TMPDIR, or to /var/tmp rather than
+ *  /tmp, which is often a tmpfs: the line would then stay in RAM or swap.
+ */
+Bool SPL_open(SPL_Obj *spl, const char *path, LgUns maxDelay)
+{
+    const char *dir = getenv("TMPDIR");
+    char name[PATH_MAX];
+    LgUns length = 4 * CHUNKSAMPLES;
+
+    memset(spl, 0, sizeof(*spl));
+    while (length < maxDelay + 2 * CHUNKSAMPLES) {
+        length <<= 1;
+    }
+    spl->length = length;
+    spl->maxDelay = maxDelay;
+
+    if (path != NULL) {
+        spl->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    }
+    else {
+        snprintf(name, sizeof(name), "%s/splXXXXXX", dir != NULL && dir[0] != '\0' ? dir : "/var/tmp");
+        if ((spl->fd = mkstemp(name)) >= 0) {
+            unlink(name);
+        }
+    }
+    if (spl->fd < 0) {
+        return (FALSE);
+    }
+    /* the blocks now rather than at each write-back; zeros are silence */
+    if (posix_fallocate(spl->fd, 0, length * sizeof(Float)) != 0 &&
+        ftruncate(spl->fd, length * sizeof(Float)) != 0) {
+        goto fail;
+    }
+    spl->base = mmap(NULL, length * sizeof(Float), PROT_READ | PROT_WRITE, MAP_SHARED, spl->fd, 0);
+    if (spl->base == MAP_FAILED) {
+        goto fail;
+    }
+    /* the worker reads ahead: the kernel's own readahead (megabytes) would fill RAM with chunks no tap is near */
+    madvise(spl->base, length * sizeof(Float), MADV_RANDOM);
+    posix_fadvise(spl->fd, 0, length * sizeof(Float), POSIX_FADV_RANDOM);
+    populate(spl, 0, MADV_POPULATE_WRITE);
+    populate(spl, 1, MADV_POPULATE_WRITE);
+
+    if (sem_init(&spl->wake, 0, 0) != 0) {
+        munmap(spl->base, length * sizeof(Float));
+        goto fail;
+    }
+    if (pthread_create(&spl->worker, NULL, work, spl) != 0) {
+        sem_destroy(&spl->wake);
+        munmap(spl->base, length * sizeof(Float));
+        goto fail;
+    }
+
+    return (TRUE);
+
+fail:
+    close(spl->fd);
+    if (path != NULL) {
+        unlink(path);
+    }
+    spl->base = NULL;
+    return (FALSE);
+}
+
+/*
+ *  ======== SPL_setTap ========
+ *  Tap 'tap' is to read 'delay' samples back (1 to the maximum delay).
+ *  Nothing is read from the file here: the worker moves the tap once
+ *  the chunks of the new position are paged in, so its first reads do
+ *  not fault, and the caller never waits for the disk.
+ */
+Bool SPL_setTap(SPL_Obj *spl, Int tap, LgUns delay)
+{
+    if (tap < 0 || tap >= SPL_MAXTAPS || delay < 1 || delay > spl->maxDelay) {
+        return (FALSE);
+    }
+    spl->pending[tap] = delay;
+    if (tap >= spl->numTaps) {
+        spl->numTaps = tap + 1;
+    }
+    sem_post(&spl->wake);
+
+    return (TRUE);
+}
+
+/*
+ *  ======== SPL_tapReady ========
+ *  Tap 'tap' reads from the delay last given to SPL_setTap().
+ */
+Bool SPL_tapReady(SPL_Obj *spl, Int tap)
+{
+    return (spl->delay[tap] == spl->pending[tap]);
+}
+
+/*
+ *  ======== SPL_write ========
+ *  Append the 'n' samples of 'x' and wake the worker.
+ */
+Void SPL_write(SPL_Obj *spl, const Float *x, Int n)
+{
+    LgUns pos = spl->written & (spl->length - 1), first = spl->length - pos;
+
+    if (n <= first) {
+        memcpy(spl->base + pos, x, n * sizeof(Float));
+    }
+    else {
+        memcpy(spl->base + pos, x, first * sizeof(Float));
+        memcpy(spl->base, x + first, (n - first) * sizeof(Float));
+    }
+    spl->written += n;
+    sem_post(&spl->wake);
+}
+
+/*
+ *  ======== SPL_read ========
+ *  y[i] = x(i - delay) for the delay of 'tap', i = 0..n-1 (n at most the
+ *  delay), as DLY_read(); silence before the tap's first move.
+ */
+Void SPL_read(SPL_Obj *spl, Int tap, Float *y, Int n)
+{
+    LgUns delay = spl->delay[tap], start = (spl->written - delay) & (spl->length - 1), first = spl->length - start;
+
+    if (delay == 0) {
+        memset(y, 0, n * sizeof(Float));
+        return;
+    }
+    if (n <= first) {
+        memcpy(y, spl->base + start, n * sizeof(Float));
+    }
+    else {
+        memcpy(y, spl->base + start, first * sizeof(Float));
+        memcpy(y + first, spl->base, (n - first) * sizeof(Float));
+    }
+}
+
+/*
+ *  ======== SPL_close ========
+ *  Stop the worker and unmap the file.
+ */
+Void SPL_close(SPL_Obj *spl)
+{
+    if (spl->base == NULL) {
+        return;
+    }
+    spl->quit = TRUE;
+    sem_post(&spl->wake);
+    pthread_join(spl->worker, NULL);
+    sem_destroy(&spl->wake);
+    munmap(spl->base, spl->length * sizeof(Float));
+    close(spl->fd);
+    spl->base = NULL;
+}
@@ -0,0 +1,69 @@
+/*
+ *  ======== spl.h ========
+ *  Delay line of minutes, for hosts: its samples live in a file mapped
+ *  in memory, and only the parts in use stay in RAM.
+ *
+ *  A line of dly.h is a buffer in memory, sized for its longest delay.
+ *  Here the buffer is a shared mapping of a file (a temporary one in
+ *  $TMPDIR or /var/tmp, deleted at once, unless a path is given), accessed like dly.h with a
+ *  power-of-two mask, in at most two copies per block.  The pages in
+ *  RAM are those of the last SPL_HOT bytes written and, for each tap,
+ *  of the SPL_CHUNK bytes it reads and of the next chunk; the rest is
+ *  written back to the file and dropped from the page cache.
+ *
+ *  None of the paging is done by the audio path: SPL_write() posts a
+ *  semaphore after each block, and a worker thread then
+ *
+ *    - maps in the chunk after the write head (MADV_POPULATE_WRITE), so
+ *      that writing into it does not fault;
+ *    - reads in the chunk after each tap's (MADV_POPULATE_READ, the
+ *      file's readahead), one chunk before the tap needs it;
+ *    - writes back and drops the chunks that have left the hot window
+ *      or that a tap has read past (sync_file_range, MADV_DONTNEED,
+ *      POSIX_FADV_DONTNEED), unless a tap is about to read them.
+ *
+ *  A chunk lasts SPL_CHUNK / 4 samples, 0.37 s of 44.1 kHz stereo: the
+ *  worker has that long to read a chunk before its tap reaches it, and
+ *  only a disk slower than that makes the audio path wait.
+ *
+ *  SPL_setTap() only records a tap's new delay, so it may be called
+ *  from any thread, the audio path included.  The worker pages in the
+ *  chunk the tap will read from and the next one, and only then moves
+ *  the tap there; until then it keeps reading from its old delay, or
+ *  reads silence if it had none.  SPL_tapReady() tells when the move is
+ *  done.
+ */
+#ifndef SPL_
+#define SPL_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <std.h>
+
+#define SPL_MAXTAPS     8
+#define SPL_CHUNK       (256L << 10)    /* bytes read in or dropped at a time */
+#define SPL_HOT         (1L << 20)      /* bytes behind the write head kept in RAM */
+
+typedef struct SPL_Obj {
+    Int         fd;
+    Float       *base;                  /* mapping of the whole file */
+    LgUns       length;                 /* samples, a power of two */
+    LgUns       maxDelay;
+    volatile LgUns written;             /* samples since SPL_open(); the next one goes to written & (length - 1) */
+    volatile LgUns delay[SPL_MAXTAPS];  /* of each tap, samples, 0 before its first move */
+    volatile LgUns pending[SPL_MAXTAPS]; /* asked by SPL_setTap(), taken by the worker */
+    volatile Int numTaps;
+    volatile Bool quit;
+    sem_t       wake;                   /* posted by SPL_write() */
+    pthread_t   worker;
+} SPL_Obj;
+
+extern Bool SPL_open(SPL_Obj *spl, const char *path, LgUns maxDelay);
+extern Bool SPL_setTap(SPL_Obj *spl, Int tap, LgUns delay);
+extern Bool SPL_tapReady(SPL_Obj *spl, Int tap);
+extern Void SPL_write(SPL_Obj *spl, const Float *x, Int n);
+extern Void SPL_read(SPL_Obj *spl, Int tap, Float *y, Int n);
+extern Void SPL_close(SPL_Obj *spl);
+
+#endif /* SPL_ */
@@ -0,0 +1,207 @@
+/*
+ *  ======== wav.c ========
+ *  Minimal streaming reader/writer for 16-bit PCM WAV files.
+ *
+ *  Samples are stored little-endian in the file, which is also the byte
+ *  order of the hosts we build on, so the data chunk is read and written
+ *  directly.
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "wav.h"
+
+#define WAV_FMT_PCM         0x0001
+#define WAV_FMT_EXTENSIBLE  0xFFFE
+
+static Uns getU16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static LgUns getU32(const unsigned char *p)
+{
+    return (LgUns)p[0] | ((LgUns)p[1] << 8) | ((LgUns)p[2] << 16) | ((LgUns)p[3] << 24);
+}
+
+static Void putU16(unsigned char *p, Uns v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static Void putU32(unsigned char *p, LgUns v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+/*
+ *  ======== WAV_openRead ========
+ *  Open a 16-bit PCM mono or stereo file and position it on the first
+ *  sample.
+ */
+Bool WAV_openRead(WAV_Obj *wav, const char *path)
+{
+    unsigned char hdr[16];
+    Bool fmtFound = FALSE;
+    LgUns size;
+
+    memset(wav, 0, sizeof(*wav));
+    if ((wav->fp = fopen(path, "rb")) == NULL) {
+        return (FALSE);
+    }
+    if (fread(hdr, 1, 12, wav->fp) != 12 ||
+        memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        goto fail;
+    }
+
+    /* walk the chunks until the data chunk, checking the format on the way */
+    while (fread(hdr, 1, 8, wav->fp) == 8) {
+        size = getU32(hdr + 4);
+        if (memcmp(hdr, "fmt ", 4) == 0) {
+            if (size < 16 || fread(hdr, 1, 16, wav->fp) != 16) {
+                goto fail;
+            }
+            if ((getU16(hdr) != WAV_FMT_PCM && getU16(hdr) != WAV_FMT_EXTENSIBLE) ||
+                getU16(hdr + 14) != 16) {
+                goto fail;
+            }
+            wav->channels = getU16(hdr + 2);
+            wav->rate = getU32(hdr + 4);
+            if (wav->channels < 1 || wav->channels > 2) {
+                goto fail;
+            }
+            fmtFound = TRUE;
+            size -= 16;
+        }
+        else if (memcmp(hdr, "data", 4) == 0) {
+            if (!fmtFound) {
+                goto fail;
+            }
+            wav->dataOffset = ftell(wav->fp);
+            wav->frames = size / (2 * wav->channels);
+            return (TRUE);
+        }
+        if (fseek(wav->fp, (long)(size + (size & 1)), SEEK_CUR) != 0) {
+            goto fail;
+        }
+    }
+
+fail:
+    fclose(wav->fp);
+    wav->fp = NULL;
+    return (FALSE);
+}
+
+/*
+ *  ======== WAV_header ========
+ *  WAV_HEADERSIZE bytes of header of a stereo 16-bit file of 'frames'
+ *  sample frames.
+ */
+Void WAV_header(unsigned char *hdr, LgUns rate, LgUns frames)
+{
+    memset(hdr, 0, WAV_HEADERSIZE);
+    memcpy(hdr, "RIFF", 4);
+    putU32(hdr + 4, 36 + frames * 4);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    putU32(hdr + 16, 16);
+    putU16(hdr + 20, WAV_FMT_PCM);
+    putU16(hdr + 22, 2);
+    putU32(hdr + 24, rate);
+    putU32(hdr + 28, rate * 4);
+    putU16(hdr + 32, 4);
+    putU16(hdr + 34, 16);
+    memcpy(hdr + 36, "data", 4);
+    putU32(hdr + 40, frames * 4);
+}
+
+/*
+ *  ======== WAV_openWrite ========
+ *  Create a stereo 16-bit file.  The sizes in the header are patched by
+ *  WAV_close().
+ */
+Bool WAV_openWrite(WAV_Obj *wav, const char *path, LgUns rate)
+{
+    unsigned char hdr[WAV_HEADERSIZE];
+
+    memset(wav, 0, sizeof(*wav));
+    if ((wav->fp = fopen(path, "wb")) == NULL) {
+        return (FALSE);
+    }
+    wav->channels = 2;
+    wav->rate = rate;
+    wav->writing = TRUE;
+    wav->dataOffset = WAV_HEADERSIZE;
+
+    WAV_header(hdr, rate, 0);
+    return (fwrite(hdr, 1, sizeof(hdr), wav->fp) == sizeof(hdr));
+}
+
+/*
+ *  ======== WAV_read ========
+ *  Read up to 'frames' stereo frames, returns the number read.
+ */
+LgUns WAV_read(WAV_Obj *wav, Short *buf, LgUns frames)
+{
+    LgUns n, i;
+
+    if (frames > wav->frames - wav->pos) {
+        frames = wav->frames - wav->pos;
+    }
+    n = fread(buf, 2 * wav->channels, frames, wav->fp);
+    if (wav->channels == 1) {
+        for (i = n; i-- > 0; ) {
+            buf[2 * i + 1] = buf[2 * i] = buf[i];
+        }
+    }
+    wav->pos += n;
+
+    return (n);
+}
+
+/*
+ *  ======== WAV_write ========
+ */
+LgUns WAV_write(WAV_Obj *wav, const Short *buf, LgUns frames)
+{
+    LgUns n = fwrite(buf, 4, frames, wav->fp);
+
+    wav->pos += n;
+    wav->frames = wav->pos;
+
+    return (n);
+}
+
+/*
+ *  ======== WAV_rewind ========
+ */
+Bool WAV_rewind(WAV_Obj *wav)
+{
+    wav->pos = 0;
+    return (fseek(wav->fp, wav->dataOffset, SEEK_SET) == 0);
+}
+
+/*
+ *  ======== WAV_close ========
+ */
+Void WAV_close(WAV_Obj *wav)
+{
+    unsigned char size[4];
+
+    if (wav->fp == NULL) {
+        return;
+    }
+    if (wav->writing) {
+        putU32(size, 36 + wav->frames * 4);
+        fseek(wav->fp, 4, SEEK_SET);
+        fwrite(size, 1, 4, wav->fp);
+        putU32(size, wav->frames * 4);
+        fseek(wav->fp, 40, SEEK_SET);
+        fwrite(size, 1, 4, wav->fp);
+    }
+    fclose(wav->fp);
+    wav->fp = NULL;
+}
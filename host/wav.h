@@ -0,0 +1,33 @@
+/*
+ *  ======== wav.h ========
+ *  Minimal streaming reader/writer for 16-bit PCM WAV files.  Samples
+ *  are always exchanged as interleaved stereo, the layout used by the
+ *  codec: mono files are duplicated on both channels when read.
+ */
+#ifndef WAV_
+#define WAV_
+
+#include <stdio.h>
+#include <std.h>
+
+#define WAV_HEADERSIZE  44          /* of the files written */
+
+typedef struct WAV_Obj {
+    FILE        *fp;
+    Int         channels;       /* channels in the file (1 or 2) */
+    LgUns       rate;           /* sampling frequency in Hz */
+    LgUns       frames;         /* sample frames in the data chunk */
+    LgUns       pos;            /* frames read or written so far */
+    long        dataOffset;     /* file offset of the first sample */
+    Bool        writing;
+} WAV_Obj;
+
+extern Void WAV_header(unsigned char *hdr, LgUns rate, LgUns frames);
+extern Bool WAV_openRead(WAV_Obj *wav, const char *path);
+extern Bool WAV_openWrite(WAV_Obj *wav, const char *path, LgUns rate);
+extern LgUns WAV_read(WAV_Obj *wav, Short *buf, LgUns frames);
+extern LgUns WAV_write(WAV_Obj *wav, const Short *buf, LgUns frames);
+extern Bool WAV_rewind(WAV_Obj *wav);
+extern Void WAV_close(WAV_Obj *wav);
+
+#endif /* WAV_ */